@@ -0,0 +1,280 @@
+/**
+ * alloc_trace.h -- Binary allocation trace recorder for Stack Allocators
+ *
+ * Project URL: https://github.com/gilzoide/c-allocators
+ *
+ * Do this:
+ *    #define ALLOC_TRACE_IMPLEMENTATION
+ * before you include this file in *one* C or C++ file to create the implementation.
+ *
+ * Include this file before stack_allocator.h and double_stack_allocator.h
+ * in the files that create their implementations, so that their allocation
+ * and free operations are recorded.
+ *
+ * i.e.:
+ *   #include ...
+ *   #include ...
+ *   #define ALLOC_TRACE_IMPLEMENTATION
+ *   #include "alloc_trace.h"
+ *   #define STACK_ALLOCATOR_IMPLEMENTATION
+ *   #include "stack_allocator.h"
+ *
+ * Records are buffered per thread without any locking and appended to the
+ * trace file whenever a thread's buffer fills up, #at_flush is called, the
+ * thread exits or the process exits. Buffers are written whole under a lock,
+ * so records from different threads never interleave.
+ * Use tools/alloc_trace_analyze to read trace files.
+ * POSIX only.
+ *
+ * Optionally provide the following defines with your own implementations:
+ *
+ * AT_BUFFER_RECORDS  - number of records buffered per thread (default: 4096)
+ * AT_CALLSITE        - if defined, records the return address of traced functions
+ * AT_STATIC          - if defined and AT_DECL is not defined, functions will be declared `static` instead of `extern`
+ * AT_DECL            - function declaration prefix (default: `extern` or `static` depending on AT_STATIC)
+ */
+#ifndef ALLOC_TRACE_H
+#define ALLOC_TRACE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef AT_DECL
+    #ifdef AT_STATIC
+        #define AT_DECL static
+    #else
+        #define AT_DECL extern
+    #endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Traced operations.
+typedef enum at_op {
+    AT_SA_ALLOC,
+    AT_SA_ALLOC_FAILED,
+    AT_SA_POP,
+    AT_SA_CLEAR_MARKER,
+    AT_SA_RELEASE,
+    AT_DSA_ALLOC_BOTTOM,
+    AT_DSA_ALLOC_TOP,
+    AT_DSA_ALLOC_BOTTOM_FAILED,
+    AT_DSA_ALLOC_TOP_FAILED,
+    AT_DSA_POP_BOTTOM,
+    AT_DSA_POP_TOP,
+    AT_DSA_CLEAR_BOTTOM_MARKER,
+    AT_DSA_CLEAR_TOP_MARKER,
+    AT_DSA_RELEASE,
+} at_op;
+
+/// Trace file header, followed by any number of #at_record.
+typedef struct at_file_header {
+    char magic[8];               ///< "SATRACE" followed by a null byte.
+    uint32_t version;            ///< Trace format version, currently 2.
+    uint32_t record_size;        ///< Size of each record.
+    uint64_t ticks_per_second;   ///< Estimated frequency of record timestamps.
+} at_file_header;
+
+/// A single traced operation.
+typedef struct at_record {
+    uint64_t timestamp;  ///< Time stamp counter value when the operation finished.
+    uint64_t allocator;  ///< Address of the allocator.
+    uint64_t size;       ///< Bytes requested or freed.
+    uint64_t marker;     ///< Memory used on the affected end after the operation.
+    uint64_t callsite;   ///< Return address of the traced function, 0 unless AT_CALLSITE is defined.
+    uint32_t op;         ///< Traced operation, one of #at_op.
+    uint32_t thread;     ///< Sequential identifier of the recording thread.
+} at_record;
+
+#define AT_MAGIC "SATRACE"
+#define AT_VERSION 2
+
+/// Start recording to a trace file, truncating it.
+///
+/// A trace file that was already open is closed first, like #at_close does.
+///
+/// @return Non-zero if file was opened successfully.
+/// @return 0 otherwise.
+AT_DECL int at_open(const char *path);
+
+/// Append a record to the current thread's buffer.
+///
+/// Does nothing if no trace file is open.
+AT_DECL void at_record_op(at_op op, const void *allocator, size_t size, size_t marker, const void *callsite);
+
+/// Write records buffered by the current thread to the trace file.
+AT_DECL void at_flush(void);
+
+/// Flush the current thread's records and stop recording.
+///
+/// Records buffered by other threads that haven't been flushed are lost.
+AT_DECL void at_close(void);
+
+#ifdef AT_CALLSITE
+    #define AT_CALLSITE_ADDRESS __builtin_return_address(0)
+#else
+    #define AT_CALLSITE_ADDRESS NULL
+#endif
+
+#define SA_TRACE(event, memory, size, marker) \
+    at_record_op(AT_##event, (memory), (size), (marker), AT_CALLSITE_ADDRESS)
+#define DSA_TRACE(event, memory, size, used) \
+    at_record_op(AT_##event, (memory), (size), (used), AT_CALLSITE_ADDRESS)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ALLOC_TRACE_H
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef ALLOC_TRACE_IMPLEMENTATION
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define AT_TIMESTAMP() ((uint64_t) __rdtsc())
+#else
+    #define AT_TIMESTAMP() at__nanoseconds()
+#endif
+
+#ifndef AT_BUFFER_RECORDS
+    #define AT_BUFFER_RECORDS 4096
+#endif
+
+typedef struct at__thread_buffer {
+    uint32_t thread;
+    size_t count;
+    at_record records[AT_BUFFER_RECORDS];
+} at__thread_buffer;
+
+static int at__fd = -1;
+static pthread_mutex_t at__write_lock = PTHREAD_MUTEX_INITIALIZER;
+static uint32_t at__next_thread;
+static pthread_key_t at__key;
+static pthread_once_t at__key_once = PTHREAD_ONCE_INIT;
+static __thread at__thread_buffer *at__buffer;
+
+static uint64_t at__nanoseconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+static uint64_t at__ticks_per_second(void) {
+    uint64_t start_ns = at__nanoseconds();
+    uint64_t start = AT_TIMESTAMP();
+    while(at__nanoseconds() - start_ns < 10000000u);
+    uint64_t ticks = AT_TIMESTAMP() - start;
+    uint64_t elapsed_ns = at__nanoseconds() - start_ns;
+    return ticks * 1000000000u / elapsed_ns;
+}
+
+static void at__write_buffer(at__thread_buffer *buffer) {
+    if(buffer->count == 0) return;
+    // Short writes are retried, so the lock keeps other threads from writing between them
+    pthread_mutex_lock(&at__write_lock);
+    int fd = __atomic_load_n(&at__fd, __ATOMIC_ACQUIRE);
+    if(fd >= 0) {
+        const uint8_t *bytes = (const uint8_t *) buffer->records;
+        size_t size = buffer->count * sizeof(at_record);
+        while(size > 0) {
+            ssize_t written = write(fd, bytes, size);
+            if(written < 0) {
+                if(errno == EINTR) continue;
+                break;
+            }
+            bytes += written;
+            size -= written;
+        }
+    }
+    pthread_mutex_unlock(&at__write_lock);
+    buffer->count = 0;
+}
+
+static void at__thread_exit(void *buffer) {
+    at__write_buffer((at__thread_buffer *) buffer);
+    free(buffer);
+    at__buffer = NULL;
+}
+
+// Thread exit destructors don't run for the thread that exits the process
+static void at__process_exit(void) {
+    at_flush();
+}
+
+static void at__create_key(void) {
+    pthread_key_create(&at__key, at__thread_exit);
+    atexit(at__process_exit);
+}
+
+AT_DECL int at_open(const char *path) {
+    pthread_once(&at__key_once, at__create_key);
+    at_close();
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if(fd < 0) return 0;
+    at_file_header header = {};
+    memcpy(header.magic, AT_MAGIC, sizeof(AT_MAGIC));
+    header.version = AT_VERSION;
+    header.record_size = sizeof(at_record);
+    header.ticks_per_second = at__ticks_per_second();
+    if(write(fd, &header, sizeof(header)) != sizeof(header)) {
+        close(fd);
+        return 0;
+    }
+    __atomic_store_n(&at__fd, fd, __ATOMIC_RELEASE);
+    return 1;
+}
+
+AT_DECL void at_record_op(at_op op, const void *allocator, size_t size, size_t marker, const void *callsite) {
+    if(__atomic_load_n(&at__fd, __ATOMIC_RELAXED) < 0) return;
+    at__thread_buffer *buffer = at__buffer;
+    if(buffer == NULL) {
+        buffer = (at__thread_buffer *) malloc(sizeof(at__thread_buffer));
+        if(buffer == NULL) return;
+        buffer->thread = __atomic_fetch_add(&at__next_thread, 1, __ATOMIC_RELAXED);
+        buffer->count = 0;
+        at__buffer = buffer;
+        pthread_setspecific(at__key, buffer);
+    }
+    at_record *record = &buffer->records[buffer->count];
+    record->timestamp = AT_TIMESTAMP();
+    record->allocator = (uintptr_t) allocator;
+    record->size = size;
+    record->marker = marker;
+    record->callsite = (uintptr_t) callsite;
+    record->op = op;
+    record->thread = buffer->thread;
+    if(++buffer->count == AT_BUFFER_RECORDS) {
+        at__write_buffer(buffer);
+    }
+}
+
+AT_DECL void at_flush(void) {
+    if(at__buffer != NULL) {
+        at__write_buffer(at__buffer);
+    }
+}
+
+AT_DECL void at_close(void) {
+    at_flush();
+    // Locked so that no other thread is writing to the file while it's closed
+    pthread_mutex_lock(&at__write_lock);
+    int fd = __atomic_exchange_n(&at__fd, -1, __ATOMIC_ACQ_REL);
+    if(fd >= 0) {
+        close(fd);
+    }
+    pthread_mutex_unlock(&at__write_lock);
+}
+
+#endif  // ALLOC_TRACE_IMPLEMENTATION
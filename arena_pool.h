@@ -0,0 +1,224 @@
+/**
+ * arena_pool.h -- Thread-safe pool of reusable Stack Allocators
+ *
+ * Project URL: https://github.com/gilzoide/c-allocators
+ *
+ * Do this:
+ *    #define ARENA_POOL_IMPLEMENTATION
+ * before you include this file in *one* C or C++ file to create the implementation.
+ *
+ * i.e.:
+ *   #include ...
+ *   #include ...
+ *   #define ARENA_POOL_IMPLEMENTATION
+ *   #include "arena_pool.h"
+ *
+ * This file uses stack_allocator.h, whose implementation must also be
+ * created in some C or C++ file.
+ * Atomic operations use the GCC/Clang `__atomic` builtins.
+ *
+ * Optionally provide the following defines with your own implementations:
+ *
+ * SA_POOL_MALLOC(size)     - your own malloc function (default: malloc(size))
+ * SA_POOL_FREE(p)          - your own free function (default: free(p))
+ * SA_POOL_SHRINK_INTERVAL  - number of returns between checks for oversized allocators (default: 64)
+ * SA_POOL_CACHE_LINE       - cache line size, used for padding pooled allocators (default: 64)
+ * SA_POOL_STATIC           - if defined and SA_POOL_DECL is not defined, functions will be declared `static` instead of `extern`
+ * SA_POOL_DECL             - function declaration prefix (default: `extern` or `static` depending on SA_POOL_STATIC)
+ */
+#ifndef ARENA_POOL_H
+#define ARENA_POOL_H
+
+#include "stack_allocator.h"
+
+#ifndef SA_POOL_DECL
+    #ifdef SA_POOL_STATIC
+        #define SA_POOL_DECL static
+    #else
+        #define SA_POOL_DECL extern
+    #endif
+#endif
+
+#ifndef SA_POOL_CACHE_LINE
+    #define SA_POOL_CACHE_LINE 64
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// A pooled Stack Allocator and its usage history.
+typedef struct sa_arena_pool_slot {
+    sa_stack_allocator arena;  ///< Pooled allocator, handed out by #sa_pool_checkout.
+    size_t peak;               ///< Highest memory usage ever seen on return.
+    size_t high_water;         ///< Highest memory usage seen on return since last shrink check.
+    size_t returns;            ///< Number of returns since last shrink check.
+    int in_use;                ///< Non-zero while checked out.
+} sa_arena_pool_slot;
+
+/// A bounded pool of pre-initialized Stack Allocators.
+///
+/// Checking out and returning allocators is thread-safe and lock-free.
+/// When every pooled allocator is checked out, new ones are allocated
+/// with SA_POOL_MALLOC and released when returned.
+typedef struct sa_arena_pool {
+    void *memory;              ///< Memory block holding the slots.
+    sa_arena_pool_slot *slots; ///< Pooled allocators, spaced SA_POOL_CACHE_LINE aligned.
+    size_t size;               ///< Number of pooled allocators.
+    size_t arena_capacity;     ///< Capacity of pooled allocators, which are never shrunk below it.
+    size_t next;               ///< Index where the next checkout starts searching.
+} sa_arena_pool;
+
+/// Initializes an Arena Pool with `size` allocators of `arena_capacity` bytes.
+///
+/// @return Non-zero if memory was allocated successfully.
+/// @return 0 otherwise, in which case nothing stays allocated.
+SA_POOL_DECL int sa_pool_init(sa_arena_pool *pool, size_t size, size_t arena_capacity);
+
+/// Release all memory associated with an Arena Pool.
+///
+/// All allocators must have been returned before calling this.
+SA_POOL_DECL void sa_pool_release(sa_arena_pool *pool);
+
+/// Get an empty Stack Allocator with at least the pool's arena capacity.
+///
+/// @return Allocator on success, to be given back with #sa_pool_return.
+/// @return NULL if a new allocator was needed and memory allocation failed.
+SA_POOL_DECL sa_stack_allocator *sa_pool_checkout(sa_arena_pool *pool);
+
+/// Get an empty Stack Allocator with at least `capacity` bytes.
+///
+/// Pooled allocators smaller than `capacity` are grown, and shrunk back
+/// later if their usage stays below half their capacity.
+///
+/// @return Allocator on success, to be given back with #sa_pool_return.
+/// @return NULL if memory allocation failed.
+SA_POOL_DECL sa_stack_allocator *sa_pool_checkout_with_capacity(sa_arena_pool *pool, size_t capacity);
+
+/// Give an allocator back to the pool, clearing it.
+///
+/// Its memory usage is recorded for shrinking oversized allocators.
+SA_POOL_DECL void sa_pool_return(sa_arena_pool *pool, sa_stack_allocator *arena);
+
+/// Get the slot of the `index`-th pooled allocator.
+SA_POOL_DECL sa_arena_pool_slot *sa_pool_slot(sa_arena_pool *pool, size_t index);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ARENA_POOL_H
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef ARENA_POOL_IMPLEMENTATION
+
+#include <stdint.h>
+
+#ifndef SA_POOL_MALLOC
+    #define SA_POOL_MALLOC(size) malloc(size)
+#endif
+#ifndef SA_POOL_FREE
+    #define SA_POOL_FREE(p) free(p)
+#endif
+#ifndef SA_POOL_SHRINK_INTERVAL
+    #define SA_POOL_SHRINK_INTERVAL 64
+#endif
+
+#define SA_POOL_SLOT_STRIDE \
+    ((sizeof(sa_arena_pool_slot) + SA_POOL_CACHE_LINE - 1) / SA_POOL_CACHE_LINE * SA_POOL_CACHE_LINE)
+
+SA_POOL_DECL sa_arena_pool_slot *sa_pool_slot(sa_arena_pool *pool, size_t index) {
+    return (sa_arena_pool_slot *) (((uint8_t *) pool->slots) + index * SA_POOL_SLOT_STRIDE);
+}
+
+SA_POOL_DECL int sa_pool_init(sa_arena_pool *pool, size_t size, size_t arena_capacity) {
+    pool->memory = SA_POOL_MALLOC(size * SA_POOL_SLOT_STRIDE + SA_POOL_CACHE_LINE - 1);
+    if(pool->memory == NULL) return 0;
+    uintptr_t address = (uintptr_t) pool->memory;
+    pool->slots = (sa_arena_pool_slot *) ((address + SA_POOL_CACHE_LINE - 1) & ~((uintptr_t) SA_POOL_CACHE_LINE - 1));
+    pool->size = size;
+    pool->arena_capacity = arena_capacity;
+    pool->next = 0;
+    for(size_t i = 0; i < size; i++) {
+        sa_arena_pool_slot *slot = sa_pool_slot(pool, i);
+        *slot = (sa_arena_pool_slot){};
+        if(!sa_init_with_capacity(&slot->arena, arena_capacity)) {
+            pool->size = i;
+            sa_pool_release(pool);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+SA_POOL_DECL void sa_pool_release(sa_arena_pool *pool) {
+    for(size_t i = 0; i < pool->size; i++) {
+        sa_release(&sa_pool_slot(pool, i)->arena);
+    }
+    SA_POOL_FREE(pool->memory);
+    *pool = (sa_arena_pool){};
+}
+
+SA_POOL_DECL sa_stack_allocator *sa_pool_checkout(sa_arena_pool *pool) {
+    return sa_pool_checkout_with_capacity(pool, pool->arena_capacity);
+}
+
+// Replace an allocator's buffer by a new one with `capacity` bytes.
+static int sa__pool_resize(sa_stack_allocator *arena, size_t capacity) {
+    sa_release(arena);
+    return sa_init_with_capacity(arena, capacity);
+}
+
+SA_POOL_DECL sa_stack_allocator *sa_pool_checkout_with_capacity(sa_arena_pool *pool, size_t capacity) {
+    size_t start = __atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED);
+    for(size_t i = 0; i < pool->size; i++) {
+        sa_arena_pool_slot *slot = sa_pool_slot(pool, (start + i) % pool->size);
+        int expected = 0;
+        if(__atomic_load_n(&slot->in_use, __ATOMIC_RELAXED) == 0
+           && __atomic_compare_exchange_n(&slot->in_use, &expected, 1, 0, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            if(slot->arena.capacity < capacity && !sa__pool_resize(&slot->arena, capacity)) {
+                sa_init_with_capacity(&slot->arena, pool->arena_capacity);
+                __atomic_store_n(&slot->in_use, 0, __ATOMIC_RELEASE);
+                return NULL;
+            }
+            return &slot->arena;
+        }
+    }
+
+    // Every pooled allocator is in use: allocate a standalone one.
+    sa_stack_allocator *arena = (sa_stack_allocator *) SA_POOL_MALLOC(sizeof(sa_stack_allocator));
+    if(arena == NULL) return NULL;
+    if(!sa_init_with_capacity(arena, capacity)) {
+        SA_POOL_FREE(arena);
+        return NULL;
+    }
+    return arena;
+}
+
+SA_POOL_DECL void sa_pool_return(sa_arena_pool *pool, sa_stack_allocator *arena) {
+    uint8_t *slots_begin = (uint8_t *) pool->slots;
+    uint8_t *slots_end = slots_begin + pool->size * SA_POOL_SLOT_STRIDE;
+    if((uint8_t *) arena < slots_begin || (uint8_t *) arena >= slots_end) {
+        sa_release(arena);
+        SA_POOL_FREE(arena);
+        return;
+    }
+
+    sa_arena_pool_slot *slot = (sa_arena_pool_slot *) arena;
+    size_t used = sa_used_memory(arena);
+    sa_clear(arena);
+    if(used > slot->peak) slot->peak = used;
+    if(used > slot->high_water) slot->high_water = used;
+    if(++slot->returns >= SA_POOL_SHRINK_INTERVAL) {
+        size_t capacity = slot->high_water > pool->arena_capacity ? slot->high_water : pool->arena_capacity;
+        if(arena->capacity / 2 >= capacity && !sa__pool_resize(arena, capacity)) {
+            sa_init_with_capacity(arena, pool->arena_capacity);
+        }
+        slot->high_water = 0;
+        slot->returns = 0;
+    }
+    __atomic_store_n(&slot->in_use, 0, __ATOMIC_RELEASE);
+}
+
+#endif  // ARENA_POOL_IMPLEMENTATION
@@ -0,0 +1,211 @@
+/**
+ * bench.h -- Minimal dependency-free benchmark harness
+ *
+ * Each benchmark is a function performing a batch of operations, which is
+ * run a few times for warmup and then timed for a number of repetitions.
+ * Reports median and 99th percentile nanoseconds per operation, plus
+ * operations per second based on the median.
+ * When available, hardware performance counters (see perf_counters.h) are
+ * read around the timed repetitions and reported per operation.
+ *
+ * Command line options understood by #bench_init:
+ *
+ *   --format table|csv|json  output format (default: table)
+ *   --repetitions N          timed repetitions per benchmark (default: 50)
+ *   --warmup N               untimed repetitions per benchmark (default: 5)
+ *   --filter TEXT            only run benchmarks whose name contains TEXT
+ *   --no-counters            don't read hardware performance counters
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "perf_counters.h"
+
+/// Benchmark body, performing `ops` operations.
+typedef void (*bench_fn)(void *ctx, size_t ops);
+
+typedef struct bench_result {
+    const char *name;
+    size_t ops;
+    double median_ns;  ///< Median nanoseconds per operation.
+    double p99_ns;     ///< 99th percentile nanoseconds per operation.
+    double ops_per_second;
+    double counters[PERF_COUNTER_COUNT];  ///< Hardware counters per operation, -1 if unavailable.
+} bench_result;
+
+enum bench_format { BENCH_TABLE, BENCH_CSV, BENCH_JSON };
+
+static struct {
+    enum bench_format format;
+    size_t repetitions;
+    size_t warmup;
+    const char *filter;
+    int use_counters;
+    perf_counters counters;
+    bench_result *results;
+    size_t result_count;
+} bench_config = { .format = BENCH_TABLE, .repetitions = 50, .warmup = 5, .use_counters = 1 };
+
+/// Keep the compiler from optimizing away computations leading to `ptr`.
+static inline void bench_do_not_optimize(const void *ptr) {
+    __asm__ volatile("" : : "g"(ptr) : "memory");
+}
+
+static inline uint64_t bench_now_ns(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000u + now.tv_nsec;
+}
+
+static inline int bench_compare_double(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static inline void bench_init(int argc, char **argv) {
+    // Counters stay unavailable unless opened, so no file descriptor is mistaken for one
+    perf_counters_init(&bench_config.counters);
+    for(int i = 1; i < argc; i++) {
+        const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+        if(strcmp(argv[i], "--format") == 0 && value) {
+            bench_config.format = strcmp(value, "csv") == 0 ? BENCH_CSV
+                                : strcmp(value, "json") == 0 ? BENCH_JSON
+                                : BENCH_TABLE;
+            i++;
+        }
+        else if(strcmp(argv[i], "--repetitions") == 0 && value) {
+            bench_config.repetitions = strtoul(value, NULL, 10);
+            if(bench_config.repetitions == 0) bench_config.repetitions = 1;
+            i++;
+        }
+        else if(strcmp(argv[i], "--warmup") == 0 && value) {
+            bench_config.warmup = strtoul(value, NULL, 10);
+            i++;
+        }
+        else if(strcmp(argv[i], "--filter") == 0 && value) {
+            bench_config.filter = value;
+            i++;
+        }
+        else if(strcmp(argv[i], "--no-counters") == 0) {
+            bench_config.use_counters = 0;
+        }
+        else {
+            fprintf(stderr, "Usage: %s [--format table|csv|json] [--repetitions N] [--warmup N] [--filter TEXT] [--no-counters]\n", argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
+    if(bench_config.use_counters && perf_counters_open(&bench_config.counters) == 0) {
+        fprintf(stderr, "Hardware performance counters unavailable\n");
+    }
+    if(bench_config.format == BENCH_TABLE) {
+        printf("%-40s %12s %12s %16s", "benchmark", "median ns/op", "p99 ns/op", "ops/s");
+        if(bench_config.counters.available) {
+            printf(" %10s %6s %10s %10s %10s %10s", "cycles/op", "IPC", "L1D/op", "LLC/op", "dTLB/op", "brmiss/op");
+        }
+        printf("\n");
+    }
+}
+
+// Print a per operation counter value in table format, "-" if unavailable.
+static inline void bench_print_counter(double value, int width) {
+    if(value < 0) printf(" %*s", width, "-");
+    else printf(" %*.*f", width, value < 10 ? 3 : 1, value);
+}
+
+/// Run and report a benchmark, calling `fn` with `ops` for each repetition.
+static inline void bench_run(const char *name, bench_fn fn, void *ctx, size_t ops) {
+    if(bench_config.filter && strstr(name, bench_config.filter) == NULL) return;
+
+    for(size_t i = 0; i < bench_config.warmup; i++) {
+        fn(ctx, ops);
+    }
+    double *samples = (double *) malloc(bench_config.repetitions * sizeof(double));
+    perf_counters_start(&bench_config.counters);
+    for(size_t i = 0; i < bench_config.repetitions; i++) {
+        uint64_t start = bench_now_ns();
+        fn(ctx, ops);
+        samples[i] = (double) (bench_now_ns() - start) / ops;
+    }
+    perf_counters_stop(&bench_config.counters);
+    qsort(samples, bench_config.repetitions, sizeof(double), bench_compare_double);
+
+    bench_result result;
+    result.name = name;
+    result.ops = ops;
+    result.median_ns = samples[bench_config.repetitions / 2];
+    result.p99_ns = samples[(bench_config.repetitions * 99) / 100];
+    result.ops_per_second = 1e9 / result.median_ns;
+    for(int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        result.counters[i] = perf_counter_available(&bench_config.counters, (enum perf_counter_id) i)
+                           ? (double) bench_config.counters.values[i] / (ops * bench_config.repetitions)
+                           : -1;
+    }
+    free(samples);
+
+    bench_config.results = (bench_result *) realloc(bench_config.results, (bench_config.result_count + 1) * sizeof(bench_result));
+    bench_config.results[bench_config.result_count++] = result;
+    if(bench_config.format == BENCH_TABLE) {
+        printf("%-40s %12.2f %12.2f %16.0f", name, result.median_ns, result.p99_ns, result.ops_per_second);
+        if(bench_config.counters.available) {
+            const double *counters = result.counters;
+            bench_print_counter(counters[PERF_CYCLES], 10);
+            bench_print_counter(counters[PERF_CYCLES] > 0 && counters[PERF_INSTRUCTIONS] >= 0
+                                ? counters[PERF_INSTRUCTIONS] / counters[PERF_CYCLES] : -1, 6);
+            bench_print_counter(counters[PERF_L1D_MISSES], 10);
+            bench_print_counter(counters[PERF_LLC_MISSES], 10);
+            bench_print_counter(counters[PERF_DTLB_MISSES], 10);
+            bench_print_counter(counters[PERF_BRANCH_MISSES], 10);
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+}
+
+/// Print results in CSV or JSON formats and free them.
+///
+/// @return Exit status for `main`.
+static inline int bench_finish(void) {
+    if(bench_config.format == BENCH_CSV) {
+        printf("benchmark,ops,median_ns,p99_ns,ops_per_second");
+        for(int j = 0; j < PERF_COUNTER_COUNT; j++) {
+            printf(",%s_per_op", perf_counter_names[j]);
+        }
+        printf("\n");
+        for(size_t i = 0; i < bench_config.result_count; i++) {
+            bench_result *r = &bench_config.results[i];
+            printf("%s,%zu,%.3f,%.3f,%.0f", r->name, r->ops, r->median_ns, r->p99_ns, r->ops_per_second);
+            for(int j = 0; j < PERF_COUNTER_COUNT; j++) {
+                if(r->counters[j] >= 0) printf(",%.4f", r->counters[j]);
+                else printf(",");
+            }
+            printf("\n");
+        }
+    }
+    else if(bench_config.format == BENCH_JSON) {
+        printf("[\n");
+        for(size_t i = 0; i < bench_config.result_count; i++) {
+            bench_result *r = &bench_config.results[i];
+            printf("  {\"benchmark\": \"%s\", \"ops\": %zu, \"median_ns\": %.3f, \"p99_ns\": %.3f, \"ops_per_second\": %.0f",
+                   r->name, r->ops, r->median_ns, r->p99_ns, r->ops_per_second);
+            for(int j = 0; j < PERF_COUNTER_COUNT; j++) {
+                if(r->counters[j] >= 0) printf(", \"%s_per_op\": %.4f", perf_counter_names[j], r->counters[j]);
+                else printf(", \"%s_per_op\": null", perf_counter_names[j]);
+            }
+            printf("}%s\n", i + 1 < bench_config.result_count ? "," : "");
+        }
+        printf("]\n");
+    }
+    perf_counters_close(&bench_config.counters);
+    free(bench_config.results);
+    bench_config.results = NULL;
+    bench_config.result_count = 0;
+    return EXIT_SUCCESS;
+}
+
+#endif  // BENCH_H
@@ -0,0 +1,80 @@
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define ARENA_POOL_IMPLEMENTATION
+#include "arena_pool.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define ARENA_CAPACITY (256 * 1024)
+
+static sa_arena_pool pool;
+static long requests_per_thread;
+
+// Synthetic request: a few dozen allocations of mixed sizes, all touched.
+static uint64_t handle_request(sa_stack_allocator *arena, uint64_t seed) {
+    uint64_t checksum = 0;
+    for(int i = 0; i < 48; i++) {
+        seed = seed * 6364136223846793005u + 1442695040888963407u;
+        size_t size = 16 + (seed >> 33) % 2048;
+        uint8_t *block = sa_alloc(arena, size);
+        if(block == NULL) break;
+        memset(block, (int) i, size);
+        checksum += block[size / 2];
+    }
+    return checksum;
+}
+
+static void *run_malloc(void *arg) {
+    uint64_t checksum = 0;
+    for(long i = 0; i < requests_per_thread; i++) {
+        sa_stack_allocator arena;
+        sa_init_with_capacity(&arena, ARENA_CAPACITY);
+        checksum += handle_request(&arena, i);
+        sa_release(&arena);
+    }
+    return (void *) (uintptr_t) checksum;
+}
+
+static void *run_pool(void *arg) {
+    uint64_t checksum = 0;
+    for(long i = 0; i < requests_per_thread; i++) {
+        sa_stack_allocator *arena = sa_pool_checkout(&pool);
+        checksum += handle_request(arena, i);
+        sa_pool_return(&pool, arena);
+    }
+    return (void *) (uintptr_t) checksum;
+}
+
+static double requests_per_second(void *(*run)(void *), int thread_count) {
+    pthread_t threads[thread_count];
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i = 0; i < thread_count; i++) {
+        pthread_create(&threads[i], NULL, run, NULL);
+    }
+    for(int i = 0; i < thread_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+    return requests_per_thread * thread_count / elapsed;
+}
+
+int main(int argc, char **argv) {
+    int max_threads = argc > 1 ? atoi(argv[1]) : 4;
+    requests_per_thread = argc > 2 ? atol(argv[2]) : 200000;
+
+    printf("%-8s %16s %16s\n", "threads", "init/release/s", "pool/s");
+    for(int thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+        sa_pool_init(&pool, thread_count, ARENA_CAPACITY);
+        printf("%-8d %16.0f %16.0f\n", thread_count,
+               requests_per_second(run_malloc, thread_count),
+               requests_per_second(run_pool, thread_count));
+        sa_pool_release(&pool);
+    }
+    return 0;
+}
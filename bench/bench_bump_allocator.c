@@ -0,0 +1,120 @@
+// Compares the buffer/capacity/marker layout of sa_stack_allocator against
+// the pointer based upwards and downwards Bump Allocators.
+// Everything is inlined, so that only the allocation fast paths differ.
+#define SA_INLINE
+#include "stack_allocator.h"
+#define BA_INLINE
+#include "bump_allocator.h"
+
+#include "bench.h"
+
+#define OPS 4096
+#define MAX_SIZE 256
+
+typedef struct context {
+    sa_stack_allocator stack;
+    ba_bump_allocator up;
+    ba_down_allocator down;
+    size_t sizes[OPS];
+} context;
+
+static void sa_alloc_fixed(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(sa_alloc(&c->stack, 16));
+    }
+    sa_clear(&c->stack);
+}
+
+static void ba_alloc_fixed(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(ba_alloc(&c->up, 16));
+    }
+    ba_clear(&c->up);
+}
+
+static void ba_down_alloc_fixed(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(ba_down_alloc(&c->down, 16));
+    }
+    ba_down_clear(&c->down);
+}
+
+static void sa_alloc_random(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(sa_alloc(&c->stack, c->sizes[i]));
+    }
+    sa_clear(&c->stack);
+}
+
+static void ba_alloc_random(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(ba_alloc(&c->up, c->sizes[i]));
+    }
+    ba_clear(&c->up);
+}
+
+static void ba_down_alloc_random(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(ba_down_alloc(&c->down, c->sizes[i]));
+    }
+    ba_down_clear(&c->down);
+}
+
+static void sa_alloc_aligned_random(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(sa_alloc_aligned(&c->stack, c->sizes[i], 16));
+    }
+    sa_clear(&c->stack);
+}
+
+static void ba_alloc_aligned_random(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(ba_alloc_aligned(&c->up, c->sizes[i], 16));
+    }
+    ba_clear(&c->up);
+}
+
+static void ba_down_alloc_aligned_random(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(ba_down_alloc_aligned(&c->down, c->sizes[i], 16));
+    }
+    ba_down_clear(&c->down);
+}
+
+int main(int argc, char **argv) {
+    bench_init(argc, argv);
+
+    static context c;
+    size_t capacity = OPS * (MAX_SIZE + 16);
+    sa_init_with_capacity(&c.stack, capacity);
+    ba_init_with_capacity(&c.up, capacity);
+    ba_down_init_with_capacity(&c.down, capacity);
+    srand(42);
+    for(size_t i = 0; i < OPS; i++) {
+        c.sizes[i] = 1 + rand() % MAX_SIZE;
+    }
+
+    bench_run("sa_alloc/fixed16", sa_alloc_fixed, &c, OPS);
+    bench_run("ba_alloc/fixed16", ba_alloc_fixed, &c, OPS);
+    bench_run("ba_down_alloc/fixed16", ba_down_alloc_fixed, &c, OPS);
+    bench_run("sa_alloc/random", sa_alloc_random, &c, OPS);
+    bench_run("ba_alloc/random", ba_alloc_random, &c, OPS);
+    bench_run("ba_down_alloc/random", ba_down_alloc_random, &c, OPS);
+    bench_run("sa_alloc_aligned/random", sa_alloc_aligned_random, &c, OPS);
+    bench_run("ba_alloc_aligned/random", ba_alloc_aligned_random, &c, OPS);
+    bench_run("ba_down_alloc_aligned/random", ba_down_alloc_aligned_random, &c, OPS);
+
+    sa_release(&c.stack);
+    ba_release(&c.up);
+    ba_down_release(&c.down);
+    return bench_finish();
+}
@@ -0,0 +1,112 @@
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define COROUTINE_FRAME_ALLOCATOR_IMPLEMENTATION
+#include "coroutine_frame_allocator.hpp"
+
+#include <chrono>
+#include <coroutine>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <vector>
+
+struct default_frames {};
+
+// Lazily started task that resumes its awaiter when done.
+template<typename Base>
+struct task {
+    struct promise_type : Base {
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+        long value = 0;
+
+        task get_return_object() { return task{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        auto final_suspend() noexcept {
+            struct awaiter {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> h) noexcept {
+                    return h.promise().continuation;
+                }
+                void await_resume() noexcept {}
+            };
+            return awaiter{};
+        }
+        void return_value(long v) { value = v; }
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    task(task&& other) : handle(other.handle) { other.handle = nullptr; }
+    explicit task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    ~task() { if(handle) handle.destroy(); }
+
+    bool await_ready() noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) noexcept {
+        handle.promise().continuation = awaiter;
+        return handle;
+    }
+    long await_resume() noexcept { return handle.promise().value; }
+
+    long run() {
+        handle.resume();
+        return handle.promise().value;
+    }
+};
+
+template<typename Base>
+task<Base> pong(long i) {
+    co_return i & 1;
+}
+
+// Each round creates and destroys a `pong` frame: LIFO frame lifetimes.
+template<typename Base>
+task<Base> ping(long rounds) {
+    long total = 0;
+    for(long i = 0; i < rounds; i++) {
+        total += co_await pong<Base>(i);
+    }
+    co_return total;
+}
+
+template<typename Base>
+double ping_pong(long rounds) {
+    auto start = std::chrono::steady_clock::now();
+    long total = ping<Base>(rounds).run();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if(total != rounds / 2) std::abort();
+    return (rounds + 1) / elapsed.count();
+}
+
+// Frames are created in batches and destroyed oldest first: out of order
+// frame lifetimes.
+template<typename Base>
+double fifo(long rounds, std::size_t batch) {
+    std::vector<task<Base>> tasks;
+    tasks.reserve(batch);
+    long total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for(long i = 0; i < rounds; i += batch) {
+        for(std::size_t j = 0; j < batch; j++) {
+            tasks.push_back(pong<Base>(j));
+        }
+        for(auto& t : tasks) {
+            total += t.run();
+        }
+        tasks.clear();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if(total != rounds / 2) std::abort();
+    return rounds / elapsed.count();
+}
+
+int main(int argc, char **argv) {
+    long rounds = argc > 1 ? std::atol(argv[1]) : 10000000;
+
+    std::printf("%-24s %16s %16s\n", "workload", "default frames/s", "stack frames/s");
+    std::printf("%-24s %16.0f %16.0f\n", "ping-pong",
+                ping_pong<default_frames>(rounds), ping_pong<sa::coroutine_frame_promise>(rounds));
+    std::printf("%-24s %16.0f %16.0f\n", "fifo-batch-64",
+                fifo<default_frames>(rounds, 64), fifo<sa::coroutine_frame_promise>(rounds, 64));
+    return 0;
+}
@@ -0,0 +1,119 @@
+#define DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION
+#include "double_stack_allocator.h"
+
+#include "bench.h"
+
+#define OPS 4096
+#define MAX_SIZE 256
+
+typedef struct context {
+    dsa_double_stack_allocator allocator;
+    size_t sizes[OPS];
+} context;
+
+static void dsa_alloc_bottom_fixed(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(dsa_alloc_bottom(&c->allocator, 16));
+    }
+    dsa_clear_bottom(&c->allocator);
+}
+
+static void dsa_alloc_top_fixed(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(dsa_alloc_top(&c->allocator, 16));
+    }
+    dsa_clear_top(&c->allocator);
+}
+
+static void dsa_alloc_bottom_random(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(dsa_alloc_bottom(&c->allocator, c->sizes[i]));
+    }
+    dsa_clear_bottom(&c->allocator);
+}
+
+static void dsa_alloc_top_random(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(dsa_alloc_top(&c->allocator, c->sizes[i]));
+    }
+    dsa_clear_top(&c->allocator);
+}
+
+static void dsa_alloc_alternating(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i += 2) {
+        bench_do_not_optimize(dsa_alloc_bottom(&c->allocator, c->sizes[i]));
+        bench_do_not_optimize(dsa_alloc_top(&c->allocator, c->sizes[i + 1]));
+    }
+    dsa_clear_bottom(&c->allocator);
+    dsa_clear_top(&c->allocator);
+}
+
+static void dsa_push_pop(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(dsa_push_top(&c->allocator, 16));
+        dsa_pop_top(&c->allocator, 16);
+    }
+}
+
+static void dsa_marker_rewind(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        size_t marker = dsa_get_top_marker(&c->allocator);
+        bench_do_not_optimize(dsa_alloc_top(&c->allocator, c->sizes[i]));
+        bench_do_not_optimize(dsa_alloc_top(&c->allocator, c->sizes[OPS - 1 - i]));
+        dsa_clear_top_marker(&c->allocator, marker);
+    }
+}
+
+static void dsa_foreach_bottom(void *ctx, size_t ops) {
+    context *c = ctx;
+    long sum = 0;
+    DSA_FOREACH_BOTTOM(int, number, &c->allocator) {
+        sum += *number;
+    }
+    bench_do_not_optimize(&sum);
+}
+
+static void dsa_foreach_top(void *ctx, size_t ops) {
+    context *c = ctx;
+    long sum = 0;
+    DSA_FOREACH_TOP(int, number, &c->allocator) {
+        sum += *number;
+    }
+    bench_do_not_optimize(&sum);
+}
+
+int main(int argc, char **argv) {
+    bench_init(argc, argv);
+
+    static context c;
+    dsa_init_with_capacity(&c.allocator, OPS * (MAX_SIZE + 16));
+    srand(42);
+    for(size_t i = 0; i < OPS; i++) {
+        c.sizes[i] = 1 + rand() % MAX_SIZE;
+    }
+
+    bench_run("dsa_alloc_bottom/fixed16", dsa_alloc_bottom_fixed, &c, OPS);
+    bench_run("dsa_alloc_top/fixed16", dsa_alloc_top_fixed, &c, OPS);
+    bench_run("dsa_alloc_bottom/random", dsa_alloc_bottom_random, &c, OPS);
+    bench_run("dsa_alloc_top/random", dsa_alloc_top_random, &c, OPS);
+    bench_run("dsa_alloc/alternating", dsa_alloc_alternating, &c, OPS);
+    bench_run("dsa_push_pop_top/16", dsa_push_pop, &c, OPS);
+    bench_run("dsa_clear_top_marker/rewind", dsa_marker_rewind, &c, OPS);
+
+    for(size_t i = 0; i < OPS; i++) {
+        *dsa_alloc_bottom_(&c.allocator, int) = (int) i;
+        *dsa_alloc_top_(&c.allocator, int) = (int) i;
+    }
+    bench_run("DSA_FOREACH_BOTTOM/int", dsa_foreach_bottom, &c, OPS);
+    bench_run("DSA_FOREACH_TOP/int", dsa_foreach_top, &c, OPS);
+
+    dsa_release(&c.allocator);
+    return bench_finish();
+}
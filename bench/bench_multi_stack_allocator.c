@@ -0,0 +1,150 @@
+// Memory utilization and push throughput of stacks sharing one buffer.
+//
+// Blocks are pushed to K stacks chosen with a Zipf distribution, so that the
+// first stacks grow much faster than the last ones, until the first push fails:
+//
+// - static:  buffer split evenly into K sa_stack_allocator
+// - msa:     msa_multi_stack_allocator moving stack boundaries when needed
+//
+// Reports the buffer usage when the first push failed, push throughput and
+// the memory moved by redistributions, averaged over a number of rounds.
+//
+// Usage: bench-multi-stack-allocator [--stacks K] [--capacity KB] [--skew S] [--rounds N]
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define MULTI_STACK_ALLOCATOR_IMPLEMENTATION
+#include "multi_stack_allocator.h"
+
+#include "bench.h"
+
+#include <math.h>
+
+#define MAX_STACKS 64
+#define MIN_BLOCK 16
+#define MAX_BLOCK 256
+
+typedef struct push {
+    uint32_t stack;
+    uint32_t size;
+} push;
+
+typedef struct result {
+    size_t pushes;
+    size_t used;
+    double elapsed_ns;
+} result;
+
+static result run_static(sa_stack_allocator *stacks, const push *pushes, size_t push_count) {
+    result r = {};
+    uint64_t start = bench_now_ns();
+    for(; r.pushes < push_count; r.pushes++) {
+        void *ptr = sa_alloc_aligned(&stacks[pushes[r.pushes].stack], pushes[r.pushes].size, 16);
+        if(ptr == NULL) break;
+        bench_do_not_optimize(ptr);
+        r.used += pushes[r.pushes].size;
+    }
+    r.elapsed_ns = (double) (bench_now_ns() - start);
+    return r;
+}
+
+static result run_multi(msa_multi_stack_allocator *memory, const push *pushes, size_t push_count) {
+    result r = {};
+    uint64_t start = bench_now_ns();
+    for(; r.pushes < push_count; r.pushes++) {
+        void *ptr = msa_alloc_aligned(memory, pushes[r.pushes].stack, pushes[r.pushes].size, 16);
+        if(ptr == NULL) break;
+        bench_do_not_optimize(ptr);
+        r.used += pushes[r.pushes].size;
+    }
+    r.elapsed_ns = (double) (bench_now_ns() - start);
+    return r;
+}
+
+static void report(const char *name, result total, size_t rounds, size_t capacity, size_t relocations, size_t relocated_bytes) {
+    printf("%-8s %12.2f%% %14.1f %12.2f %14.1f %14.1f\n", name,
+           100.0 * total.used / ((double) capacity * rounds), (double) total.pushes / rounds,
+           total.pushes / total.elapsed_ns * 1e3,
+           (double) relocations / rounds, relocated_bytes / 1024.0 / rounds);
+}
+
+int main(int argc, char **argv) {
+    size_t stack_count = 4;
+    size_t capacity = 1024 << 10;
+    double skew = 1.0;
+    size_t rounds = 100;
+    for(int i = 1; i + 1 < argc; i += 2) {
+        if(strcmp(argv[i], "--stacks") == 0) stack_count = strtoull(argv[i + 1], NULL, 10);
+        else if(strcmp(argv[i], "--capacity") == 0) capacity = strtoull(argv[i + 1], NULL, 10) << 10;
+        else if(strcmp(argv[i], "--skew") == 0) skew = atof(argv[i + 1]);
+        else if(strcmp(argv[i], "--rounds") == 0) rounds = strtoull(argv[i + 1], NULL, 10);
+    }
+    if(stack_count == 0 || stack_count > MAX_STACKS || capacity == 0 || rounds == 0) {
+        fprintf(stderr, "invalid arguments, stacks must be between 1 and %d\n", MAX_STACKS);
+        return 1;
+    }
+
+    // Enough pushes to fill the whole buffer with the smallest blocks
+    double cumulative[MAX_STACKS];
+    double weights = 0;
+    for(size_t i = 0; i < stack_count; i++) {
+        weights += 1.0 / pow(i + 1, skew);
+        cumulative[i] = weights;
+    }
+    size_t push_count = capacity / MIN_BLOCK + 1;
+    push *pushes = (push *) malloc(push_count * sizeof(push));
+    uint32_t random = 2463534242u;
+    for(size_t i = 0; i < push_count; i++) {
+        // xorshift32
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        double choice = (random >> 8) / (double) (1 << 24) * weights;
+        uint32_t stack = 0;
+        while(stack + 1 < stack_count && cumulative[stack] < choice) stack++;
+        pushes[i].stack = stack;
+        pushes[i].size = (MIN_BLOCK + random % (MAX_BLOCK - MIN_BLOCK)) & ~(uint32_t) 15;
+    }
+
+    printf("%zu stacks, %zu KB, skew %.2f, stack 0 gets %.1f%% of pushes, %zu rounds\n",
+           stack_count, capacity >> 10, skew, 100.0 / weights, rounds);
+    printf("%-8s %13s %14s %12s %14s %14s\n", "strategy", "used at fail", "pushes", "Mpushes/s", "relocations", "moved KB");
+
+    uint8_t *buffer = (uint8_t *) malloc(capacity);
+    sa_stack_allocator stacks[MAX_STACKS];
+    size_t slice = capacity / stack_count & ~(size_t) 15;
+    result total = {};
+    for(size_t round = 0; round < rounds; round++) {
+        for(size_t i = 0; i < stack_count; i++) {
+            stacks[i] = SA_NEW(buffer + i * slice, slice);
+        }
+        result r = run_static(stacks, pushes, push_count);
+        total.pushes += r.pushes;
+        total.used += r.used;
+        total.elapsed_ns += r.elapsed_ns;
+    }
+    report("static", total, rounds, capacity, 0, 0);
+    free(buffer);
+
+    msa_multi_stack_allocator memory;
+    if(!msa_init_with_capacity(&memory, stack_count, capacity)) {
+        perror("msa_init_with_capacity");
+        return 1;
+    }
+    total = (result){};
+    size_t relocations = 0, relocated_bytes = 0;
+    for(size_t round = 0; round < rounds; round++) {
+        msa_release(&memory);
+        msa_init_with_capacity(&memory, stack_count, capacity);
+        result r = run_multi(&memory, pushes, push_count);
+        total.pushes += r.pushes;
+        total.used += r.used;
+        total.elapsed_ns += r.elapsed_ns;
+        relocations += memory.relocations;
+        relocated_bytes += memory.relocated_bytes;
+    }
+    report("msa", total, rounds, capacity, relocations, relocated_bytes);
+    msa_release(&memory);
+
+    free(pushes);
+    return 0;
+}
@@ -0,0 +1,157 @@
+// Skewed load benchmark for partitioned arenas.
+//
+// Worker threads share one buffer, with demand following a Zipf distribution
+// so that the first workers need much more memory than the last ones, while
+// total demand fits in the buffer:
+//
+// - static:    buffer split evenly into one sa_stack_allocator per worker
+// - pa/pairs:  pa_partitioned_allocator without stealing, pairs of workers sharing regions
+// - pa/steal:  pa_partitioned_allocator stealing from other pairs when a pair's region is full
+//
+// Reports allocation failures, the bytes that could not be allocated and throughput.
+//
+// Usage: bench-partitioned-allocator [--workers N] [--capacity MB] [--skew S]
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define PARTITIONED_ALLOCATOR_IMPLEMENTATION
+#include "partitioned_allocator.h"
+
+#include "bench.h"
+
+#include <math.h>
+#include <pthread.h>
+
+#define MAX_WORKERS 256
+#define MIN_BLOCK 16
+#define MAX_BLOCK 512
+
+typedef struct context context;
+
+typedef struct worker {
+    context *ctx;
+    size_t id;
+    size_t demand;
+    size_t allocations;
+    size_t failures;
+    size_t failed_bytes;
+} worker;
+
+struct context {
+    const char *name;
+    int use_partitioned;
+    sa_stack_allocator *statics;
+    pa_partitioned_allocator partitioned;
+    pthread_barrier_t barrier;
+};
+
+static void *worker_loop(void *arg) {
+    worker *w = (worker *) arg;
+    context *ctx = w->ctx;
+    uint32_t random = 2463534242u + (uint32_t) w->id;
+    pthread_barrier_wait(&ctx->barrier);
+    for(size_t requested = 0; requested < w->demand; ) {
+        // xorshift32
+        random ^= random << 13;
+        random ^= random >> 17;
+        random ^= random << 5;
+        size_t size = (MIN_BLOCK + random % (MAX_BLOCK - MIN_BLOCK)) & ~(size_t) 15;
+        void *ptr = ctx->use_partitioned
+                  ? pa_alloc_aligned(&ctx->partitioned, w->id, size, 16)
+                  : sa_alloc_aligned(&ctx->statics[w->id], size, 16);
+        if(ptr == NULL) {
+            w->failures++;
+            w->failed_bytes += size;
+        }
+        else {
+            memset(ptr, 0, MIN_BLOCK);
+        }
+        w->allocations++;
+        requested += size;
+    }
+    return NULL;
+}
+
+static void run(context *ctx, worker *workers, size_t worker_count) {
+    pthread_t threads[MAX_WORKERS];
+    pthread_barrier_init(&ctx->barrier, NULL, worker_count + 1);
+    for(size_t i = 0; i < worker_count; i++) {
+        workers[i].ctx = ctx;
+        workers[i].allocations = workers[i].failures = workers[i].failed_bytes = 0;
+        pthread_create(&threads[i], NULL, worker_loop, &workers[i]);
+    }
+    pthread_barrier_wait(&ctx->barrier);
+    uint64_t start = bench_now_ns();
+    for(size_t i = 0; i < worker_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = (double) (bench_now_ns() - start);
+    pthread_barrier_destroy(&ctx->barrier);
+
+    size_t allocations = 0, failures = 0, failed_bytes = 0;
+    for(size_t i = 0; i < worker_count; i++) {
+        allocations += workers[i].allocations;
+        failures += workers[i].failures;
+        failed_bytes += workers[i].failed_bytes;
+    }
+    printf("%-10s %12zu %10.2f%% %12.2f %12.2f %10lu\n", ctx->name, failures, 100.0 * failures / allocations,
+           failed_bytes / (1024.0 * 1024.0), allocations / elapsed * 1e3,
+           ctx->use_partitioned ? (unsigned long) ctx->partitioned.steal_count : 0ul);
+}
+
+int main(int argc, char **argv) {
+    size_t worker_count = 8;
+    size_t capacity = 64 << 20;
+    double skew = 1.0;
+    for(int i = 1; i + 1 < argc; i += 2) {
+        if(strcmp(argv[i], "--workers") == 0) worker_count = strtoull(argv[i + 1], NULL, 10);
+        else if(strcmp(argv[i], "--capacity") == 0) capacity = strtoull(argv[i + 1], NULL, 10) << 20;
+        else if(strcmp(argv[i], "--skew") == 0) skew = atof(argv[i + 1]);
+    }
+    if(worker_count == 0 || worker_count > MAX_WORKERS || capacity == 0) {
+        fprintf(stderr, "invalid arguments, workers must be between 1 and %d\n", MAX_WORKERS);
+        return 1;
+    }
+
+    // Zipf distributed demand totaling 90% of capacity
+    worker workers[MAX_WORKERS] = {};
+    double weights = 0;
+    for(size_t i = 0; i < worker_count; i++) {
+        weights += 1.0 / pow(i + 1, skew);
+    }
+    for(size_t i = 0; i < worker_count; i++) {
+        workers[i].id = i;
+        workers[i].demand = (size_t) (0.9 * capacity / pow(i + 1, skew) / weights);
+    }
+
+    context ctx = {};
+    printf("%zu workers, %zu MB, skew %.2f, worker 0 demands %.1f%% of capacity\n",
+           worker_count, capacity >> 20, skew, 100.0 * workers[0].demand / capacity);
+    printf("%-10s %12s %11s %12s %12s %10s\n", "strategy", "failures", "failed", "failed MB", "Mallocs/s", "steals");
+
+    uint8_t *buffer = (uint8_t *) malloc(capacity);
+    ctx.statics = (sa_stack_allocator *) malloc(worker_count * sizeof(sa_stack_allocator));
+    size_t slice = capacity / worker_count;
+    for(size_t i = 0; i < worker_count; i++) {
+        ctx.statics[i] = SA_NEW(buffer + i * slice, slice);
+    }
+    ctx.name = "static";
+    run(&ctx, workers, worker_count);
+    free(ctx.statics);
+    free(buffer);
+
+    if(!pa_init(&ctx.partitioned, capacity, worker_count)) {
+        perror("pa_init");
+        return 1;
+    }
+    ctx.use_partitioned = 1;
+    ctx.name = "pa/pairs";
+    ctx.partitioned.steal = 0;
+    run(&ctx, workers, worker_count);
+
+    pa_clear(&ctx.partitioned);
+    ctx.name = "pa/steal";
+    ctx.partitioned.steal = 1;
+    run(&ctx, workers, worker_count);
+    pa_release(&ctx.partitioned);
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Per-CPU allocation benchmark with many more threads than CPUs.
+//
+// Every thread makes the same number of small allocations, using:
+//
+// - percpu/rseq:   sa_percpu_allocator using restartable sequences, if available
+// - percpu/atomic: sa_percpu_allocator using sched_getcpu and compare-and-swap
+// - thread-local:  one sa_stack_allocator per thread, reserving memory for each thread
+// - shared/atomic: one sa_stack_allocator whose marker is bumped with compare-and-swap
+//
+// Usage: bench-percpu-allocator [--threads N] [--allocations N]
+#define _GNU_SOURCE
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define PERCPU_ALLOCATOR_IMPLEMENTATION
+#include "percpu_allocator.h"
+
+#include "bench.h"
+
+#include <pthread.h>
+
+#define BLOCK_SIZE 32
+
+typedef struct context {
+    const char *name;
+    void *(*alloc)(struct context *ctx, sa_stack_allocator *local, size_t size);
+    sa_percpu_allocator percpu;
+    sa_stack_allocator shared;
+    size_t allocations;
+    pthread_barrier_t barrier;
+} context;
+
+static void *alloc_percpu(context *ctx, sa_stack_allocator *local, size_t size) {
+    (void) local;
+    return sa_percpu_alloc(&ctx->percpu, size);
+}
+
+static void *alloc_local(context *ctx, sa_stack_allocator *local, size_t size) {
+    (void) ctx;
+    return sa_alloc(local, size);
+}
+
+static void *alloc_shared(context *ctx, sa_stack_allocator *local, size_t size) {
+    (void) local;
+    sa_stack_allocator *shared = &ctx->shared;
+    size_t marker = __atomic_load_n(&shared->marker, __ATOMIC_RELAXED);
+    do {
+        if(size > shared->capacity - marker) return NULL;
+    } while(!__atomic_compare_exchange_n(&shared->marker, &marker, marker + size, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return (uint8_t *) shared->buffer + marker;
+}
+
+static void *worker(void *arg) {
+    context *ctx = (context *) arg;
+    sa_stack_allocator local = {};
+    if(ctx->alloc == alloc_local && !sa_init_with_capacity(&local, ctx->allocations * BLOCK_SIZE)) {
+        return (void *) 1;
+    }
+    pthread_barrier_wait(&ctx->barrier);
+    for(size_t i = 0; i < ctx->allocations; i++) {
+        uint64_t *block = (uint64_t *) ctx->alloc(ctx, &local, BLOCK_SIZE);
+        if(block == NULL) return (void *) 1;
+        *block = i;
+    }
+    sa_release(&local);
+    return NULL;
+}
+
+static void run(context *ctx, int threads) {
+    pthread_t workers[threads];
+    pthread_barrier_init(&ctx->barrier, NULL, threads + 1);
+    for(int i = 0; i < threads; i++) {
+        pthread_create(&workers[i], NULL, worker, ctx);
+    }
+    pthread_barrier_wait(&ctx->barrier);
+    uint64_t start = bench_now_ns();
+    int failed = 0;
+    for(int i = 0; i < threads; i++) {
+        void *result;
+        pthread_join(workers[i], &result);
+        failed |= result != NULL;
+    }
+    double elapsed = (double) (bench_now_ns() - start);
+    pthread_barrier_destroy(&ctx->barrier);
+    if(failed) {
+        fprintf(stderr, "%s: allocation failed\n", ctx->name);
+        exit(1);
+    }
+    double total = (double) threads * ctx->allocations;
+    printf("%-14s %7d %12.2f\n", ctx->name, threads, total / elapsed * 1e3);
+}
+
+int main(int argc, char **argv) {
+    int threads = 0;
+    size_t allocations = 200000;
+    for(int i = 1; i + 1 < argc; i += 2) {
+        if(strcmp(argv[i], "--threads") == 0) threads = atoi(argv[i + 1]);
+        else if(strcmp(argv[i], "--allocations") == 0) allocations = strtoull(argv[i + 1], NULL, 10);
+    }
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if(threads <= 0) threads = 16 * (int) cpus;
+
+    // Per-CPU and shared arenas fit every allocation even if all threads run on one CPU
+    size_t total = (size_t) threads * allocations * BLOCK_SIZE;
+    context ctx = {};
+    ctx.allocations = allocations;
+    printf("%d threads, %ld CPUs, rseq %s\n", threads, cpus, sa_percpu_rseq_available() ? "available" : "unavailable");
+    printf("%-14s %7s %12s\n", "strategy", "threads", "Mallocs/s");
+
+    if(!sa_percpu_init(&ctx.percpu, total)) {
+        perror("sa_percpu_init");
+        return 1;
+    }
+    if(ctx.percpu.use_rseq) {
+        ctx.name = "percpu/rseq";
+        ctx.alloc = alloc_percpu;
+        run(&ctx, threads);
+        sa_percpu_clear(&ctx.percpu);
+    }
+    ctx.name = "percpu/atomic";
+    ctx.alloc = alloc_percpu;
+    ctx.percpu.use_rseq = 0;
+    run(&ctx, threads);
+    sa_percpu_release(&ctx.percpu);
+
+    ctx.name = "thread-local";
+    ctx.alloc = alloc_local;
+    run(&ctx, threads);
+
+    if(!sa_init_with_capacity(&ctx.shared, total)) {
+        perror("sa_init_with_capacity");
+        return 1;
+    }
+    ctx.name = "shared/atomic";
+    ctx.alloc = alloc_shared;
+    run(&ctx, threads);
+    sa_release(&ctx.shared);
+    return 0;
+}
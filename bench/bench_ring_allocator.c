@@ -0,0 +1,173 @@
+// Producer/consumer streaming benchmark.
+//
+// One producer thread sends variable sized messages to one consumer thread,
+// which checks and discards them in order:
+//
+// - ring/spsc:   messages are written in place in a ra_ring_allocator with ra_spsc_* functions
+// - mutex/queue: messages are malloc'd and passed through a mutex protected queue of pointers
+//
+// Usage: bench-ring-allocator [--messages N] [--max-size BYTES]
+#define RING_ALLOCATOR_IMPLEMENTATION
+#include "ring_allocator.h"
+
+#include "bench.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#define QUEUE_DEPTH 1024
+#define RING_CAPACITY (1 << 20)
+
+typedef struct message {
+    uint32_t size;  // total size, including this header
+    uint32_t sequence;
+} message;
+
+typedef struct mutex_queue {
+    pthread_mutex_t mutex;
+    message *slots[QUEUE_DEPTH];
+    size_t head, tail;
+} mutex_queue;
+
+typedef struct stream {
+    size_t messages;
+    uint32_t *sizes;
+    ra_ring_allocator ring;
+    mutex_queue queue;
+    uint64_t checksum;
+} stream;
+
+static void write_message(message *msg, uint32_t size, uint32_t sequence) {
+    msg->size = size;
+    msg->sequence = sequence;
+    memset(msg + 1, (int) (sequence & 0xFF), size - sizeof(message));
+}
+
+static uint64_t read_message(const message *msg, uint32_t sequence) {
+    if(msg->sequence != sequence) {
+        fprintf(stderr, "message %u out of order\n", sequence);
+        exit(1);
+    }
+    const uint8_t *payload = (const uint8_t *) (msg + 1);
+    return msg->size + payload[0] + payload[msg->size - sizeof(message) - 1];
+}
+
+static void *ring_producer(void *arg) {
+    stream *s = (stream *) arg;
+    for(size_t i = 0; i < s->messages; i++) {
+        message *msg;
+        while((msg = (message *) ra_spsc_reserve(&s->ring, s->sizes[i])) == NULL) {
+            sched_yield();
+        }
+        write_message(msg, s->sizes[i], (uint32_t) i);
+        ra_spsc_commit(&s->ring, s->sizes[i]);
+    }
+    return NULL;
+}
+
+static void ring_consumer(stream *s) {
+    for(size_t i = 0; i < s->messages; i++) {
+        message *msg;
+        while((msg = (message *) ra_spsc_peek(&s->ring, NULL)) == NULL) {
+            sched_yield();
+        }
+        s->checksum += read_message(msg, (uint32_t) i);
+        ra_spsc_free(&s->ring, msg->size);
+    }
+}
+
+static void *queue_producer(void *arg) {
+    stream *s = (stream *) arg;
+    mutex_queue *queue = &s->queue;
+    for(size_t i = 0; i < s->messages; i++) {
+        message *msg = (message *) malloc(s->sizes[i]);
+        write_message(msg, s->sizes[i], (uint32_t) i);
+        for(;;) {
+            pthread_mutex_lock(&queue->mutex);
+            if(queue->head - queue->tail < QUEUE_DEPTH) break;
+            pthread_mutex_unlock(&queue->mutex);
+            sched_yield();
+        }
+        queue->slots[queue->head++ % QUEUE_DEPTH] = msg;
+        pthread_mutex_unlock(&queue->mutex);
+    }
+    return NULL;
+}
+
+static void queue_consumer(stream *s) {
+    mutex_queue *queue = &s->queue;
+    for(size_t i = 0; i < s->messages; i++) {
+        message *msg;
+        for(;;) {
+            pthread_mutex_lock(&queue->mutex);
+            if(queue->head != queue->tail) break;
+            pthread_mutex_unlock(&queue->mutex);
+            sched_yield();
+        }
+        msg = queue->slots[queue->tail++ % QUEUE_DEPTH];
+        pthread_mutex_unlock(&queue->mutex);
+        s->checksum += read_message(msg, (uint32_t) i);
+        free(msg);
+    }
+}
+
+static double run(stream *s, void *(*producer)(void *), void (*consumer)(stream *)) {
+    pthread_t thread;
+    s->checksum = 0;
+    uint64_t start = bench_now_ns();
+    pthread_create(&thread, NULL, producer, s);
+    consumer(s);
+    pthread_join(thread, NULL);
+    return (double) (bench_now_ns() - start);
+}
+
+int main(int argc, char **argv) {
+    size_t messages = 5000000;
+    uint32_t max_size = 256;
+    for(int i = 1; i + 1 < argc; i += 2) {
+        if(strcmp(argv[i], "--messages") == 0) messages = strtoull(argv[i + 1], NULL, 10);
+        else if(strcmp(argv[i], "--max-size") == 0) max_size = (uint32_t) strtoul(argv[i + 1], NULL, 10);
+    }
+    if(messages == 0 || max_size <= sizeof(message) || max_size > RING_CAPACITY) {
+        fprintf(stderr, "invalid arguments, message size must be between %zu and %d bytes\n", sizeof(message) + 1, RING_CAPACITY);
+        return 1;
+    }
+
+    stream s = {};
+    s.messages = messages;
+    s.sizes = (uint32_t *) malloc(messages * sizeof(uint32_t));
+    srand(42);
+    uint64_t total_bytes = 0;
+    for(size_t i = 0; i < messages; i++) {
+        // Sizes are multiples of 8, keeping every message aligned in the ring
+        uint32_t size = sizeof(message) + 1 + rand() % (max_size - sizeof(message));
+        s.sizes[i] = (size + 7) & ~7u;
+        total_bytes += s.sizes[i];
+    }
+    if(!ra_init_with_capacity(&s.ring, RING_CAPACITY)) {
+        perror("ra_init_with_capacity");
+        return 1;
+    }
+    pthread_mutex_init(&s.queue.mutex, NULL);
+
+    printf("%-12s %14s %10s\n", "strategy", "messages/s", "MB/s");
+    struct { const char *name; void *(*producer)(void *); void (*consumer)(stream *); } strategies[] = {
+        { "ring/spsc", ring_producer, ring_consumer },
+        { "mutex/queue", queue_producer, queue_consumer },
+    };
+    uint64_t expected_checksum = 0;
+    for(size_t i = 0; i < sizeof(strategies) / sizeof(strategies[0]); i++) {
+        double elapsed = run(&s, strategies[i].producer, strategies[i].consumer);
+        if(i == 0) expected_checksum = s.checksum;
+        else if(s.checksum != expected_checksum) {
+            fprintf(stderr, "%s: checksum mismatch\n", strategies[i].name);
+            return 1;
+        }
+        printf("%-12s %14.0f %10.1f\n", strategies[i].name, messages / elapsed * 1e9, total_bytes / elapsed * 1e3);
+    }
+
+    pthread_mutex_destroy(&s.queue.mutex);
+    ra_release(&s.ring);
+    free(s.sizes);
+    return 0;
+}
@@ -0,0 +1,136 @@
+// Multi-process shared arena benchmark.
+//
+// Forks 1..N processes that append fixed size records to one arena:
+//
+// - shared: records are allocated directly in a sa_shared_allocator mapped by every process
+// - pipe:   records are written to a pipe, read by the parent and copied into its sa_stack_allocator
+//
+// Usage: bench-shared-allocator [--processes N] [--records N] [--size BYTES]
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define MAPPED_STACK_ALLOCATOR_IMPLEMENTATION
+#include "mapped_stack_allocator.h"
+
+#include "bench.h"
+
+#include <limits.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static void fill_record(uint8_t *record, size_t size, int process, size_t index) {
+    memset(record, (int) (index & 0xFF), size);
+    memcpy(record, &process, sizeof(int));
+}
+
+static void wait_children(pid_t *children, int processes) {
+    for(int p = 0; p < processes; p++) {
+        int status;
+        waitpid(children[p], &status, 0);
+        if(!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "child %d failed\n", p);
+            exit(1);
+        }
+    }
+}
+
+static double run_shared(int processes, size_t records, size_t size) {
+    sa_shared_allocator arena;
+    if(!sa_shared_create(&arena, NULL, processes * records * size)) {
+        perror("sa_shared_create");
+        exit(1);
+    }
+    pid_t children[processes];
+    uint64_t start = bench_now_ns();
+    for(int p = 0; p < processes; p++) {
+        children[p] = fork();
+        if(children[p] == 0) {
+            for(size_t i = 0; i < records; i++) {
+                uint8_t *record = (uint8_t *) sa_shared_alloc(&arena, size);
+                if(record == NULL) _exit(1);
+                fill_record(record, size, p, i);
+            }
+            _exit(0);
+        }
+    }
+    wait_children(children, processes);
+    double elapsed = (double) (bench_now_ns() - start);
+    if(sa_shared_used_memory(&arena) != processes * records * size) {
+        fprintf(stderr, "shared: lost records\n");
+        exit(1);
+    }
+    sa_shared_detach(&arena);
+    return elapsed;
+}
+
+static double run_pipe(int processes, size_t records, size_t size) {
+    sa_stack_allocator arena;
+    if(!sa_init_with_capacity(&arena, processes * records * size)) {
+        perror("sa_init_with_capacity");
+        exit(1);
+    }
+    int fds[2];
+    if(pipe(fds) != 0) {
+        perror("pipe");
+        exit(1);
+    }
+    pid_t children[processes];
+    uint64_t start = bench_now_ns();
+    for(int p = 0; p < processes; p++) {
+        children[p] = fork();
+        if(children[p] == 0) {
+            close(fds[0]);
+            uint8_t record[size];
+            for(size_t i = 0; i < records; i++) {
+                fill_record(record, size, p, i);
+                // Writes up to PIPE_BUF bytes are atomic, so records are never interleaved
+                if(write(fds[1], record, size) != (ssize_t) size) _exit(1);
+            }
+            _exit(0);
+        }
+    }
+    close(fds[1]);
+    // Read records in bulk straight into the arena's free memory, as a pipe based server would
+    ssize_t n;
+    while((n = read(fds[0], (uint8_t *) arena.buffer + arena.marker, sa_available_memory(&arena))) > 0) {
+        sa_alloc(&arena, n);
+    }
+    close(fds[0]);
+    wait_children(children, processes);
+    double elapsed = (double) (bench_now_ns() - start);
+    if(sa_used_memory(&arena) != processes * records * size) {
+        fprintf(stderr, "pipe: lost records\n");
+        exit(1);
+    }
+    sa_release(&arena);
+    return elapsed;
+}
+
+int main(int argc, char **argv) {
+    int max_processes = 4;
+    size_t records = 1000000;
+    size_t size = 64;
+    for(int i = 1; i + 1 < argc; i += 2) {
+        if(strcmp(argv[i], "--processes") == 0) max_processes = atoi(argv[i + 1]);
+        else if(strcmp(argv[i], "--records") == 0) records = strtoull(argv[i + 1], NULL, 10);
+        else if(strcmp(argv[i], "--size") == 0) size = strtoull(argv[i + 1], NULL, 10);
+    }
+    if(max_processes < 1 || records == 0 || size < sizeof(int) || size > PIPE_BUF) {
+        fprintf(stderr, "invalid arguments, record size must be between %zu and %d bytes\n", sizeof(int), PIPE_BUF);
+        return 1;
+    }
+
+    printf("%-8s %9s %14s %10s\n", "strategy", "processes", "records/s", "MB/s");
+    for(int processes = 1; processes <= max_processes; processes *= 2) {
+        struct { const char *name; double (*run)(int, size_t, size_t); } strategies[] = {
+            { "shared", run_shared },
+            { "pipe", run_pipe },
+        };
+        for(size_t s = 0; s < sizeof(strategies) / sizeof(strategies[0]); s++) {
+            double elapsed = strategies[s].run(processes, records, size);
+            double total = (double) processes * records;
+            printf("%-8s %9d %14.0f %10.1f\n", strategies[s].name, processes,
+                   total / elapsed * 1e9, total * size / elapsed * 1e3);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+
+#include "bench.h"
+
+#define OPS 4096
+#define MAX_SIZE 256
+
+typedef struct context {
+    sa_stack_allocator allocator;
+    size_t sizes[OPS];
+    void *pointers[OPS];
+} context;
+
+static void sa_alloc_fixed(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(sa_alloc(&c->allocator, 16));
+    }
+    sa_clear(&c->allocator);
+}
+
+static void sa_alloc_random(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(sa_alloc(&c->allocator, c->sizes[i]));
+    }
+    sa_clear(&c->allocator);
+}
+
+static void sa_alloc_aligned_random(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(sa_alloc_aligned(&c->allocator, c->sizes[i], 16));
+    }
+    sa_clear(&c->allocator);
+}
+
+static void malloc_fixed(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        c->pointers[i] = malloc(16);
+        bench_do_not_optimize(c->pointers[i]);
+    }
+    for(size_t i = 0; i < ops; i++) {
+        free(c->pointers[i]);
+    }
+}
+
+static void malloc_random(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        c->pointers[i] = malloc(c->sizes[i]);
+        bench_do_not_optimize(c->pointers[i]);
+    }
+    for(size_t i = 0; i < ops; i++) {
+        free(c->pointers[i]);
+    }
+}
+
+static void sa_push_pop(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        bench_do_not_optimize(sa_push(&c->allocator, 16));
+        sa_pop(&c->allocator, 16);
+    }
+}
+
+static void malloc_free_cycle(void *ctx, size_t ops) {
+    for(size_t i = 0; i < ops; i++) {
+        void *ptr = malloc(16);
+        bench_do_not_optimize(ptr);
+        free(ptr);
+    }
+}
+
+static void sa_marker_rewind(void *ctx, size_t ops) {
+    context *c = ctx;
+    for(size_t i = 0; i < ops; i++) {
+        size_t marker = sa_get_marker(&c->allocator);
+        bench_do_not_optimize(sa_alloc(&c->allocator, c->sizes[i]));
+        bench_do_not_optimize(sa_alloc(&c->allocator, c->sizes[OPS - 1 - i]));
+        sa_clear_marker(&c->allocator, marker);
+    }
+}
+
+static void fill_ints(context *c, size_t count) {
+    sa_clear(&c->allocator);
+    for(size_t i = 0; i < count; i++) {
+        *sa_alloc_(&c->allocator, int) = (int) i;
+    }
+}
+
+static void sa_foreach(void *ctx, size_t ops) {
+    context *c = ctx;
+    long sum = 0;
+    SA_FOREACH(int, number, &c->allocator) {
+        sum += *number;
+    }
+    bench_do_not_optimize(&sum);
+}
+
+static void sa_foreach_reverse(void *ctx, size_t ops) {
+    context *c = ctx;
+    long sum = 0;
+    SA_FOREACH_REVERSE(int, number, &c->allocator) {
+        sum += *number;
+    }
+    bench_do_not_optimize(&sum);
+}
+
+static void array_loop(void *ctx, size_t ops) {
+    context *c = ctx;
+    const int *numbers = c->allocator.buffer;
+    long sum = 0;
+    for(size_t i = 0; i < ops; i++) {
+        sum += numbers[i];
+        bench_do_not_optimize(&sum);
+    }
+}
+
+int main(int argc, char **argv) {
+    bench_init(argc, argv);
+
+    static context c;
+    sa_init_with_capacity(&c.allocator, OPS * (MAX_SIZE + 16));
+    srand(42);
+    for(size_t i = 0; i < OPS; i++) {
+        c.sizes[i] = 1 + rand() % MAX_SIZE;
+    }
+
+    bench_run("sa_alloc/fixed16", sa_alloc_fixed, &c, OPS);
+    bench_run("malloc/fixed16", malloc_fixed, &c, OPS);
+    bench_run("sa_alloc/random", sa_alloc_random, &c, OPS);
+    bench_run("sa_alloc_aligned/random", sa_alloc_aligned_random, &c, OPS);
+    bench_run("malloc/random", malloc_random, &c, OPS);
+    bench_run("sa_push_pop/16", sa_push_pop, &c, OPS);
+    bench_run("malloc_free/16", malloc_free_cycle, &c, OPS);
+    bench_run("sa_clear_marker/rewind", sa_marker_rewind, &c, OPS);
+
+    fill_ints(&c, OPS);
+    bench_run("SA_FOREACH/int", sa_foreach, &c, OPS);
+    bench_run("SA_FOREACH_REVERSE/int", sa_foreach_reverse, &c, OPS);
+    bench_run("array_loop/int", array_loop, &c, OPS);
+
+    sa_release(&c.allocator);
+    return bench_finish();
+}
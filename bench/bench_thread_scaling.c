@@ -0,0 +1,375 @@
+// Multi-threaded allocation scaling benchmark.
+//
+// Runs allocation workloads over 1..N pinned threads with different
+// allocation strategies, reporting throughput, sampled per-allocation
+// latency percentiles and contention indicators:
+//
+// - thread-local/padded: one sa_stack_allocator per thread, each in its own cache line
+// - thread-local/packed: one sa_stack_allocator per thread, adjacent in memory,
+//                        so slowdowns versus padded indicate false sharing
+// - dsa/padded, dsa/packed: same as above with dsa_double_stack_allocator,
+//                        alternating bottom and top allocations
+// - shared/mutex:        one sa_stack_allocator protected by a mutex
+// - shared/atomic:       one sa_stack_allocator whose marker is bumped with compare-and-swap
+// - malloc:              malloc/free
+//
+// Workloads:
+//
+// - independent: every thread allocates and touches blocks, then frees them
+// - prodcons:    producer threads allocate messages consumed by paired consumer threads
+// - fanout:      a coordinator allocates tasks for every thread, whose results it gathers
+//
+// Usage: bench-thread-scaling [--threads N] [--rounds N] [--workload NAME]
+#define _GNU_SOURCE
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION
+#include "double_stack_allocator.h"
+
+#include "bench.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+    #include <x86intrin.h>
+    #define TICKS() ((uint64_t) __rdtsc())
+#else
+    #define TICKS() bench_now_ns()
+#endif
+
+#define CACHE_LINE 64
+#define BATCH 1024
+#define MAX_BLOCK 128
+#define SAMPLE_EVERY 16
+#define MAX_THREADS 256
+
+typedef struct worker worker;
+
+typedef struct strategy {
+    const char *name;
+    void *(*alloc)(worker *w, size_t size);
+    void (*free)(worker *w, void *ptr);
+    int shared;
+} strategy;
+
+struct worker {
+    int id;
+    sa_stack_allocator *arena;
+    dsa_double_stack_allocator *double_arena;
+    uint64_t retries;
+    uint64_t allocations;
+    uint64_t *samples;
+    size_t sample_count;
+    uint64_t checksum;
+    void **slots;        // messages for prodcons, tasks for fanout
+    size_t produced;     // prodcons: number of messages published, written by producer
+    char padding[CACHE_LINE];
+};
+
+typedef struct padded_allocator {
+    _Alignas(CACHE_LINE) sa_stack_allocator allocator;
+} padded_allocator;
+
+typedef struct padded_double_allocator {
+    _Alignas(CACHE_LINE) dsa_double_stack_allocator allocator;
+} padded_double_allocator;
+
+static struct {
+    sa_stack_allocator allocator;
+    pthread_mutex_t lock;
+} shared;
+
+static padded_allocator padded[MAX_THREADS];
+static sa_stack_allocator packed[MAX_THREADS];
+static padded_double_allocator padded_double[MAX_THREADS];
+static dsa_double_stack_allocator packed_double[MAX_THREADS];
+static worker workers[MAX_THREADS];
+static pthread_barrier_t barrier;        // synchronizes workers between rounds
+static pthread_barrier_t start_barrier;  // releases workers once the main thread starts timing
+static const strategy *current_strategy;
+static void (*current_workload)(worker *w);
+static int thread_count;
+static int rounds = 200;
+
+static void *local_alloc(worker *w, size_t size) {
+    return sa_alloc(w->arena, size);
+}
+
+static void *double_alloc(worker *w, size_t size) {
+    return w->allocations & 1 ? dsa_alloc_top(w->double_arena, size) : dsa_alloc_bottom(w->double_arena, size);
+}
+
+static void *mutex_alloc(worker *w, size_t size) {
+    if(pthread_mutex_trylock(&shared.lock) != 0) {
+        w->retries++;
+        pthread_mutex_lock(&shared.lock);
+    }
+    void *ptr = sa_alloc(&shared.allocator, size);
+    pthread_mutex_unlock(&shared.lock);
+    return ptr;
+}
+
+static void *atomic_alloc(worker *w, size_t size) {
+    size_t marker = __atomic_load_n(&shared.allocator.marker, __ATOMIC_RELAXED);
+    do {
+        if(marker + size > shared.allocator.capacity) return NULL;
+    } while(!__atomic_compare_exchange_n(&shared.allocator.marker, &marker, marker + size, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+            && ++w->retries);
+    return ((uint8_t *) shared.allocator.buffer) + marker;
+}
+
+static void *malloc_alloc(worker *w, size_t size) {
+    return malloc(size);
+}
+
+static void no_free(worker *w, void *ptr) {}
+
+static void malloc_free(worker *w, void *ptr) {
+    free(ptr);
+}
+
+static const strategy strategies[] = {
+    { "thread-local/padded", local_alloc, no_free, 0 },
+    { "thread-local/packed", local_alloc, no_free, 0 },
+    { "dsa/padded", double_alloc, no_free, 0 },
+    { "dsa/packed", double_alloc, no_free, 0 },
+    { "shared/mutex", mutex_alloc, no_free, 1 },
+    { "shared/atomic", atomic_alloc, no_free, 1 },
+    { "malloc", malloc_alloc, malloc_free, 0 },
+};
+
+static void *timed_alloc(worker *w, size_t size) {
+    void *ptr;
+    if(w->allocations++ % SAMPLE_EVERY == 0) {
+        uint64_t start = TICKS();
+        ptr = current_strategy->alloc(w, size);
+        w->samples[w->sample_count++] = TICKS() - start;
+    }
+    else {
+        ptr = current_strategy->alloc(w, size);
+    }
+    if(ptr == NULL) abort();
+    *(volatile uint8_t *) ptr = (uint8_t) size;
+    return ptr;
+}
+
+// End of round: every thread resets its own arena, thread 0 resets the shared one.
+static void end_round(worker *w) {
+    pthread_barrier_wait(&barrier);
+    sa_clear(w->arena);
+    dsa_clear_bottom(w->double_arena);
+    dsa_clear_top(w->double_arena);
+    if(w->id == 0) sa_clear(&shared.allocator);
+    pthread_barrier_wait(&barrier);
+}
+
+static size_t block_size(worker *w, size_t i) {
+    return 16 + (size_t) ((w->id * 31 + i * 17) % (MAX_BLOCK - 16));
+}
+
+static void independent_workload(worker *w) {
+    void **blocks = w->slots;
+    for(int round = 0; round < rounds; round++) {
+        for(size_t i = 0; i < BATCH; i++) {
+            blocks[i] = timed_alloc(w, block_size(w, i));
+        }
+        for(size_t i = 0; i < BATCH; i++) {
+            current_strategy->free(w, blocks[i]);
+        }
+        end_round(w);
+    }
+}
+
+// Even threads produce messages for the next odd thread, which consumes them.
+static void prodcons_workload(worker *w) {
+    int producer = w->id % 2 == 0;
+    worker *peer = &workers[producer ? w->id + 1 : w->id - 1];
+    for(int round = 0; round < rounds; round++) {
+        if(producer) {
+            for(size_t i = 0; i < BATCH; i++) {
+                uint64_t *message = timed_alloc(w, 64);
+                message[0] = i;
+                w->slots[i] = message;
+                __atomic_store_n(&w->produced, i + 1, __ATOMIC_RELEASE);
+            }
+        }
+        else {
+            for(size_t i = 0; i < BATCH; i++) {
+                while(__atomic_load_n(&peer->produced, __ATOMIC_ACQUIRE) <= i) sched_yield();
+                uint64_t *message = peer->slots[i];
+                w->checksum += message[0];
+                current_strategy->free(w, message);
+            }
+        }
+        end_round(w);
+        if(producer) w->produced = 0;
+        pthread_barrier_wait(&barrier);
+    }
+}
+
+// Thread 0 allocates one task per thread, every thread allocates results
+// into its task and thread 0 gathers them.
+static void fanout_workload(worker *w) {
+    size_t results_per_task = BATCH / thread_count;
+    for(int round = 0; round < rounds; round++) {
+        if(w->id == 0) {
+            for(int i = 0; i < thread_count; i++) {
+                workers[0].slots[i] = timed_alloc(w, (results_per_task + 1) * sizeof(void *));
+            }
+        }
+        pthread_barrier_wait(&barrier);
+        void **task = workers[0].slots[w->id];
+        for(size_t i = 0; i < results_per_task; i++) {
+            task[i] = timed_alloc(w, block_size(w, i));
+        }
+        pthread_barrier_wait(&barrier);
+        if(w->id == 0) {
+            for(int i = 0; i < thread_count; i++) {
+                void **results = workers[0].slots[i];
+                for(size_t j = 0; j < results_per_task; j++) {
+                    w->checksum += *(uint8_t *) results[j];
+                    current_strategy->free(w, results[j]);
+                }
+                current_strategy->free(w, results);
+            }
+        }
+        end_round(w);
+    }
+}
+
+static void pin_thread(int id) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(id % sysconf(_SC_NPROCESSORS_ONLN), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void *run_worker(void *arg) {
+    worker *w = arg;
+    pin_thread(w->id);
+    pthread_barrier_wait(&start_barrier);
+    current_workload(w);
+    return NULL;
+}
+
+static int compare_u64(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t *) a, y = *(const uint64_t *) b;
+    return (x > y) - (x < y);
+}
+
+static double ticks_per_ns(void) {
+    uint64_t start_ns = bench_now_ns(), start = TICKS();
+    while(bench_now_ns() - start_ns < 20000000u);
+    return (double) (TICKS() - start) / (bench_now_ns() - start_ns);
+}
+
+static void run(const char *workload_name, void (*workload)(worker *), const strategy *s, int threads, double tick_ns) {
+    current_strategy = s;
+    current_workload = workload;
+    thread_count = threads;
+    size_t max_samples = (size_t) rounds * BATCH / SAMPLE_EVERY + rounds * (threads + 1);
+    for(int i = 0; i < threads; i++) {
+        worker *w = &workers[i];
+        *w = (worker){};
+        w->id = i;
+        w->samples = malloc(max_samples * sizeof(uint64_t));
+        w->slots = malloc((BATCH > threads ? BATCH : threads) * sizeof(void *));
+        int is_packed = strstr(s->name, "packed") != NULL;
+        w->arena = is_packed ? &packed[i] : &padded[i].allocator;
+        w->double_arena = is_packed ? &packed_double[i] : &padded_double[i].allocator;
+        sa_clear(w->arena);
+        dsa_clear_bottom(w->double_arena);
+        dsa_clear_top(w->double_arena);
+    }
+    sa_clear(&shared.allocator);
+    pthread_barrier_init(&barrier, NULL, threads);
+    pthread_barrier_init(&start_barrier, NULL, threads + 1);
+
+    pthread_t handles[MAX_THREADS];
+    for(int i = 0; i < threads; i++) {
+        pthread_create(&handles[i], NULL, run_worker, &workers[i]);
+    }
+    pthread_barrier_wait(&start_barrier);
+    uint64_t start = bench_now_ns();
+    for(int i = 0; i < threads; i++) {
+        pthread_join(handles[i], NULL);
+    }
+    double elapsed = (bench_now_ns() - start) * 1e-9;
+    pthread_barrier_destroy(&barrier);
+    pthread_barrier_destroy(&start_barrier);
+
+    uint64_t allocations = 0, retries = 0;
+    size_t sample_count = 0;
+    for(int i = 0; i < threads; i++) {
+        allocations += workers[i].allocations;
+        retries += workers[i].retries;
+        sample_count += workers[i].sample_count;
+    }
+    uint64_t *samples = malloc(sample_count * sizeof(uint64_t));
+    for(int i = 0, n = 0; i < threads; i++) {
+        memcpy(samples + n, workers[i].samples, workers[i].sample_count * sizeof(uint64_t));
+        n += workers[i].sample_count;
+        free(workers[i].samples);
+        free(workers[i].slots);
+    }
+    qsort(samples, sample_count, sizeof(uint64_t), compare_u64);
+    printf("%-12s %-20s %7d %12.2f %9.1f %9.1f %9.1f %12.4f\n",
+           workload_name, s->name, threads, allocations / elapsed * 1e-6,
+           samples[sample_count / 2] / tick_ns,
+           samples[sample_count * 99 / 100] / tick_ns,
+           samples[sample_count * 999 / 1000] / tick_ns,
+           (double) retries / allocations);
+    fflush(stdout);
+    free(samples);
+}
+
+int main(int argc, char **argv) {
+    int max_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    const char *only = NULL;
+    for(int i = 1; i + 1 < argc; i += 2) {
+        if(strcmp(argv[i], "--threads") == 0) max_threads = atoi(argv[i + 1]);
+        else if(strcmp(argv[i], "--rounds") == 0) rounds = atoi(argv[i + 1]);
+        else if(strcmp(argv[i], "--workload") == 0) only = argv[i + 1];
+    }
+    if(max_threads < 1) max_threads = 1;
+    if(max_threads > MAX_THREADS) max_threads = MAX_THREADS;
+
+    size_t per_thread = BATCH * (MAX_BLOCK + 64) + MAX_THREADS * sizeof(void *);
+    for(int i = 0; i < max_threads; i++) {
+        sa_init_with_capacity(&padded[i].allocator, per_thread);
+        sa_init_with_capacity(&packed[i], per_thread);
+        dsa_init_with_capacity(&padded_double[i].allocator, per_thread);
+        dsa_init_with_capacity(&packed_double[i], per_thread);
+    }
+    sa_init_with_capacity(&shared.allocator, per_thread * max_threads);
+    pthread_mutex_init(&shared.lock, NULL);
+
+    static const struct { const char *name; void (*fn)(worker *); int min_threads; } workloads[] = {
+        { "independent", independent_workload, 1 },
+        { "prodcons", prodcons_workload, 2 },
+        { "fanout", fanout_workload, 1 },
+    };
+
+    double tick_ns = ticks_per_ns();
+    printf("%-12s %-20s %7s %12s %9s %9s %9s %12s\n",
+           "workload", "strategy", "threads", "Mallocs/s", "p50 ns", "p99 ns", "p999 ns", "retries/op");
+    for(size_t w = 0; w < sizeof(workloads) / sizeof(workloads[0]); w++) {
+        if(only && strcmp(only, workloads[w].name) != 0) continue;
+        for(int threads = workloads[w].min_threads; threads <= max_threads; threads *= 2) {
+            for(size_t s = 0; s < sizeof(strategies) / sizeof(strategies[0]); s++) {
+                run(workloads[w].name, workloads[w].fn, &strategies[s], threads, tick_ns);
+            }
+        }
+    }
+
+    for(int i = 0; i < max_threads; i++) {
+        sa_release(&padded[i].allocator);
+        sa_release(&packed[i]);
+        dsa_release(&padded_double[i].allocator);
+        dsa_release(&packed_double[i]);
+    }
+    sa_release(&shared.allocator);
+    return 0;
+}
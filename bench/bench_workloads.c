@@ -0,0 +1,455 @@
+// Benchmarks modeling real allocation patterns, comparing Stack Allocators against malloc/free:
+//
+// - parse: JSON-like documents parsed into node trees, then traversed and thrown away
+// - request: per-request handler parsing headers and building a response,
+//            clearing its arena with sa_clear after each request
+// - frame: game-style loop with level data in the bottom of a Double Stack
+//          Allocator and per-frame scratch memory in its top
+//
+// After the timing results, peak resident memory of each benchmark is
+// reported from VmHWM in /proc/self/status, reset between benchmarks by
+// writing to /proc/self/clear_refs (Linux 4.0+).
+#define _GNU_SOURCE
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION
+#include "double_stack_allocator.h"
+
+#include "bench.h"
+
+#include <malloc.h>
+
+#define DOCUMENTS 16
+#define REQUESTS 256
+#define FRAMES 256
+#define FRAMES_PER_LEVEL 64
+#define ENTITIES 4096
+
+///////////////////////////////////////////////////////////////////////////////
+// Peak RSS
+
+static void reset_peak_rss(void) {
+    malloc_trim(0);
+    FILE *file = fopen("/proc/self/clear_refs", "w");
+    if(file) {
+        fputs("5", file);
+        fclose(file);
+    }
+}
+
+static long peak_rss_kb(void) {
+    FILE *file = fopen("/proc/self/status", "r");
+    if(file == NULL) return -1;
+    char line[256];
+    long kb = -1;
+    while(fgets(line, sizeof(line), file)) {
+        if(sscanf(line, "VmHWM: %ld kB", &kb) == 1) break;
+    }
+    fclose(file);
+    return kb;
+}
+
+static struct {
+    const char *name;
+    long kb;
+} rss_results[16];
+static size_t rss_count;
+
+static void run(const char *name, bench_fn fn, void *ctx, size_t ops) {
+    if(bench_config.filter && strstr(name, bench_config.filter) == NULL) return;
+    reset_peak_rss();
+    bench_run(name, fn, ctx, ops);
+    rss_results[rss_count].name = name;
+    rss_results[rss_count].kb = peak_rss_kb();
+    rss_count++;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Allocation interface shared by the workloads
+
+typedef struct allocator {
+    void *(*alloc)(void *self, size_t size, size_t alignment);
+    void *self;
+} allocator;
+
+static void *sa_allocator_alloc(void *self, size_t size, size_t alignment) {
+    return sa_alloc_aligned((sa_stack_allocator *) self, size, alignment);
+}
+
+static void *malloc_allocator_alloc(void *self, size_t size, size_t alignment) {
+    return malloc(size);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// JSON-like parser
+
+enum node_type { NODE_NUMBER, NODE_STRING, NODE_ARRAY, NODE_OBJECT };
+
+typedef struct node {
+    enum node_type type;
+    const char *key;        // NULL unless inside an object
+    struct node *next;      // next sibling
+    union {
+        double number;
+        const char *string;
+        struct node *children;
+    };
+} node;
+
+typedef struct parser {
+    const char *cursor;
+    allocator *allocator;
+} parser;
+
+static const char *parse_string(parser *p) {
+    const char *start = ++p->cursor;
+    while(*p->cursor != '"') p->cursor++;
+    size_t length = p->cursor++ - start;
+    char *string = p->allocator->alloc(p->allocator->self, length + 1, 1);
+    memcpy(string, start, length);
+    string[length] = '\0';
+    return string;
+}
+
+static node *parse_value(parser *p) {
+    node *n = p->allocator->alloc(p->allocator->self, sizeof(node), SA_ALIGNOF(node));
+    n->key = NULL;
+    n->next = NULL;
+    char c = *p->cursor;
+    if(c == '"') {
+        n->type = NODE_STRING;
+        n->string = parse_string(p);
+    }
+    else if(c == '[' || c == '{') {
+        n->type = c == '[' ? NODE_ARRAY : NODE_OBJECT;
+        n->children = NULL;
+        node **tail = &n->children;
+        p->cursor++;
+        while(*p->cursor != ']' && *p->cursor != '}') {
+            const char *key = NULL;
+            if(n->type == NODE_OBJECT) {
+                key = parse_string(p);
+                p->cursor++;  // ':'
+            }
+            node *child = parse_value(p);
+            child->key = key;
+            *tail = child;
+            tail = &child->next;
+            if(*p->cursor == ',') p->cursor++;
+        }
+        p->cursor++;
+    }
+    else {
+        char *end;
+        n->type = NODE_NUMBER;
+        n->number = strtod(p->cursor, &end);
+        p->cursor = end;
+    }
+    return n;
+}
+
+static double sum_tree(const node *n) {
+    double sum = 0;
+    for(; n; n = n->next) {
+        if(n->key) sum += n->key[0];
+        switch(n->type) {
+            case NODE_NUMBER: sum += n->number; break;
+            case NODE_STRING: sum += n->string[0]; break;
+            default: sum += sum_tree(n->children); break;
+        }
+    }
+    return sum;
+}
+
+static void free_tree(node *n) {
+    while(n) {
+        node *next = n->next;
+        free((void *) n->key);
+        if(n->type == NODE_STRING) free((void *) n->string);
+        else if(n->type != NODE_NUMBER) free_tree(n->children);
+        free(n);
+        n = next;
+    }
+}
+
+static size_t write_document(char *out, int depth, unsigned *seed) {
+    char *start = out;
+    *out++ = '{';
+    for(int i = 0; i < 8; i++) {
+        *seed = *seed * 1103515245 + 12345;
+        out += sprintf(out, "%s\"field%u\":", i ? "," : "", *seed % 1000);
+        if(depth > 0 && i % 3 == 0) {
+            out += write_document(out, depth - 1, seed);
+        }
+        else if(i % 3 == 1) {
+            out += sprintf(out, "[%u,%u,%u,\"item\"]", *seed % 7, *seed % 11, *seed % 13);
+        }
+        else {
+            out += sprintf(out, "\"value %u\"", *seed % 100000);
+        }
+    }
+    *out++ = '}';
+    *out = '\0';
+    return out - start;
+}
+
+typedef struct parse_context {
+    char *documents[DOCUMENTS];
+    sa_stack_allocator arena;
+} parse_context;
+
+static void parse_sa(void *ctx, size_t ops) {
+    parse_context *c = ctx;
+    allocator a = { sa_allocator_alloc, &c->arena };
+    double sum = 0;
+    for(size_t i = 0; i < ops; i++) {
+        parser p = { c->documents[i % DOCUMENTS], &a };
+        sum += sum_tree(parse_value(&p));
+        sa_clear(&c->arena);
+    }
+    bench_do_not_optimize(&sum);
+}
+
+static void parse_malloc(void *ctx, size_t ops) {
+    parse_context *c = ctx;
+    allocator a = { malloc_allocator_alloc, NULL };
+    double sum = 0;
+    for(size_t i = 0; i < ops; i++) {
+        parser p = { c->documents[i % DOCUMENTS], &a };
+        node *root = parse_value(&p);
+        sum += sum_tree(root);
+        free_tree(root);
+    }
+    bench_do_not_optimize(&sum);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Per-request handler
+
+static const char request_text[] =
+    "GET /api/v1/items?page=2&sort=name HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "User-Agent: bench/1.0\r\n"
+    "Accept: application/json\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Accept-Language: en-US,en;q=0.9\r\n"
+    "Cache-Control: no-cache\r\n"
+    "Connection: keep-alive\r\n"
+    "Cookie: session=0123456789abcdef; theme=dark\r\n"
+    "\r\n";
+
+typedef struct header {
+    char *name;
+    char *value;
+    struct header *next;
+} header;
+
+static char *copy_string(allocator *a, const char *start, size_t length) {
+    char *string = a->alloc(a->self, length + 1, 1);
+    memcpy(string, start, length);
+    string[length] = '\0';
+    return string;
+}
+
+// Parse request headers and build a response body, returning its length.
+static size_t handle_request(allocator *a, header **headers_out, char **body_out) {
+    const char *line = strstr(request_text, "\r\n") + 2;
+    header *headers = NULL;
+    size_t total = 0;
+    while(line[0] != '\r') {
+        const char *colon = strchr(line, ':');
+        const char *end = strstr(colon, "\r\n");
+        header *h = a->alloc(a->self, sizeof(header), SA_ALIGNOF(header));
+        h->name = copy_string(a, line, colon - line);
+        h->value = copy_string(a, colon + 2, end - colon - 2);
+        h->next = headers;
+        headers = h;
+        total += end - line;
+        line = end + 2;
+    }
+    char *body = a->alloc(a->self, total * 2 + 64, 1);
+    size_t length = sprintf(body, "{\"headers\":[");
+    for(header *h = headers; h; h = h->next) {
+        length += sprintf(body + length, "\"%s\",", h->name);
+    }
+    body[length - 1] = ']';
+    length += sprintf(body + length, "}");
+    *headers_out = headers;
+    *body_out = body;
+    return length;
+}
+
+static void request_sa(void *ctx, size_t ops) {
+    sa_stack_allocator *arena = ctx;
+    allocator a = { sa_allocator_alloc, arena };
+    size_t total = 0;
+    for(size_t i = 0; i < ops; i++) {
+        header *headers;
+        char *body;
+        total += handle_request(&a, &headers, &body);
+        sa_clear(arena);
+    }
+    bench_do_not_optimize(&total);
+}
+
+static void request_malloc(void *ctx, size_t ops) {
+    allocator a = { malloc_allocator_alloc, NULL };
+    size_t total = 0;
+    for(size_t i = 0; i < ops; i++) {
+        header *headers;
+        char *body;
+        total += handle_request(&a, &headers, &body);
+        while(headers) {
+            header *next = headers->next;
+            free(headers->name);
+            free(headers->value);
+            free(headers);
+            headers = next;
+        }
+        free(body);
+    }
+    bench_do_not_optimize(&total);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Game frame loop
+
+typedef struct entity {
+    float x, y, vx, vy;
+    int kind;
+} entity;
+
+typedef struct level {
+    entity *entities;
+    uint8_t *tiles;     // 256x256 tile map
+} level;
+
+static void load_level(level *l, void *(*alloc)(void *, size_t), void *self, unsigned seed) {
+    l->entities = alloc(self, ENTITIES * sizeof(entity));
+    l->tiles = alloc(self, 256 * 256);
+    for(int i = 0; i < ENTITIES; i++) {
+        seed = seed * 1103515245 + 12345;
+        l->entities[i] = (entity){ seed % 256, (seed >> 8) % 256, 1, -1, seed % 4 };
+    }
+    memset(l->tiles, seed & 0xff, 256 * 256);
+}
+
+static int compare_entities(const void *a, const void *b) {
+    float x = (*(const entity **) a)->x, y = (*(const entity **) b)->x;
+    return (x > y) - (x < y);
+}
+
+// Simulate a frame, using scratch memory for the visible entity list and a tile path.
+static float run_frame(level *l, void *(*alloc)(void *, size_t), void *self, size_t frame) {
+    entity **visible = alloc(self, ENTITIES * sizeof(entity *));
+    size_t visible_count = 0;
+    for(int i = 0; i < ENTITIES; i++) {
+        entity *e = &l->entities[i];
+        e->x += e->vx * 0.1f;
+        e->y += e->vy * 0.1f;
+        if(e->kind != (int) (frame % 4)) visible[visible_count++] = e;
+    }
+    qsort(visible, visible_count, sizeof(entity *), compare_entities);
+    uint16_t *path = alloc(self, 512 * sizeof(uint16_t));
+    for(int i = 0; i < 512; i++) {
+        path[i] = l->tiles[(i * 131 + frame) & 0xffff];
+    }
+    return visible[0]->x + path[frame % 512];
+}
+
+static void *dsa_bottom_alloc(void *self, size_t size) {
+    return dsa_alloc_bottom_aligned(self, size, 16);
+}
+
+static void *dsa_top_alloc(void *self, size_t size) {
+    return dsa_alloc_top_aligned(self, size, 16);
+}
+
+// Records malloc'ed blocks so they can be freed at the end of a frame or level.
+typedef struct malloc_list {
+    void *blocks[8];
+    size_t count;
+} malloc_list;
+
+static void *malloc_list_alloc(void *self, size_t size) {
+    malloc_list *list = self;
+    return list->blocks[list->count++] = malloc(size);
+}
+
+static void malloc_list_free(malloc_list *list) {
+    for(size_t i = 0; i < list->count; i++) {
+        free(list->blocks[i]);
+    }
+    list->count = 0;
+}
+
+static void frame_dsa(void *ctx, size_t ops) {
+    dsa_double_stack_allocator *memory = ctx;
+    level l = {};
+    float sum = 0;
+    for(size_t frame = 0; frame < ops; frame++) {
+        if(frame % FRAMES_PER_LEVEL == 0) {
+            dsa_clear_bottom(memory);
+            load_level(&l, dsa_bottom_alloc, memory, frame);
+        }
+        sum += run_frame(&l, dsa_top_alloc, memory, frame);
+        dsa_clear_top(memory);
+    }
+    dsa_clear_bottom(memory);
+    bench_do_not_optimize(&sum);
+}
+
+static void frame_malloc(void *ctx, size_t ops) {
+    malloc_list level_blocks = {}, frame_blocks = {};
+    level l = {};
+    float sum = 0;
+    for(size_t frame = 0; frame < ops; frame++) {
+        if(frame % FRAMES_PER_LEVEL == 0) {
+            malloc_list_free(&level_blocks);
+            load_level(&l, malloc_list_alloc, &level_blocks, frame);
+        }
+        sum += run_frame(&l, malloc_list_alloc, &frame_blocks, frame);
+        malloc_list_free(&frame_blocks);
+    }
+    malloc_list_free(&level_blocks);
+    bench_do_not_optimize(&sum);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv) {
+    bench_init(argc, argv);
+
+    static parse_context parse;
+    unsigned seed = 42;
+    for(int i = 0; i < DOCUMENTS; i++) {
+        parse.documents[i] = malloc(1 << 20);
+        write_document(parse.documents[i], 4, &seed);
+    }
+    sa_init_with_capacity(&parse.arena, 4 << 20);
+    run("parse/sa", parse_sa, &parse, DOCUMENTS);
+    run("parse/malloc", parse_malloc, &parse, DOCUMENTS);
+    sa_release(&parse.arena);
+    for(int i = 0; i < DOCUMENTS; i++) {
+        free(parse.documents[i]);
+    }
+
+    sa_stack_allocator request_arena;
+    sa_init_with_capacity(&request_arena, 64 << 10);
+    run("request/sa", request_sa, &request_arena, REQUESTS);
+    run("request/malloc", request_malloc, NULL, REQUESTS);
+    sa_release(&request_arena);
+
+    dsa_double_stack_allocator frame_memory;
+    dsa_init_with_capacity(&frame_memory, 1 << 20);
+    run("frame/dsa", frame_dsa, &frame_memory, FRAMES);
+    run("frame/malloc", frame_malloc, NULL, FRAMES);
+    dsa_release(&frame_memory);
+
+    FILE *out = bench_config.format == BENCH_TABLE ? stdout : stderr;
+    fprintf(out, "\n%-40s %12s\n", "benchmark", "peak RSS kB");
+    for(size_t i = 0; i < rss_count; i++) {
+        fprintf(out, "%-40s %12ld\n", rss_results[i].name, rss_results[i].kb);
+    }
+    return bench_finish();
+}
@@ -0,0 +1,139 @@
+/**
+ * perf_counters.h -- Hardware performance counters for benchmarks
+ *
+ * Counts cycles, instructions, L1 data cache misses, last level cache misses,
+ * data TLB misses and branch mispredictions of the calling thread using
+ * Linux's perf_event_open.
+ *
+ * Counters that can't be opened, because of missing hardware support,
+ * virtualization, `kernel.perf_event_paranoid` or other platforms, are
+ * reported as unavailable instead of failing.
+ * Counters are opened independently, so the kernel may multiplex them when
+ * there are not enough hardware counters; values are scaled accordingly.
+ */
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __linux__
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+enum perf_counter_id {
+    PERF_CYCLES,
+    PERF_INSTRUCTIONS,
+    PERF_L1D_MISSES,
+    PERF_LLC_MISSES,
+    PERF_DTLB_MISSES,
+    PERF_BRANCH_MISSES,
+    PERF_COUNTER_COUNT,
+};
+
+static const char *const perf_counter_names[PERF_COUNTER_COUNT] = {
+    "cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses", "branch_misses",
+};
+
+typedef struct perf_counters {
+    int fds[PERF_COUNTER_COUNT];          ///< File descriptors, -1 for unavailable counters.
+    uint64_t values[PERF_COUNTER_COUNT];  ///< Counts between the last start/stop pair.
+    int available;                        ///< Number of counters that were opened.
+} perf_counters;
+
+#ifdef __linux__
+static inline int perf__open(uint32_t type, uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+#define PERF__CACHE(cache, result) \
+    ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | ((result) << 16))
+#endif
+
+/// Initialize counters with every counter unavailable, as if none could be opened.
+static inline void perf_counters_init(perf_counters *counters) {
+    memset(counters, 0, sizeof(perf_counters));
+    for(int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        counters->fds[i] = -1;
+    }
+}
+
+/// Open every supported counter for the calling thread.
+///
+/// @return Number of available counters.
+static inline int perf_counters_open(perf_counters *counters) {
+    perf_counters_init(counters);
+#ifdef __linux__
+    static const struct { uint32_t type; uint64_t config; } events[PERF_COUNTER_COUNT] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF__CACHE(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HW_CACHE, PERF__CACHE(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+    for(int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        counters->fds[i] = perf__open(events[i].type, events[i].config);
+        if(counters->fds[i] >= 0) counters->available++;
+    }
+#endif
+    return counters->available;
+}
+
+static inline void perf_counters_close(perf_counters *counters) {
+#ifdef __linux__
+    for(int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if(counters->fds[i] >= 0) close(counters->fds[i]);
+        counters->fds[i] = -1;
+    }
+#endif
+    counters->available = 0;
+}
+
+/// Reset and start counting.
+static inline void perf_counters_start(perf_counters *counters) {
+#ifdef __linux__
+    for(int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if(counters->fds[i] < 0) continue;
+        ioctl(counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+#endif
+}
+
+/// Stop counting and read values, scaled for multiplexing.
+static inline void perf_counters_stop(perf_counters *counters) {
+#ifdef __linux__
+    for(int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        if(counters->fds[i] < 0) continue;
+        ioctl(counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for(int i = 0; i < PERF_COUNTER_COUNT; i++) {
+        uint64_t data[3];  // value, time enabled, time running
+        counters->values[i] = 0;
+        if(counters->fds[i] < 0 || read(counters->fds[i], data, sizeof(data)) != sizeof(data)) continue;
+        counters->values[i] = data[2] > 0 && data[2] < data[1]
+                            ? (uint64_t) ((double) data[0] * data[1] / data[2])
+                            : data[0];
+    }
+#endif
+}
+
+/// Whether counter `id` was opened.
+static inline int perf_counter_available(const perf_counters *counters, enum perf_counter_id id) {
+    return counters->available > 0 && counters->fds[id] >= 0;
+}
+
+#endif  // PERF_COUNTERS_H
@@ -0,0 +1,408 @@
+/**
+ * bump_allocator.h -- Pointer based Bump Allocator implementation
+ *
+ * Project URL: https://github.com/gilzoide/c-allocators
+ *
+ * Do this:
+ *    #define BUMP_ALLOCATOR_IMPLEMENTATION
+ * before you include this file in *one* C or C++ file to create the implementation.
+ *
+ * i.e.:
+ *   #include ...
+ *   #include ...
+ *   #define BUMP_ALLOCATOR_IMPLEMENTATION
+ *   #include "bump_allocator.h"
+ *
+ * Bump Allocators work like Stack Allocators from stack_allocator.h, but
+ * store the current position as a pointer instead of buffer offsets, so
+ * allocating doesn't need to compute `buffer + marker` on every call.
+ * Two variants are provided:
+ *
+ * - #ba_bump_allocator bumps upwards, so memory blocks have increasing addresses.
+ * - #ba_down_allocator bumps downwards from the end of its buffer, so memory
+ *   blocks have decreasing addresses and aligning an allocation is a single AND.
+ *
+ * Markers are the number of bytes in use for both variants, just like
+ * Stack Allocator markers.
+ *
+ * Optionally provide the following defines with your own implementations:
+ *
+ * BA_MALLOC(size)  - your own malloc function (default: malloc(size))
+ * BA_FREE(p)       - your own free function (default: free(p))
+ * BA_STATIC        - if defined and BA_DECL is not defined, functions will be declared `static` instead of `extern`
+ * BA_INLINE        - if defined, functions are defined `static inline` in every file that includes this header,
+ *                    so that allocations can be inlined. BUMP_ALLOCATOR_IMPLEMENTATION is not needed then.
+ * BA_DECL          - function declaration prefix (default: `extern`, `static` or `static inline` depending on
+ *                    BA_STATIC and BA_INLINE)
+ */
+#ifndef BUMP_ALLOCATOR_H
+#define BUMP_ALLOCATOR_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef BA_DECL
+    #if defined(BA_INLINE)
+        #define BA_DECL static inline
+    #elif defined(BA_STATIC)
+        #define BA_DECL static
+    #else
+        #define BA_DECL extern
+    #endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __cplusplus
+    #define BA_ALIGNOF(type) alignof(type)
+#else
+    #define BA_ALIGNOF(type) _Alignof(type)
+#endif
+
+/// A Bump Allocator that allocates upwards.
+typedef struct ba_bump_allocator {
+    uint8_t *buffer;  ///< Memory buffer used.
+    uint8_t *cur;     ///< Next available memory block.
+    uint8_t *end;     ///< End of memory buffer.
+} ba_bump_allocator;
+
+/// A Bump Allocator that allocates downwards, from the end of its buffer.
+typedef struct ba_down_allocator {
+    uint8_t *buffer;  ///< Memory buffer used.
+    uint8_t *cur;     ///< Start of the last allocated memory block.
+    uint8_t *end;     ///< End of memory buffer.
+} ba_down_allocator;
+
+/// Helper macro to construct upwards Bump Allocators from already allocated buffer
+#define BA_NEW(buffer, capacity) \
+    ((ba_bump_allocator){ (uint8_t *) (buffer), (uint8_t *) (buffer), ((uint8_t *) (buffer)) + (capacity) })
+/// Typed version of BA_NEW
+#define BA_NEW_(buffer, type, capacity) \
+    BA_NEW((buffer), sizeof(type) * (capacity))
+
+/// Helper macro to construct downwards Bump Allocators from already allocated buffer
+#define BA_DOWN_NEW(buffer, capacity) \
+    ((ba_down_allocator){ (uint8_t *) (buffer), ((uint8_t *) (buffer)) + (capacity), ((uint8_t *) (buffer)) + (capacity) })
+/// Typed version of BA_DOWN_NEW
+#define BA_DOWN_NEW_(buffer, type, capacity) \
+    BA_DOWN_NEW((buffer), sizeof(type) * (capacity))
+
+/// Helper macro for iterating an upwards Bump Allocator, assuming all
+/// elements are of the same type.
+///
+/// Elements will be traversed in insertion order.
+/// `identifier` will be a pointer for `type` elements.
+#define BA_FOREACH(type, identifier, memory) \
+    for(type *identifier = (type *) (memory)->buffer; (uint8_t *) (identifier + 1) <= (memory)->cur; identifier++)
+
+/// Helper macro for iterating a downwards Bump Allocator, assuming all
+/// elements are of the same type and the buffer capacity is a multiple of
+/// the type size.
+///
+/// Elements will be traversed in insertion order.
+/// `identifier` will be a pointer for `type` elements.
+#define BA_DOWN_FOREACH(type, identifier, memory) \
+    for(type *identifier = ((type *) (memory)->end) - 1; (uint8_t *) identifier >= (memory)->cur; identifier--)
+
+/// Initializes an upwards Bump Allocator with a memory size, allocated with BA_MALLOC.
+///
+/// Upon failure, allocator will have a capacity of 0.
+///
+/// @return Non-zero if memory was allocated successfully.
+/// @return 0 otherwise.
+BA_DECL int ba_init_with_capacity(ba_bump_allocator *memory, size_t capacity);
+/// Typed version of ba_init_with_capacity
+#define ba_init_with_capacity_(memory, type, capacity) \
+    ba_init_with_capacity((memory), sizeof(type) * (capacity))
+
+/// Release the memory associated with an upwards Bump Allocator with BA_FREE.
+///
+/// This also zeroes out all fields in Allocator.
+BA_DECL void ba_release(ba_bump_allocator *memory);
+
+/// Allocates a sized chunk of memory from an upwards Bump Allocator.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+BA_DECL void *ba_alloc(ba_bump_allocator *memory, size_t size);
+/// Typed version of ba_alloc
+#define ba_alloc_(memory, type) \
+    ((type *) ba_alloc((memory), sizeof(type)))
+
+/// Allocates a sized chunk of memory from an upwards Bump Allocator, with
+/// address aligned to `alignment` bytes, which must be a power of two.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+BA_DECL void *ba_alloc_aligned(ba_bump_allocator *memory, size_t size, size_t alignment);
+/// Typed version of ba_alloc_aligned
+#define ba_alloc_aligned_(memory, type) \
+    ((type *) ba_alloc_aligned((memory), sizeof(type), BA_ALIGNOF(type)))
+
+/// Free all used memory from an upwards Bump Allocator.
+BA_DECL void ba_clear(ba_bump_allocator *memory);
+
+/// Get a marker for the current allocation state, the number of bytes in use.
+BA_DECL size_t ba_get_marker(ba_bump_allocator *memory);
+
+/// Free the used memory from an upwards Bump Allocator up until `marker`.
+///
+/// Memory is only freed if `marker` points to allocated memory, so invalid
+/// markers are ignored.
+BA_DECL void ba_clear_marker(ba_bump_allocator *memory, size_t marker);
+
+/// Free the last `size` bytes from an upwards Bump Allocator.
+///
+/// It's safe to pop more bytes than there are allocated.
+BA_DECL void ba_pop(ba_bump_allocator *memory, size_t size);
+/// Typed version of ba_pop
+#define ba_pop_(memory, type) \
+    ba_pop((memory), sizeof(type))
+
+/// Retrieve a pointer to the last `size` bytes allocated.
+///
+/// @return Pointer to the allocated memory, if at least `size` bytes are allocated.
+/// @return NULL otherwise.
+BA_DECL void *ba_peek(ba_bump_allocator *memory, size_t size);
+/// Typed version of ba_peek
+#define ba_peek_(memory, type) \
+    ((type *) ba_peek((memory), sizeof(type)))
+
+/// Get the quantity of free memory available in an upwards Bump Allocator.
+BA_DECL size_t ba_available_memory(ba_bump_allocator *memory);
+
+/// Get the quantity of used memory in an upwards Bump Allocator.
+BA_DECL size_t ba_used_memory(ba_bump_allocator *memory);
+
+/// Initializes a downwards Bump Allocator with a memory size, allocated with BA_MALLOC.
+///
+/// Upon failure, allocator will have a capacity of 0.
+///
+/// @return Non-zero if memory was allocated successfully.
+/// @return 0 otherwise.
+BA_DECL int ba_down_init_with_capacity(ba_down_allocator *memory, size_t capacity);
+/// Typed version of ba_down_init_with_capacity
+#define ba_down_init_with_capacity_(memory, type, capacity) \
+    ba_down_init_with_capacity((memory), sizeof(type) * (capacity))
+
+/// Release the memory associated with a downwards Bump Allocator with BA_FREE.
+///
+/// This also zeroes out all fields in Allocator.
+BA_DECL void ba_down_release(ba_down_allocator *memory);
+
+/// Allocates a sized chunk of memory from a downwards Bump Allocator.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+BA_DECL void *ba_down_alloc(ba_down_allocator *memory, size_t size);
+/// Typed version of ba_down_alloc
+#define ba_down_alloc_(memory, type) \
+    ((type *) ba_down_alloc((memory), sizeof(type)))
+
+/// Allocates a sized chunk of memory from a downwards Bump Allocator, with
+/// address aligned to `alignment` bytes, which must be a power of two.
+///
+/// Bytes skipped for alignment lie after the allocated block and are freed
+/// together with it.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+BA_DECL void *ba_down_alloc_aligned(ba_down_allocator *memory, size_t size, size_t alignment);
+/// Typed version of ba_down_alloc_aligned
+#define ba_down_alloc_aligned_(memory, type) \
+    ((type *) ba_down_alloc_aligned((memory), sizeof(type), BA_ALIGNOF(type)))
+
+/// Free all used memory from a downwards Bump Allocator.
+BA_DECL void ba_down_clear(ba_down_allocator *memory);
+
+/// Get a marker for the current allocation state, the number of bytes in use.
+BA_DECL size_t ba_down_get_marker(ba_down_allocator *memory);
+
+/// Free the used memory from a downwards Bump Allocator up until `marker`.
+///
+/// Memory is only freed if `marker` points to allocated memory, so invalid
+/// markers are ignored.
+BA_DECL void ba_down_clear_marker(ba_down_allocator *memory, size_t marker);
+
+/// Free the last `size` bytes from a downwards Bump Allocator.
+///
+/// It's safe to pop more bytes than there are allocated.
+BA_DECL void ba_down_pop(ba_down_allocator *memory, size_t size);
+/// Typed version of ba_down_pop
+#define ba_down_pop_(memory, type) \
+    ba_down_pop((memory), sizeof(type))
+
+/// Retrieve a pointer to the last `size` bytes allocated.
+///
+/// @return Pointer to the allocated memory, if at least `size` bytes are allocated.
+/// @return NULL otherwise.
+BA_DECL void *ba_down_peek(ba_down_allocator *memory, size_t size);
+/// Typed version of ba_down_peek
+#define ba_down_peek_(memory, type) \
+    ((type *) ba_down_peek((memory), sizeof(type)))
+
+/// Get the quantity of free memory available in a downwards Bump Allocator.
+BA_DECL size_t ba_down_available_memory(ba_down_allocator *memory);
+
+/// Get the quantity of used memory in a downwards Bump Allocator.
+BA_DECL size_t ba_down_used_memory(ba_down_allocator *memory);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // BUMP_ALLOCATOR_H
+
+#if defined(BA_INLINE) && !defined(BUMP_ALLOCATOR_IMPLEMENTATION)
+    #define BUMP_ALLOCATOR_IMPLEMENTATION
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(BUMP_ALLOCATOR_IMPLEMENTATION) && !defined(BUMP_ALLOCATOR_IMPLEMENTATION_INCLUDED)
+#define BUMP_ALLOCATOR_IMPLEMENTATION_INCLUDED
+
+#ifndef BA_MALLOC
+    #define BA_MALLOC(size) malloc(size)
+#endif
+#ifndef BA_FREE
+    #define BA_FREE(p) free(p)
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define BA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+    #define BA_UNLIKELY(x) (x)
+#endif
+
+BA_DECL int ba_init_with_capacity(ba_bump_allocator *memory, size_t capacity) {
+    void *buffer = BA_MALLOC(capacity);
+    int malloc_success = buffer != NULL;
+    *memory = BA_NEW(buffer, malloc_success * capacity);
+    return malloc_success;
+}
+
+BA_DECL void ba_release(ba_bump_allocator *memory) {
+    BA_FREE(memory->buffer);
+    *memory = (ba_bump_allocator){};
+}
+
+BA_DECL void *ba_alloc(ba_bump_allocator *memory, size_t size) {
+    if(BA_UNLIKELY(size > (size_t) (memory->end - memory->cur))) return NULL;
+    void *ptr = memory->cur;
+    memory->cur += size;
+    return ptr;
+}
+
+BA_DECL void *ba_alloc_aligned(ba_bump_allocator *memory, size_t size, size_t alignment) {
+    size_t padding = (size_t) (-(uintptr_t) memory->cur & (alignment - 1));
+    size_t available = memory->end - memory->cur;
+    if(BA_UNLIKELY(size > available || padding > available - size)) return NULL;
+    void *ptr = memory->cur + padding;
+    memory->cur += padding + size;
+    return ptr;
+}
+
+BA_DECL void ba_clear(ba_bump_allocator *memory) {
+    memory->cur = memory->buffer;
+}
+
+BA_DECL size_t ba_get_marker(ba_bump_allocator *memory) {
+    return memory->cur - memory->buffer;
+}
+
+BA_DECL void ba_clear_marker(ba_bump_allocator *memory, size_t marker) {
+    if(marker < (size_t) (memory->cur - memory->buffer)) {
+        memory->cur = memory->buffer + marker;
+    }
+}
+
+BA_DECL void ba_pop(ba_bump_allocator *memory, size_t size) {
+    if(size > (size_t) (memory->cur - memory->buffer)) {
+        memory->cur = memory->buffer;
+    }
+    else {
+        memory->cur -= size;
+    }
+}
+
+BA_DECL void *ba_peek(ba_bump_allocator *memory, size_t size) {
+    if(BA_UNLIKELY(size > (size_t) (memory->cur - memory->buffer))) return NULL;
+    return memory->cur - size;
+}
+
+BA_DECL size_t ba_available_memory(ba_bump_allocator *memory) {
+    return memory->end - memory->cur;
+}
+
+BA_DECL size_t ba_used_memory(ba_bump_allocator *memory) {
+    return memory->cur - memory->buffer;
+}
+
+BA_DECL int ba_down_init_with_capacity(ba_down_allocator *memory, size_t capacity) {
+    void *buffer = BA_MALLOC(capacity);
+    int malloc_success = buffer != NULL;
+    *memory = BA_DOWN_NEW(buffer, malloc_success * capacity);
+    return malloc_success;
+}
+
+BA_DECL void ba_down_release(ba_down_allocator *memory) {
+    BA_FREE(memory->buffer);
+    *memory = (ba_down_allocator){};
+}
+
+BA_DECL void *ba_down_alloc(ba_down_allocator *memory, size_t size) {
+    if(BA_UNLIKELY(size > (size_t) (memory->cur - memory->buffer))) return NULL;
+    memory->cur -= size;
+    return memory->cur;
+}
+
+BA_DECL void *ba_down_alloc_aligned(ba_down_allocator *memory, size_t size, size_t alignment) {
+    uintptr_t address = (uintptr_t) memory->cur - size;
+    // Checking for wrap around as well as the buffer start
+    if(BA_UNLIKELY(address > (uintptr_t) memory->cur)) return NULL;
+    address &= ~(uintptr_t) (alignment - 1);
+    if(BA_UNLIKELY(address < (uintptr_t) memory->buffer)) return NULL;
+    memory->cur = (uint8_t *) address;
+    return memory->cur;
+}
+
+BA_DECL void ba_down_clear(ba_down_allocator *memory) {
+    memory->cur = memory->end;
+}
+
+BA_DECL size_t ba_down_get_marker(ba_down_allocator *memory) {
+    return memory->end - memory->cur;
+}
+
+BA_DECL void ba_down_clear_marker(ba_down_allocator *memory, size_t marker) {
+    if(marker < (size_t) (memory->end - memory->cur)) {
+        memory->cur = memory->end - marker;
+    }
+}
+
+BA_DECL void ba_down_pop(ba_down_allocator *memory, size_t size) {
+    if(size > (size_t) (memory->end - memory->cur)) {
+        memory->cur = memory->end;
+    }
+    else {
+        memory->cur += size;
+    }
+}
+
+BA_DECL void *ba_down_peek(ba_down_allocator *memory, size_t size) {
+    if(BA_UNLIKELY(size > (size_t) (memory->end - memory->cur))) return NULL;
+    return memory->cur;
+}
+
+BA_DECL size_t ba_down_available_memory(ba_down_allocator *memory) {
+    return memory->cur - memory->buffer;
+}
+
+BA_DECL size_t ba_down_used_memory(ba_down_allocator *memory) {
+    return memory->end - memory->cur;
+}
+
+#endif  // BUMP_ALLOCATOR_IMPLEMENTATION
@@ -0,0 +1,636 @@
+/**
+ * compact_allocator.h -- Stack Allocators with 32-bit sizes
+ *
+ * Project URL: https://github.com/gilzoide/c-allocators
+ *
+ * Do this:
+ *    #define COMPACT_ALLOCATOR_IMPLEMENTATION
+ * before you include this file in *one* C or C++ file to create the implementation.
+ *
+ * i.e.:
+ *   #include ...
+ *   #include ...
+ *   #define COMPACT_ALLOCATOR_IMPLEMENTATION
+ *   #include "compact_allocator.h"
+ *
+ * Variants of the allocators in stack_allocator.h and double_stack_allocator.h
+ * using 32-bit capacity and markers, for embedding lots of small arenas:
+ *
+ * - #sa_stack_allocator32: 16 bytes instead of 24 on 64-bit platforms, `sa32_` prefix.
+ * - #dsa_double_stack_allocator32: 24 bytes instead of 32 on 64-bit platforms, `dsa32_` prefix.
+ * - #sa_stack_allocator32_inline: 8 byte header followed by its own buffer,
+ *   so the allocator needs a single allocation, `sa32_inline_` prefix.
+ *
+ * Functions and macros mirror the ones from the original allocators, with
+ * capacities limited to UINT32_MAX bytes.
+ *
+ * Optionally provide the following defines with your own implementations:
+ *
+ * CA_MALLOC(size)  - your own malloc function (default: malloc(size))
+ * CA_FREE(p)       - your own free function (default: free(p))
+ * CA_STATIC        - if defined and CA_DECL is not defined, functions will be declared `static` instead of `extern`
+ * CA_INLINE        - if defined, functions are defined `static inline` in every file that includes this header,
+ *                    so that allocations can be inlined. COMPACT_ALLOCATOR_IMPLEMENTATION is not needed then.
+ * CA_DECL          - function declaration prefix (default: `extern`, `static` or `static inline` depending on
+ *                    CA_STATIC and CA_INLINE)
+ */
+#ifndef COMPACT_ALLOCATOR_H
+#define COMPACT_ALLOCATOR_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef CA_DECL
+    #if defined(CA_INLINE)
+        #define CA_DECL static inline
+    #elif defined(CA_STATIC)
+        #define CA_DECL static
+    #else
+        #define CA_DECL extern
+    #endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __cplusplus
+    #define CA_ALIGNOF(type) alignof(type)
+#else
+    #define CA_ALIGNOF(type) _Alignof(type)
+#endif
+
+/// A Stack Allocator with 32-bit capacity and marker.
+typedef struct sa_stack_allocator32 {
+    void *buffer;       ///< Memory buffer used.
+    uint32_t capacity;  ///< Capacity of memory buffer.
+    uint32_t marker;    ///< Marker that points to the next available memory block.
+} sa_stack_allocator32;
+
+/// A Double Stack Allocator with 32-bit capacity and markers.
+typedef struct dsa_double_stack_allocator32 {
+    void *buffer;       ///< Memory buffer used.
+    uint32_t capacity;  ///< Capacity of memory buffer.
+    uint32_t bottom;    ///< Bottom mark, moved when allocating from the bottom.
+    uint32_t top;       ///< Top mark, moved when allocating from the top.
+} dsa_double_stack_allocator32;
+
+/// A Stack Allocator with 32-bit capacity and marker, followed by its buffer.
+///
+/// Create them with #sa32_inline_create, or place them in memory blocks of
+/// #sa32_inline_size bytes with #sa32_inline_init.
+typedef struct sa_stack_allocator32_inline {
+    uint32_t capacity;  ///< Capacity of memory buffer.
+    uint32_t marker;    ///< Marker that points to the next available memory block.
+    /// Memory buffer, aligned for any scalar type up to 8 bytes.
+    uint64_t buffer[];
+} sa_stack_allocator32_inline;
+
+/// Helper macro to construct 32-bit Stack Allocators from already allocated buffer
+#define SA32_NEW(buffer, capacity) \
+    ((sa_stack_allocator32){ (buffer), (uint32_t) (capacity), 0 })
+/// Typed version of SA32_NEW
+#define SA32_NEW_(buffer, type, capacity) \
+    SA32_NEW((buffer), sizeof(type) * (capacity))
+
+/// Helper macro to construct 32-bit Double Stack Allocators from already allocated buffer
+#define DSA32_NEW(buffer, capacity) \
+    ((dsa_double_stack_allocator32){ (buffer), (uint32_t) (capacity), 0, (uint32_t) (capacity) })
+/// Typed version of DSA32_NEW
+#define DSA32_NEW_(buffer, type, capacity) \
+    DSA32_NEW((buffer), sizeof(type) * (capacity))
+
+/// Helper macro for iterating a 32-bit Stack Allocator, assuming all elements
+/// are of the same type, in insertion order.
+#define SA32_FOREACH(type, identifier, memory) \
+    for(type *identifier = (type *) (memory)->buffer; identifier <= sa32_peek_((memory), type); identifier++)
+
+/// Helper macro for iterating a 32-bit Stack Allocator, assuming all elements
+/// are of the same type, in reverse of insertion order.
+#define SA32_FOREACH_REVERSE(type, identifier, memory) \
+    for(type *identifier = sa32_peek_((memory), type); identifier >= (type *) (memory)->buffer; identifier--)
+
+/// Helper macro for iterating an inline 32-bit Stack Allocator, assuming all
+/// elements are of the same type, in insertion order.
+#define SA32_INLINE_FOREACH(type, identifier, memory) \
+    for(type *identifier = (type *) (memory)->buffer; identifier <= sa32_inline_peek_((memory), type); identifier++)
+
+/// Helper macro for iterating an inline 32-bit Stack Allocator, assuming all
+/// elements are of the same type, in reverse of insertion order.
+#define SA32_INLINE_FOREACH_REVERSE(type, identifier, memory) \
+    for(type *identifier = sa32_inline_peek_((memory), type); identifier >= (type *) (memory)->buffer; identifier--)
+
+/// Helper macro for iterating a 32-bit Double Stack Allocator from bottom,
+/// assuming all elements are of the same type, in insertion order.
+#define DSA32_FOREACH_BOTTOM(type, identifier, memory) \
+    for(type *identifier = (type *) (memory)->buffer; identifier <= dsa32_peek_bottom_((memory), type); identifier++)
+
+/// Helper macro for iterating a 32-bit Double Stack Allocator from top,
+/// assuming all elements are of the same type, in insertion order.
+#define DSA32_FOREACH_TOP(type, identifier, memory) \
+    for(type *identifier = (type *) ((uint8_t *) (memory)->buffer + (memory)->capacity - sizeof(type)); identifier >= dsa32_peek_top_((memory), type); identifier--)
+
+// 32-bit Stack Allocator
+
+/// Initializes a 32-bit Stack Allocator with a memory size, allocated with CA_MALLOC.
+///
+/// Upon failure, allocator will have a capacity of 0.
+///
+/// @return Non-zero if memory was allocated successfully.
+/// @return 0 otherwise, including when `capacity` doesn't fit 32 bits.
+CA_DECL int sa32_init_with_capacity(sa_stack_allocator32 *memory, size_t capacity);
+/// Typed version of sa32_init_with_capacity
+#define sa32_init_with_capacity_(memory, type, capacity) \
+    sa32_init_with_capacity((memory), sizeof(type) * (capacity))
+
+/// Release the memory associated with a 32-bit Stack Allocator with CA_FREE.
+CA_DECL void sa32_release(sa_stack_allocator32 *memory);
+
+/// Allocates a sized chunk of memory from a 32-bit Stack Allocator.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+CA_DECL void *sa32_alloc(sa_stack_allocator32 *memory, size_t size);
+/// Typed version of sa32_alloc
+#define sa32_alloc_(memory, type) \
+    ((type *) sa32_alloc((memory), sizeof(type)))
+
+/// Allocates a sized chunk of memory from a 32-bit Stack Allocator, with
+/// address aligned to `alignment` bytes, which must be a power of two.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+CA_DECL void *sa32_alloc_aligned(sa_stack_allocator32 *memory, size_t size, size_t alignment);
+/// Typed version of sa32_alloc_aligned
+#define sa32_alloc_aligned_(memory, type) \
+    ((type *) sa32_alloc_aligned((memory), sizeof(type), CA_ALIGNOF(type)))
+
+/// Free all used memory from a 32-bit Stack Allocator.
+CA_DECL void sa32_clear(sa_stack_allocator32 *memory);
+
+/// Get a marker for the current allocation state.
+CA_DECL size_t sa32_get_marker(sa_stack_allocator32 *memory);
+
+/// Free the used memory from a 32-bit Stack Allocator up until `marker`.
+///
+/// Invalid markers are ignored.
+CA_DECL void sa32_clear_marker(sa_stack_allocator32 *memory, size_t marker);
+
+/// Free the last `size` bytes from a 32-bit Stack Allocator.
+///
+/// It's safe to pop more bytes than there are allocated.
+CA_DECL void sa32_pop(sa_stack_allocator32 *memory, size_t size);
+/// Typed version of sa32_pop
+#define sa32_pop_(memory, type) \
+    sa32_pop((memory), sizeof(type))
+
+/// Retrieve a pointer to the top `size` bytes allocated.
+///
+/// @return Pointer to the allocated memory, if at least `size` bytes are allocated.
+/// @return NULL otherwise.
+CA_DECL void *sa32_peek(sa_stack_allocator32 *memory, size_t size);
+/// Typed version of sa32_peek
+#define sa32_peek_(memory, type) \
+    ((type *) sa32_peek((memory), sizeof(type)))
+
+/// Get the quantity of free memory available in a 32-bit Stack Allocator.
+CA_DECL size_t sa32_available_memory(sa_stack_allocator32 *memory);
+
+/// Get the quantity of used memory in a 32-bit Stack Allocator.
+CA_DECL size_t sa32_used_memory(sa_stack_allocator32 *memory);
+
+// Inline 32-bit Stack Allocator
+
+/// Get the number of bytes needed for an inline 32-bit Stack Allocator with `capacity` bytes.
+CA_DECL size_t sa32_inline_size(size_t capacity);
+
+/// Initializes an inline 32-bit Stack Allocator in a memory block of `size` bytes.
+///
+/// `block` must be aligned to 8 bytes. Capacity is whatever is left after the header.
+///
+/// @return Allocator on success.
+/// @return NULL if `size` is smaller than the header or larger than its 32-bit capacity allows.
+CA_DECL sa_stack_allocator32_inline *sa32_inline_init(void *block, size_t size);
+
+/// Create an inline 32-bit Stack Allocator with `capacity` bytes in a single CA_MALLOC call.
+///
+/// @return Allocator on success, to be released with #sa32_inline_destroy.
+/// @return NULL if memory allocation failed or `capacity` doesn't fit 32 bits.
+CA_DECL sa_stack_allocator32_inline *sa32_inline_create(size_t capacity);
+/// Typed version of sa32_inline_create
+#define sa32_inline_create_(type, capacity) \
+    sa32_inline_create(sizeof(type) * (capacity))
+
+/// Release an inline 32-bit Stack Allocator created by #sa32_inline_create with CA_FREE.
+CA_DECL void sa32_inline_destroy(sa_stack_allocator32_inline *memory);
+
+/// Allocates a sized chunk of memory from an inline 32-bit Stack Allocator.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+CA_DECL void *sa32_inline_alloc(sa_stack_allocator32_inline *memory, size_t size);
+/// Typed version of sa32_inline_alloc
+#define sa32_inline_alloc_(memory, type) \
+    ((type *) sa32_inline_alloc((memory), sizeof(type)))
+
+/// Allocates a sized chunk of memory from an inline 32-bit Stack Allocator,
+/// with address aligned to `alignment` bytes, which must be a power of two.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+CA_DECL void *sa32_inline_alloc_aligned(sa_stack_allocator32_inline *memory, size_t size, size_t alignment);
+/// Typed version of sa32_inline_alloc_aligned
+#define sa32_inline_alloc_aligned_(memory, type) \
+    ((type *) sa32_inline_alloc_aligned((memory), sizeof(type), CA_ALIGNOF(type)))
+
+/// Free all used memory from an inline 32-bit Stack Allocator.
+CA_DECL void sa32_inline_clear(sa_stack_allocator32_inline *memory);
+
+/// Get a marker for the current allocation state.
+CA_DECL size_t sa32_inline_get_marker(sa_stack_allocator32_inline *memory);
+
+/// Free the used memory from an inline 32-bit Stack Allocator up until `marker`.
+///
+/// Invalid markers are ignored.
+CA_DECL void sa32_inline_clear_marker(sa_stack_allocator32_inline *memory, size_t marker);
+
+/// Free the last `size` bytes from an inline 32-bit Stack Allocator.
+///
+/// It's safe to pop more bytes than there are allocated.
+CA_DECL void sa32_inline_pop(sa_stack_allocator32_inline *memory, size_t size);
+/// Typed version of sa32_inline_pop
+#define sa32_inline_pop_(memory, type) \
+    sa32_inline_pop((memory), sizeof(type))
+
+/// Retrieve a pointer to the top `size` bytes allocated.
+///
+/// @return Pointer to the allocated memory, if at least `size` bytes are allocated.
+/// @return NULL otherwise.
+CA_DECL void *sa32_inline_peek(sa_stack_allocator32_inline *memory, size_t size);
+/// Typed version of sa32_inline_peek
+#define sa32_inline_peek_(memory, type) \
+    ((type *) sa32_inline_peek((memory), sizeof(type)))
+
+/// Get the quantity of free memory available in an inline 32-bit Stack Allocator.
+CA_DECL size_t sa32_inline_available_memory(sa_stack_allocator32_inline *memory);
+
+/// Get the quantity of used memory in an inline 32-bit Stack Allocator.
+CA_DECL size_t sa32_inline_used_memory(sa_stack_allocator32_inline *memory);
+
+// 32-bit Double Stack Allocator
+
+/// Initializes a 32-bit Double Stack Allocator with a memory size, allocated with CA_MALLOC.
+///
+/// Upon failure, allocator will have a capacity of 0.
+///
+/// @return Non-zero if memory was allocated successfully.
+/// @return 0 otherwise, including when `capacity` doesn't fit 32 bits.
+CA_DECL int dsa32_init_with_capacity(dsa_double_stack_allocator32 *memory, size_t capacity);
+/// Typed version of dsa32_init_with_capacity
+#define dsa32_init_with_capacity_(memory, type, capacity) \
+    dsa32_init_with_capacity((memory), sizeof(type) * (capacity))
+
+/// Release the memory associated with a 32-bit Double Stack Allocator with CA_FREE.
+CA_DECL void dsa32_release(dsa_double_stack_allocator32 *memory);
+
+/// Allocates a sized chunk of memory from the bottom of a 32-bit Double Stack Allocator.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+CA_DECL void *dsa32_alloc_bottom(dsa_double_stack_allocator32 *memory, size_t size);
+/// Typed version of dsa32_alloc_bottom
+#define dsa32_alloc_bottom_(memory, type) \
+    ((type *) dsa32_alloc_bottom((memory), sizeof(type)))
+
+/// Allocates a sized chunk of memory from the top of a 32-bit Double Stack Allocator.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+CA_DECL void *dsa32_alloc_top(dsa_double_stack_allocator32 *memory, size_t size);
+/// Typed version of dsa32_alloc_top
+#define dsa32_alloc_top_(memory, type) \
+    ((type *) dsa32_alloc_top((memory), sizeof(type)))
+
+/// Free all used memory from the bottom of a 32-bit Double Stack Allocator.
+CA_DECL void dsa32_clear_bottom(dsa_double_stack_allocator32 *memory);
+
+/// Free all used memory from the top of a 32-bit Double Stack Allocator.
+CA_DECL void dsa32_clear_top(dsa_double_stack_allocator32 *memory);
+
+/// Get a marker for the current allocation state of the bottom.
+CA_DECL size_t dsa32_get_bottom_marker(dsa_double_stack_allocator32 *memory);
+
+/// Get a marker for the current allocation state of the top.
+CA_DECL size_t dsa32_get_top_marker(dsa_double_stack_allocator32 *memory);
+
+/// Free the used memory from the bottom up until `marker`.
+///
+/// Invalid markers are ignored.
+CA_DECL void dsa32_clear_bottom_marker(dsa_double_stack_allocator32 *memory, size_t marker);
+
+/// Free the used memory from the top up until `marker`.
+///
+/// Invalid markers are ignored.
+CA_DECL void dsa32_clear_top_marker(dsa_double_stack_allocator32 *memory, size_t marker);
+
+/// Free the last `size` bytes allocated from the bottom.
+///
+/// It's safe to pop more bytes than there are allocated.
+CA_DECL void dsa32_pop_bottom(dsa_double_stack_allocator32 *memory, size_t size);
+/// Typed version of dsa32_pop_bottom
+#define dsa32_pop_bottom_(memory, type) \
+    dsa32_pop_bottom((memory), sizeof(type))
+
+/// Free the last `size` bytes allocated from the top.
+///
+/// It's safe to pop more bytes than there are allocated.
+CA_DECL void dsa32_pop_top(dsa_double_stack_allocator32 *memory, size_t size);
+/// Typed version of dsa32_pop_top
+#define dsa32_pop_top_(memory, type) \
+    dsa32_pop_top((memory), sizeof(type))
+
+/// Retrieve a pointer to the last `size` bytes allocated from the bottom.
+///
+/// @return Pointer to the allocated memory, if at least `size` bytes are allocated.
+/// @return NULL otherwise.
+CA_DECL void *dsa32_peek_bottom(dsa_double_stack_allocator32 *memory, size_t size);
+/// Typed version of dsa32_peek_bottom
+#define dsa32_peek_bottom_(memory, type) \
+    ((type *) dsa32_peek_bottom((memory), sizeof(type)))
+
+/// Retrieve a pointer to the last `size` bytes allocated from the top.
+///
+/// @return Pointer to the allocated memory, if at least `size` bytes are allocated.
+/// @return NULL otherwise.
+CA_DECL void *dsa32_peek_top(dsa_double_stack_allocator32 *memory, size_t size);
+/// Typed version of dsa32_peek_top
+#define dsa32_peek_top_(memory, type) \
+    ((type *) dsa32_peek_top((memory), sizeof(type)))
+
+/// Get the quantity of free memory available in a 32-bit Double Stack Allocator.
+CA_DECL size_t dsa32_available_memory(dsa_double_stack_allocator32 *memory);
+
+/// Get the quantity of memory allocated from the bottom.
+CA_DECL size_t dsa32_used_memory_bottom(dsa_double_stack_allocator32 *memory);
+
+/// Get the quantity of memory allocated from the top.
+CA_DECL size_t dsa32_used_memory_top(dsa_double_stack_allocator32 *memory);
+
+/// Get the total quantity of used memory in a 32-bit Double Stack Allocator.
+CA_DECL size_t dsa32_used_memory(dsa_double_stack_allocator32 *memory);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // COMPACT_ALLOCATOR_H
+
+#if defined(CA_INLINE) && !defined(COMPACT_ALLOCATOR_IMPLEMENTATION)
+    #define COMPACT_ALLOCATOR_IMPLEMENTATION
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(COMPACT_ALLOCATOR_IMPLEMENTATION) && !defined(COMPACT_ALLOCATOR_IMPLEMENTATION_INCLUDED)
+#define COMPACT_ALLOCATOR_IMPLEMENTATION_INCLUDED
+
+#ifndef CA_MALLOC
+    #define CA_MALLOC(size) malloc(size)
+#endif
+#ifndef CA_FREE
+    #define CA_FREE(p) free(p)
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define CA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+    #define CA_UNLIKELY(x) (x)
+#endif
+
+// Shared implementation of 32-bit stacks, given their buffer, capacity and marker.
+static void *ca__alloc(uint8_t *buffer, uint32_t capacity, uint32_t *marker, size_t size) {
+    if(CA_UNLIKELY(size > (size_t) (capacity - *marker))) return NULL;
+    void *ptr = buffer + *marker;
+    *marker += (uint32_t) size;
+    return ptr;
+}
+
+static void *ca__alloc_aligned(uint8_t *buffer, uint32_t capacity, uint32_t *marker, size_t size, size_t alignment) {
+    size_t padding = (size_t) (-((uintptr_t) buffer + *marker) & (alignment - 1));
+    size_t available = capacity - *marker;
+    if(CA_UNLIKELY(size > available || padding > available - size)) return NULL;
+    *marker += (uint32_t) padding;
+    void *ptr = buffer + *marker;
+    *marker += (uint32_t) size;
+    return ptr;
+}
+
+static void ca__pop(uint32_t *marker, size_t size) {
+    *marker = size > *marker ? 0 : *marker - (uint32_t) size;
+}
+
+static void *ca__peek(uint8_t *buffer, uint32_t marker, size_t size) {
+    if(CA_UNLIKELY(marker < size)) return NULL;
+    return buffer + marker - size;
+}
+
+CA_DECL int sa32_init_with_capacity(sa_stack_allocator32 *memory, size_t capacity) {
+    void *buffer = capacity <= UINT32_MAX ? CA_MALLOC(capacity) : NULL;
+    int malloc_success = buffer != NULL;
+    *memory = SA32_NEW(buffer, malloc_success * capacity);
+    return malloc_success;
+}
+
+CA_DECL void sa32_release(sa_stack_allocator32 *memory) {
+    CA_FREE(memory->buffer);
+    *memory = (sa_stack_allocator32){};
+}
+
+CA_DECL void *sa32_alloc(sa_stack_allocator32 *memory, size_t size) {
+    return ca__alloc((uint8_t *) memory->buffer, memory->capacity, &memory->marker, size);
+}
+
+CA_DECL void *sa32_alloc_aligned(sa_stack_allocator32 *memory, size_t size, size_t alignment) {
+    return ca__alloc_aligned((uint8_t *) memory->buffer, memory->capacity, &memory->marker, size, alignment);
+}
+
+CA_DECL void sa32_clear(sa_stack_allocator32 *memory) {
+    memory->marker = 0;
+}
+
+CA_DECL size_t sa32_get_marker(sa_stack_allocator32 *memory) {
+    return memory->marker;
+}
+
+CA_DECL void sa32_clear_marker(sa_stack_allocator32 *memory, size_t marker) {
+    if(marker < memory->marker) {
+        memory->marker = (uint32_t) marker;
+    }
+}
+
+CA_DECL void sa32_pop(sa_stack_allocator32 *memory, size_t size) {
+    ca__pop(&memory->marker, size);
+}
+
+CA_DECL void *sa32_peek(sa_stack_allocator32 *memory, size_t size) {
+    return ca__peek((uint8_t *) memory->buffer, memory->marker, size);
+}
+
+CA_DECL size_t sa32_available_memory(sa_stack_allocator32 *memory) {
+    return memory->capacity - memory->marker;
+}
+
+CA_DECL size_t sa32_used_memory(sa_stack_allocator32 *memory) {
+    return memory->marker;
+}
+
+CA_DECL size_t sa32_inline_size(size_t capacity) {
+    return sizeof(sa_stack_allocator32_inline) + capacity;
+}
+
+CA_DECL sa_stack_allocator32_inline *sa32_inline_init(void *block, size_t size) {
+    if(size < sizeof(sa_stack_allocator32_inline) || size - sizeof(sa_stack_allocator32_inline) > UINT32_MAX) {
+        return NULL;
+    }
+    sa_stack_allocator32_inline *memory = (sa_stack_allocator32_inline *) block;
+    memory->capacity = (uint32_t) (size - sizeof(sa_stack_allocator32_inline));
+    memory->marker = 0;
+    return memory;
+}
+
+CA_DECL sa_stack_allocator32_inline *sa32_inline_create(size_t capacity) {
+    if(capacity > UINT32_MAX) return NULL;
+    void *block = CA_MALLOC(sa32_inline_size(capacity));
+    if(block == NULL) return NULL;
+    return sa32_inline_init(block, sa32_inline_size(capacity));
+}
+
+CA_DECL void sa32_inline_destroy(sa_stack_allocator32_inline *memory) {
+    CA_FREE(memory);
+}
+
+CA_DECL void *sa32_inline_alloc(sa_stack_allocator32_inline *memory, size_t size) {
+    return ca__alloc((uint8_t *) memory->buffer, memory->capacity, &memory->marker, size);
+}
+
+CA_DECL void *sa32_inline_alloc_aligned(sa_stack_allocator32_inline *memory, size_t size, size_t alignment) {
+    return ca__alloc_aligned((uint8_t *) memory->buffer, memory->capacity, &memory->marker, size, alignment);
+}
+
+CA_DECL void sa32_inline_clear(sa_stack_allocator32_inline *memory) {
+    memory->marker = 0;
+}
+
+CA_DECL size_t sa32_inline_get_marker(sa_stack_allocator32_inline *memory) {
+    return memory->marker;
+}
+
+CA_DECL void sa32_inline_clear_marker(sa_stack_allocator32_inline *memory, size_t marker) {
+    if(marker < memory->marker) {
+        memory->marker = (uint32_t) marker;
+    }
+}
+
+CA_DECL void sa32_inline_pop(sa_stack_allocator32_inline *memory, size_t size) {
+    ca__pop(&memory->marker, size);
+}
+
+CA_DECL void *sa32_inline_peek(sa_stack_allocator32_inline *memory, size_t size) {
+    return ca__peek((uint8_t *) memory->buffer, memory->marker, size);
+}
+
+CA_DECL size_t sa32_inline_available_memory(sa_stack_allocator32_inline *memory) {
+    return memory->capacity - memory->marker;
+}
+
+CA_DECL size_t sa32_inline_used_memory(sa_stack_allocator32_inline *memory) {
+    return memory->marker;
+}
+
+CA_DECL int dsa32_init_with_capacity(dsa_double_stack_allocator32 *memory, size_t capacity) {
+    void *buffer = capacity <= UINT32_MAX ? CA_MALLOC(capacity) : NULL;
+    int malloc_success = buffer != NULL;
+    *memory = DSA32_NEW(buffer, malloc_success * capacity);
+    return malloc_success;
+}
+
+CA_DECL void dsa32_release(dsa_double_stack_allocator32 *memory) {
+    CA_FREE(memory->buffer);
+    *memory = (dsa_double_stack_allocator32){};
+}
+
+CA_DECL void *dsa32_alloc_bottom(dsa_double_stack_allocator32 *memory, size_t size) {
+    if(CA_UNLIKELY(size > (size_t) (memory->top - memory->bottom))) return NULL;
+    void *ptr = ((uint8_t *) memory->buffer) + memory->bottom;
+    memory->bottom += (uint32_t) size;
+    return ptr;
+}
+
+CA_DECL void *dsa32_alloc_top(dsa_double_stack_allocator32 *memory, size_t size) {
+    if(CA_UNLIKELY(size > (size_t) (memory->top - memory->bottom))) return NULL;
+    memory->top -= (uint32_t) size;
+    return ((uint8_t *) memory->buffer) + memory->top;
+}
+
+CA_DECL void dsa32_clear_bottom(dsa_double_stack_allocator32 *memory) {
+    memory->bottom = 0;
+}
+
+CA_DECL void dsa32_clear_top(dsa_double_stack_allocator32 *memory) {
+    memory->top = memory->capacity;
+}
+
+CA_DECL size_t dsa32_get_bottom_marker(dsa_double_stack_allocator32 *memory) {
+    return memory->bottom;
+}
+
+CA_DECL size_t dsa32_get_top_marker(dsa_double_stack_allocator32 *memory) {
+    return memory->top;
+}
+
+CA_DECL void dsa32_clear_bottom_marker(dsa_double_stack_allocator32 *memory, size_t marker) {
+    if(marker < memory->bottom) {
+        memory->bottom = (uint32_t) marker;
+    }
+}
+
+CA_DECL void dsa32_clear_top_marker(dsa_double_stack_allocator32 *memory, size_t marker) {
+    if(marker > memory->top && marker <= memory->capacity) {
+        memory->top = (uint32_t) marker;
+    }
+}
+
+CA_DECL void dsa32_pop_bottom(dsa_double_stack_allocator32 *memory, size_t size) {
+    ca__pop(&memory->bottom, size);
+}
+
+CA_DECL void dsa32_pop_top(dsa_double_stack_allocator32 *memory, size_t size) {
+    memory->top = size > (size_t) (memory->capacity - memory->top) ? memory->capacity : memory->top + (uint32_t) size;
+}
+
+CA_DECL void *dsa32_peek_bottom(dsa_double_stack_allocator32 *memory, size_t size) {
+    return ca__peek((uint8_t *) memory->buffer, memory->bottom, size);
+}
+
+CA_DECL void *dsa32_peek_top(dsa_double_stack_allocator32 *memory, size_t size) {
+    if(CA_UNLIKELY(memory->capacity - memory->top < size)) return NULL;
+    return ((uint8_t *) memory->buffer) + memory->top;
+}
+
+CA_DECL size_t dsa32_available_memory(dsa_double_stack_allocator32 *memory) {
+    return memory->top - memory->bottom;
+}
+
+CA_DECL size_t dsa32_used_memory_bottom(dsa_double_stack_allocator32 *memory) {
+    return memory->bottom;
+}
+
+CA_DECL size_t dsa32_used_memory_top(dsa_double_stack_allocator32 *memory) {
+    return memory->capacity - memory->top;
+}
+
+CA_DECL size_t dsa32_used_memory(dsa_double_stack_allocator32 *memory) {
+    return dsa32_used_memory_bottom(memory) + dsa32_used_memory_top(memory);
+}
+
+#endif  // COMPACT_ALLOCATOR_IMPLEMENTATION
@@ -0,0 +1,225 @@
+/**
+ * coroutine_frame_allocator.hpp -- C++20 coroutine frames allocated from thread local Stack Allocators
+ *
+ * Project URL: https://github.com/gilzoide/c-allocators
+ *
+ * Do this:
+ *    #define COROUTINE_FRAME_ALLOCATOR_IMPLEMENTATION
+ * before you include this file in *one* C++ file to create the implementation.
+ *
+ * i.e.:
+ *   #include ...
+ *   #include ...
+ *   #define COROUTINE_FRAME_ALLOCATOR_IMPLEMENTATION
+ *   #include "coroutine_frame_allocator.hpp"
+ *
+ * This file uses stack_allocator.h, whose implementation must also be
+ * created in some C or C++ file.
+ *
+ * Optionally provide the following defines with your own implementations:
+ *
+ * SA_COROUTINE_FRAME_CAPACITY     - capacity in bytes of each thread's frame stack (default: 1 MiB)
+ * SA_COROUTINE_FRAME_GRANULARITY  - frame sizes are rounded up to a multiple of this, must be a multiple of 16 (default: 64)
+ * SA_COROUTINE_FRAME_CLASSES      - number of frame sizes kept in pool for out of order frees (default: 32)
+ */
+#ifndef COROUTINE_FRAME_ALLOCATOR_HPP
+#define COROUTINE_FRAME_ALLOCATOR_HPP
+
+#include <cstddef>
+
+#include "stack_allocator.h"
+
+namespace sa {
+
+/// Allocate a coroutine frame from the current thread's frame stack.
+///
+/// Frames are pushed to a Stack Allocator owned by the current thread.
+/// Frames freed in LIFO order are popped from it, while frames freed out
+/// of order are kept in a pool for reuse by frames of the same size.
+/// Whenever every frame from a thread is freed, its stack is cleared.
+///
+/// Frames bigger than the pooled sizes or that don't fit the stack are
+/// allocated with `::operator new`.
+void *coroutine_frame_allocate(std::size_t size);
+
+/// Free a frame allocated by #coroutine_frame_allocate.
+///
+/// Frames may be freed by any thread. Frames freed by a thread other than
+/// the one that allocated them are handed back to their owner thread,
+/// which reuses them on its next allocation.
+void coroutine_frame_deallocate(void *frame) noexcept;
+
+/// Get the current thread's frame stack, creating it if needed.
+const sa_stack_allocator *coroutine_frame_stack();
+
+/// Mixin for coroutine promise types, making coroutine frames be allocated
+/// with #coroutine_frame_allocate.
+///
+/// i.e.:
+///   struct promise_type : sa::coroutine_frame_promise {
+///       ...
+///   };
+struct coroutine_frame_promise {
+    static void *operator new(std::size_t size) {
+        return coroutine_frame_allocate(size);
+    }
+
+    static void operator delete(void *frame) noexcept {
+        coroutine_frame_deallocate(frame);
+    }
+};
+
+}
+
+#endif  // COROUTINE_FRAME_ALLOCATOR_HPP
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef COROUTINE_FRAME_ALLOCATOR_IMPLEMENTATION
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+#ifndef SA_COROUTINE_FRAME_CAPACITY
+    #define SA_COROUTINE_FRAME_CAPACITY (1024 * 1024)
+#endif
+#ifndef SA_COROUTINE_FRAME_GRANULARITY
+    #define SA_COROUTINE_FRAME_GRANULARITY 64
+#endif
+#ifndef SA_COROUTINE_FRAME_CLASSES
+    #define SA_COROUTINE_FRAME_CLASSES 32
+#endif
+
+namespace sa {
+namespace detail {
+
+struct coroutine_frame_arena;
+
+// Header stored right before each frame.
+struct alignas(16) coroutine_frame_header {
+    coroutine_frame_arena *owner;  // NULL for frames allocated with `::operator new`
+    std::size_t size_class;
+};
+
+struct coroutine_frame_arena {
+    sa_stack_allocator stack;
+    std::size_t live;
+    coroutine_frame_header *pool[SA_COROUTINE_FRAME_CLASSES];
+    std::atomic<coroutine_frame_header *> remote;
+};
+
+// Freed frames are linked through their first bytes after the header.
+static coroutine_frame_header *&coroutine_frame_next(coroutine_frame_header *header) {
+    return *reinterpret_cast<coroutine_frame_header **>(header + 1);
+}
+
+static void coroutine_frame_release_local(coroutine_frame_arena *arena, coroutine_frame_header *header) {
+    if(--arena->live == 0) {
+        sa_clear(&arena->stack);
+        for(std::size_t i = 0; i < SA_COROUTINE_FRAME_CLASSES; i++) {
+            arena->pool[i] = nullptr;
+        }
+        return;
+    }
+    std::size_t size = (header->size_class + 1) * SA_COROUTINE_FRAME_GRANULARITY;
+    if(reinterpret_cast<std::uint8_t *>(header) + size == sa_peek(&arena->stack, 0)) {
+        sa_pop(&arena->stack, size);
+    }
+    else {
+        coroutine_frame_next(header) = arena->pool[header->size_class];
+        arena->pool[header->size_class] = header;
+    }
+}
+
+static void coroutine_frame_drain_remote(coroutine_frame_arena *arena) {
+    coroutine_frame_header *header = arena->remote.exchange(nullptr, std::memory_order_acquire);
+    while(header != nullptr) {
+        coroutine_frame_header *next = coroutine_frame_next(header);
+        coroutine_frame_release_local(arena, header);
+        header = next;
+    }
+}
+
+struct coroutine_frame_arena_owner {
+    coroutine_frame_arena *arena = nullptr;
+
+    coroutine_frame_arena *get() {
+        if(arena == nullptr) {
+            arena = new coroutine_frame_arena();
+            sa_init_with_capacity(&arena->stack, SA_COROUTINE_FRAME_CAPACITY);
+        }
+        return arena;
+    }
+
+    ~coroutine_frame_arena_owner() {
+        if(arena == nullptr) return;
+        coroutine_frame_drain_remote(arena);
+        // Frames still alive in other threads keep the arena alive forever.
+        if(arena->live == 0) {
+            sa_release(&arena->stack);
+            delete arena;
+        }
+    }
+};
+
+static thread_local coroutine_frame_arena_owner coroutine_frame_current;
+
+}
+
+void *coroutine_frame_allocate(std::size_t size) {
+    using namespace detail;
+    std::size_t total = (size + sizeof(coroutine_frame_header) + SA_COROUTINE_FRAME_GRANULARITY - 1)
+                      / SA_COROUTINE_FRAME_GRANULARITY * SA_COROUTINE_FRAME_GRANULARITY;
+    std::size_t size_class = total / SA_COROUTINE_FRAME_GRANULARITY - 1;
+    coroutine_frame_arena *arena = coroutine_frame_current.get();
+    coroutine_frame_header *header = nullptr;
+    if(size_class < SA_COROUTINE_FRAME_CLASSES) {
+        if(arena->remote.load(std::memory_order_relaxed) != nullptr) {
+            coroutine_frame_drain_remote(arena);
+        }
+        header = arena->pool[size_class];
+        if(header != nullptr) {
+            arena->pool[size_class] = coroutine_frame_next(header);
+        }
+        else {
+            header = static_cast<coroutine_frame_header *>(sa_alloc(&arena->stack, total));
+        }
+    }
+    if(header != nullptr) {
+        arena->live++;
+        header->owner = arena;
+        header->size_class = size_class;
+    }
+    else {
+        header = static_cast<coroutine_frame_header *>(::operator new(sizeof(coroutine_frame_header) + size));
+        header->owner = nullptr;
+    }
+    return header + 1;
+}
+
+void coroutine_frame_deallocate(void *frame) noexcept {
+    using namespace detail;
+    coroutine_frame_header *header = static_cast<coroutine_frame_header *>(frame) - 1;
+    coroutine_frame_arena *owner = header->owner;
+    if(owner == nullptr) {
+        ::operator delete(header);
+    }
+    else if(owner == coroutine_frame_current.arena) {
+        coroutine_frame_release_local(owner, header);
+    }
+    else {
+        coroutine_frame_header *next = owner->remote.load(std::memory_order_relaxed);
+        do {
+            coroutine_frame_next(header) = next;
+        } while(!owner->remote.compare_exchange_weak(next, header, std::memory_order_release, std::memory_order_relaxed));
+    }
+}
+
+const sa_stack_allocator *coroutine_frame_stack() {
+    return &detail::coroutine_frame_current.get()->stack;
+}
+
+}
+
+#endif  // COROUTINE_FRAME_ALLOCATOR_IMPLEMENTATION
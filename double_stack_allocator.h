@@ -18,7 +18,26 @@
  * DSA_MALLOC(size)  - your own malloc function (default: malloc(size))
  * DSA_FREE(p)       - your own free function (default: free(p))
  * DSA_STATIC        - if defined and DSA_DECL is not defined, functions will be declared `static` instead of `extern`
- * DSA_DECL          - function declaration prefix (default: `extern` or `static` depending on DSA_STATIC)
+ * DSA_INLINE        - if defined, functions are defined `static inline` in every file that includes this header,
+ *                     so that allocations can be inlined. DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION is not needed then.
+ * DSA_DECL          - function declaration prefix (default: `extern`, `static` or `static inline` depending on
+ *                     DSA_STATIC and DSA_INLINE)
+ * DSA_STATS         - if defined, gathers allocation statistics, queried with #dsa_get_stats.
+ *                     Must be defined equally in every file that includes this header.
+ * DSA_OVERFLOW      - if defined, enables overflow handlers set with #dsa_set_overflow_handler.
+ *                     Must be defined equally in every file that includes this header.
+ * DSA_MARKER_STACK  - if defined, enables marker stacks kept in bottom memory with #dsa_push_marker.
+ *                     Must be defined equally in every file that includes this header.
+ * DSA_TRACE(event, memory, size, used)
+ *                   - called after allocations and frees, with `event` being one of the tokens
+ *                     DSA_ALLOC_BOTTOM, DSA_ALLOC_TOP, DSA_ALLOC_BOTTOM_FAILED, DSA_ALLOC_TOP_FAILED,
+ *                     DSA_POP_BOTTOM, DSA_POP_TOP, DSA_CLEAR_BOTTOM_MARKER, DSA_CLEAR_TOP_MARKER or
+ *                     DSA_RELEASE, `size` the number of bytes requested or freed and `used` the resulting
+ *                     memory used on that end, or on both ends for DSA_RELEASE (default: nothing).
+ *                     alloc_trace.h provides an implementation that records events to a file.
+ *
+ * If stack_allocator.h is included before this file, Stack Allocators may be
+ * carved from either end with #dsa_child_begin_bottom and #dsa_child_begin_top.
  */
 #ifndef DOUBLE_STACK_ALLOCATOR_H
 #define DOUBLE_STACK_ALLOCATOR_H
@@ -26,7 +45,9 @@
 #include <stdlib.h>
 
 #ifndef DSA_DECL
-    #ifdef DSA_STATIC
+    #if defined(DSA_INLINE)
+        #define DSA_DECL static inline
+    #elif defined(DSA_STATIC)
         #define DSA_DECL static
     #else
         #define DSA_DECL extern
@@ -37,6 +58,56 @@
 extern "C" {
 #endif
 
+#ifdef __cplusplus
+    #define DSA_ALIGNOF(type) alignof(type)
+#else
+    #define DSA_ALIGNOF(type) _Alignof(type)
+#endif
+
+#ifdef DSA_STATS
+/// Number of buckets in the allocation size histogram.
+#define DSA_STATS_BUCKETS (sizeof(size_t) * 8 + 1)
+
+/// Allocation statistics of a Double Stack Allocator.
+typedef struct dsa_stats {
+    size_t peak;                ///< Highest total memory usage.
+    size_t peak_bottom;         ///< Highest memory usage on bottom.
+    size_t peak_top;            ///< Highest memory usage on top.
+    size_t allocations;         ///< Number of successful allocations, from both ends.
+    size_t failed_allocations;  ///< Number of allocations that returned NULL, from both ends.
+    size_t alignment_waste;     ///< Bytes skipped for aligning allocations.
+    /// Successful allocations by size: bucket 0 counts empty allocations,
+    /// bucket `i` counts sizes from `2^(i-1)` up to `2^i - 1`.
+    size_t size_histogram[DSA_STATS_BUCKETS];
+} dsa_stats;
+#endif
+
+#ifdef DSA_OVERFLOW
+/// Function that allocates `size` bytes from an upstream allocator, aligned like `malloc`.
+typedef void *(*dsa_overflow_alloc_fn)(void *ctx, size_t size);
+/// Function that frees memory returned by a #dsa_overflow_alloc_fn.
+typedef void (*dsa_overflow_free_fn)(void *ctx, void *ptr);
+
+/// Header of a block spilled to the overflow handler, stored before the block itself.
+typedef struct dsa_spill {
+    struct dsa_spill *previous;  ///< Previously spilled block from the same end.
+    size_t marker;               ///< Memory used from its end before the block was spilled, counting older spills.
+} dsa_spill;
+
+/// Overflow handler and spilled blocks of a Double Stack Allocator.
+typedef struct dsa_overflow {
+    dsa_overflow_alloc_fn alloc;  ///< Upstream allocation function, NULL if disabled.
+    dsa_overflow_free_fn free;    ///< Upstream free function.
+    void *ctx;                    ///< Argument passed to `alloc` and `free`.
+    dsa_spill *bottom_spills;     ///< Last block spilled from bottom that was not freed yet.
+    dsa_spill *top_spills;        ///< Last block spilled from top that was not freed yet.
+    size_t live_bottom_spills;    ///< Number of blocks spilled from bottom not freed yet, counted in bottom markers.
+    size_t live_top_spills;       ///< Number of blocks spilled from top not freed yet, counted in top markers.
+    size_t spill_count;           ///< Number of allocations spilled since the handler was set, from both ends.
+    size_t spilled_bytes;         ///< Bytes requested by allocations spilled since the handler was set.
+} dsa_overflow;
+#endif
+
 /// Custom memory manager: a Double Stack Allocator.
 /// 
 /// Memory blocks pushed from bottom have increasing addresses.
@@ -48,8 +119,23 @@ typedef struct dsa_double_stack_allocator {
     size_t capacity;  ///< Capacity of memory buffer
     size_t bottom;    ///< Bottom mark, moved when allocating from the bottom
     size_t top;       ///< Top mark, moved when allocating from the top
+#ifdef DSA_MARKER_STACK
+    size_t marker_stack;  ///< Position of the last marker pushed with #dsa_push_marker biased by one, 0 if there is none
+#endif
+#ifdef DSA_STATS
+    dsa_stats stats;  ///< Allocation statistics
+#endif
+#ifdef DSA_OVERFLOW
+    dsa_overflow overflow;  ///< Overflow handler and spilled blocks
+#endif
 } dsa_double_stack_allocator;
 
+/// Allocation state of both ends of a Double Stack Allocator.
+typedef struct dsa_marker {
+    size_t bottom;  ///< Bottom marker
+    size_t top;     ///< Top marker
+} dsa_marker;
+
 /// Helper macro to construct Double Stack Allocators from already allocated buffer
 #define DSA_NEW(buffer, capacity) \
     ((dsa_double_stack_allocator){ (buffer), (capacity), 0, (capacity) })
@@ -140,6 +226,32 @@ DSA_DECL void *dsa_alloc_top(dsa_double_stack_allocator *memory, size_t size);
 #define dsa_alloc_top_(memory, type) \
     ((type *) dsa_alloc_top((memory), sizeof(type)))
 
+/// Allocates a sized chunk of memory from bottom of Double Stack Allocator,
+/// with address aligned to `alignment` bytes.
+/// 
+/// `alignment` must be a power of two.
+/// Bytes skipped for alignment are freed together with the allocated block.
+/// 
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+DSA_DECL void *dsa_alloc_bottom_aligned(dsa_double_stack_allocator *memory, size_t size, size_t alignment);
+/// Typed version of dsa_alloc_bottom_aligned
+#define dsa_alloc_bottom_aligned_(memory, type) \
+    ((type *) dsa_alloc_bottom_aligned((memory), sizeof(type), DSA_ALIGNOF(type)))
+
+/// Allocates a sized chunk of memory from top of Double Stack Allocator,
+/// with address aligned to `alignment` bytes.
+/// 
+/// `alignment` must be a power of two.
+/// Bytes skipped for alignment are freed together with the allocated block.
+/// 
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+DSA_DECL void *dsa_alloc_top_aligned(dsa_double_stack_allocator *memory, size_t size, size_t alignment);
+/// Typed version of dsa_alloc_top_aligned
+#define dsa_alloc_top_aligned_(memory, type) \
+    ((type *) dsa_alloc_top_aligned((memory), sizeof(type), DSA_ALIGNOF(type)))
+
 // Aliases for Stack implementation semantics.
 #define dsa_push_bottom dsa_alloc_bottom
 #define dsa_push_bottom_ dsa_alloc_bottom_
@@ -165,11 +277,15 @@ DSA_DECL void dsa_clear_top(dsa_double_stack_allocator *memory);
 /// Get a marker for the current bottom allocation state.
 /// 
 /// The result can be used for freeing a Double Stack Allocator back to this state.
+/// Blocks spilled with #dsa_set_overflow_handler count as one byte each, so
+/// markers got before and after a spill differ.
 DSA_DECL size_t dsa_get_bottom_marker(dsa_double_stack_allocator *memory);
 
 /// Get a marker for the current top allocation state.
 /// 
 /// The result can be used for freeing a Double Stack Allocator back to this state.
+/// Blocks spilled with #dsa_set_overflow_handler count as one byte each, so
+/// markers got before and after a spill differ.
 DSA_DECL size_t dsa_get_top_marker(dsa_double_stack_allocator *memory);
 
 /// Free the used memory from Double Stack Allocator bottom up until `marker`,
@@ -194,6 +310,36 @@ DSA_DECL void dsa_clear_bottom_marker(dsa_double_stack_allocator *memory, size_t
 /// To actually reclaim the used memory for the OS, use #dsa_release instead.
 DSA_DECL void dsa_clear_top_marker(dsa_double_stack_allocator *memory, size_t marker);
 
+/// Get a marker for the current allocation state of both ends.
+/// 
+/// The result can be used for freeing a Double Stack Allocator back to this state.
+DSA_DECL dsa_marker dsa_get_marker(dsa_double_stack_allocator *memory);
+
+/// Free the used memory from both ends of Double Stack Allocator up until
+/// `marker`, making it available for allocation once more.
+/// 
+/// Each end is freed like #dsa_clear_bottom_marker and #dsa_clear_top_marker.
+DSA_DECL void dsa_clear_to_marker(dsa_double_stack_allocator *memory, dsa_marker marker);
+
+#ifdef DSA_MARKER_STACK
+/// Save the current marker of both ends in the Double Stack Allocator itself.
+///
+/// Markers are pushed on a stack stored in bottom memory, so deep recursion
+/// can checkpoint without caller-side storage.
+/// Freeing bottom memory past a pushed marker also discards it.
+///
+/// @return Non-zero if the marker was pushed.
+/// @return 0 if not enought memory is available.
+DSA_DECL int dsa_push_marker(dsa_double_stack_allocator *memory);
+
+/// Free the used memory from both ends of Double Stack Allocator up until
+/// the last marker pushed with #dsa_push_marker, discarding it.
+///
+/// @return Non-zero if a marker was popped.
+/// @return 0 if there are no pushed markers.
+DSA_DECL int dsa_pop_marker(dsa_double_stack_allocator *memory);
+#endif
+
 /// Free the last `size` bytes from bottom of Stack Allocator.
 ///
 /// It's safe to pop more bytes than there are allocated.
@@ -230,6 +376,30 @@ DSA_DECL void *dsa_peek_top(dsa_double_stack_allocator *memory, size_t size);
 #define dsa_peek_top_(memory, type) \
     ((type *) dsa_peek_top((memory), sizeof(type)))
 
+/// Move the last `size` bytes allocated from top to bottom, as if they were
+/// popped from top and allocated from bottom, without needing free memory for a copy.
+///
+/// Bytes are moved with `memmove`, unless there is no free memory between
+/// both ends, when they already are where the bottom allocation goes.
+/// The moved block is not aligned, so use #dsa_alloc_bottom_aligned with
+/// size 0 beforehand if needed.
+///
+/// @return Pointer to the moved memory on success.
+/// @return NULL if less than `size` bytes are allocated from top.
+DSA_DECL void *dsa_promote_top_to_bottom(dsa_double_stack_allocator *memory, size_t size);
+
+/// Move the last `size` bytes allocated from bottom to top, as if they were
+/// popped from bottom and allocated from top, without needing free memory for a copy.
+///
+/// Bytes are moved with `memmove`, unless there is no free memory between
+/// both ends, when they already are where the top allocation goes.
+/// The moved block is not aligned, so use #dsa_alloc_top_aligned with
+/// size 0 beforehand if needed.
+///
+/// @return Pointer to the moved memory on success.
+/// @return NULL if less than `size` bytes are allocated from bottom.
+DSA_DECL void *dsa_demote_bottom_to_top(dsa_double_stack_allocator *memory, size_t size);
+
 /// Get the quantity of free memory available in a Double Stack Allocator
 DSA_DECL size_t dsa_available_memory(dsa_double_stack_allocator *memory);
 
@@ -248,17 +418,112 @@ DSA_DECL size_t dsa_used_memory_top(dsa_double_stack_allocator *memory);
 /// Get the total quantity of used allocated in a Double Stack Allocator
 DSA_DECL size_t dsa_used_memory(dsa_double_stack_allocator *memory);
 
+#ifdef STACK_ALLOCATOR_H
+/// Initializes `child` as a Stack Allocator using `capacity` bytes allocated from bottom.
+///
+/// Until the child is finished with #dsa_child_end_bottom or
+/// #dsa_child_commit_bottom, bottom must not be allocated from or freed past
+/// the child's buffer.
+///
+/// Upon failure, `child` will have a capacity of 0.
+///
+/// @return Non-zero if the child was created successfully.
+/// @return 0 if not enought memory is available.
+DSA_DECL int dsa_child_begin_bottom(dsa_double_stack_allocator *memory, sa_stack_allocator *child, size_t capacity);
+
+/// Initializes `child` as a Stack Allocator using `capacity` bytes allocated from top.
+///
+/// Until the child is finished with #dsa_child_end_top or
+/// #dsa_child_commit_top, top must not be allocated from or freed past
+/// the child's buffer.
+///
+/// Upon failure, `child` will have a capacity of 0.
+///
+/// @return Non-zero if the child was created successfully.
+/// @return 0 if not enought memory is available.
+DSA_DECL int dsa_child_begin_top(dsa_double_stack_allocator *memory, sa_stack_allocator *child, size_t capacity);
+
+/// Free all memory used by a child created with #dsa_child_begin_bottom, returning its buffer to bottom.
+///
+/// The child is cleared with #sa_clear first, so its cleanup entries run.
+/// This also zeroes out all fields in `child`.
+DSA_DECL void dsa_child_end_bottom(dsa_double_stack_allocator *memory, sa_stack_allocator *child);
+
+/// Free all memory used by a child created with #dsa_child_begin_top, returning its buffer to top.
+///
+/// The child is cleared with #sa_clear first, so its cleanup entries run.
+/// This also zeroes out all fields in `child`.
+DSA_DECL void dsa_child_end_top(dsa_double_stack_allocator *memory, sa_stack_allocator *child);
+
+/// Keep the memory used by a child created with #dsa_child_begin_bottom as
+/// a single bottom allocation, returning only its unused memory.
+///
+/// This also zeroes out all fields in `child`.
+///
+/// @return Pointer to the kept memory, the child's buffer.
+/// @return NULL if `child` has cleanup entries or spilled blocks, which the
+///         Double Stack Allocator can't take over. `child` is left intact.
+DSA_DECL void *dsa_child_commit_bottom(dsa_double_stack_allocator *memory, sa_stack_allocator *child);
+
+/// Keep the memory used by a child created with #dsa_child_begin_top as
+/// a single top allocation, returning only its unused memory.
+///
+/// Since top allocations grow downwards, the used memory is moved up against
+/// the previous top allocations with `memmove`, so pointers into the child
+/// become invalid.
+///
+/// This also zeroes out all fields in `child`.
+///
+/// @return Pointer to the kept memory, where the child's used memory was moved to.
+/// @return NULL if `child` has cleanup entries or spilled blocks, which the
+///         Double Stack Allocator can't take over. `child` is left intact.
+DSA_DECL void *dsa_child_commit_top(dsa_double_stack_allocator *memory, sa_stack_allocator *child);
+#endif
+
+#ifdef DSA_OVERFLOW
+/// Set a handler that supplies memory from an upstream allocator when the
+/// Double Stack Allocator's buffer is full, instead of returning NULL.
+///
+/// Spilled blocks are tracked with a small header and freed with `free_fn`
+/// when clearing their end past the point they were allocated, or by
+/// #dsa_release. Pops and moves between ends don't free them.
+/// Spills are counted in the `overflow` field, to help sizing buffers.
+///
+/// Memory that must live in the buffer is never spilled: pushed markers and children.
+/// Pass NULL `alloc_fn` to disable spilling.
+///
+/// @warning The handler must not be changed while there are spilled blocks.
+DSA_DECL void dsa_set_overflow_handler(dsa_double_stack_allocator *memory, dsa_overflow_alloc_fn alloc_fn, dsa_overflow_free_fn free_fn, void *ctx);
+#endif
+
+#ifdef DSA_STATS
+/// Get the allocation statistics gathered since the allocator was created
+/// or since the last #dsa_reset_stats.
+DSA_DECL const dsa_stats *dsa_get_stats(dsa_double_stack_allocator *memory);
+
+/// Reset allocation statistics.
+/// 
+/// Peak usages start over from the current memory usage.
+DSA_DECL void dsa_reset_stats(dsa_double_stack_allocator *memory);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
 
 #endif  // __DOUBLE_STACK_ALLOCATOR_H__
 
+#if defined(DSA_INLINE) && !defined(DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION)
+    #define DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 
-#ifdef DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION
+#if defined(DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION) && !defined(DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION_INCLUDED)
+#define DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION_INCLUDED
 
 #include <stdint.h>
+#include <string.h>
 
 #ifndef DSA_MALLOC
     #define DSA_MALLOC(size) malloc(size)
@@ -267,6 +532,214 @@ DSA_DECL size_t dsa_used_memory(dsa_double_stack_allocator *memory);
     #define DSA_FREE(size) free(size)
 #endif
 
+#if defined(__GNUC__) || defined(__clang__)
+    #define DSA_LIKELY(x) __builtin_expect(!!(x), 1)
+    #define DSA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+    #define DSA_COLD __attribute__((cold, noinline))
+#else
+    #define DSA_LIKELY(x) (x)
+    #define DSA_UNLIKELY(x) (x)
+    #define DSA_COLD
+#endif
+
+#ifdef DSA_MARKER_STACK
+    #define DSA_DROP_MARKERS(memory, marker) dsa__drop_markers((memory), (marker))
+    #define DSA_RESET_MARKERS(memory) ((memory)->marker_stack = 0)
+#else
+    #define DSA_DROP_MARKERS(memory, marker)
+    #define DSA_RESET_MARKERS(memory)
+#endif
+
+#ifndef DSA_TRACE
+    #define DSA_TRACE(event, memory, size, used)
+#endif
+
+#ifdef DSA_OVERFLOW
+    #define DSA_ALLOC_BOTTOM_FALLBACK(memory, size, alignment, failed_size) \
+        dsa__spill((memory), &(memory)->overflow.bottom_spills, &(memory)->overflow.live_bottom_spills, (memory)->bottom, \
+                   (size), (alignment), (failed_size), dsa__alloc_bottom_failed)
+    #define DSA_ALLOC_TOP_FALLBACK(memory, size, alignment, failed_size) \
+        dsa__spill((memory), &(memory)->overflow.top_spills, &(memory)->overflow.live_top_spills, (memory)->capacity - (memory)->top, \
+                   (size), (alignment), (failed_size), dsa__alloc_top_failed)
+#else
+    #define DSA_ALLOC_BOTTOM_FALLBACK(memory, size, alignment, failed_size) dsa__alloc_bottom_failed((memory), (failed_size))
+    #define DSA_ALLOC_TOP_FALLBACK(memory, size, alignment, failed_size) dsa__alloc_top_failed((memory), (failed_size))
+#endif
+
+#ifdef DSA_STATS
+    #define DSA_STATS_ALLOCATION(memory, size) dsa__stats_allocation((memory), (size))
+    #define DSA_STATS_FAILURE(memory) ((memory)->stats.failed_allocations++)
+    #define DSA_STATS_ALIGNMENT(memory, padding) ((memory)->stats.alignment_waste += (padding))
+#else
+    #define DSA_STATS_ALLOCATION(memory, size)
+    #define DSA_STATS_FAILURE(memory)
+    #define DSA_STATS_ALIGNMENT(memory, padding)
+#endif
+
+#ifdef DSA_STATS
+static void dsa__stats_allocation(dsa_double_stack_allocator *memory, size_t size) {
+    size_t bucket = 0;
+    for(; size > 0; size >>= 1) bucket++;
+    memory->stats.allocations++;
+    memory->stats.size_histogram[bucket]++;
+    size_t used_bottom = dsa_used_memory_bottom(memory);
+    size_t used_top = dsa_used_memory_top(memory);
+    if(used_bottom > memory->stats.peak_bottom) {
+        memory->stats.peak_bottom = used_bottom;
+    }
+    if(used_top > memory->stats.peak_top) {
+        memory->stats.peak_top = used_top;
+    }
+    if(used_bottom + used_top > memory->stats.peak) {
+        memory->stats.peak = used_bottom + used_top;
+    }
+}
+#endif
+
+#ifdef DSA_MARKER_STACK
+// Saved marker entry, stored in the Double Stack Allocator bottom memory.
+typedef struct dsa__saved_marker {
+    dsa_marker marker;  // Markers before the entry was pushed.
+    size_t previous;    // Previous value of `marker_stack`.
+} dsa__saved_marker;
+
+// Discard pushed markers whose entries end past bottom `marker`, most recent first.
+static void dsa__drop_markers(dsa_double_stack_allocator *memory, size_t marker) {
+    while(memory->marker_stack != 0 && memory->marker_stack - 1 + sizeof(dsa__saved_marker) > marker) {
+        dsa__saved_marker *entry = (dsa__saved_marker *) (((uint8_t *) memory->buffer) + memory->marker_stack - 1);
+        memory->marker_stack = entry->previous;
+    }
+}
+#endif
+
+// Failure paths of allocations, kept out of line so the fast paths stay small.
+static DSA_COLD void *dsa__alloc_bottom_failed(dsa_double_stack_allocator *memory, size_t size) {
+    (void) memory;
+    (void) size;
+    DSA_STATS_FAILURE(memory);
+    DSA_TRACE(DSA_ALLOC_BOTTOM_FAILED, memory, size, memory->bottom);
+    return NULL;
+}
+
+static DSA_COLD void *dsa__alloc_top_failed(dsa_double_stack_allocator *memory, size_t size) {
+    (void) memory;
+    (void) size;
+    DSA_STATS_FAILURE(memory);
+    DSA_TRACE(DSA_ALLOC_TOP_FAILED, memory, size, memory->capacity - memory->top);
+    return NULL;
+}
+
+#ifdef DSA_OVERFLOW
+// Spilled block headers keep blocks aligned like `malloc` would
+#define DSA__SPILL_HEADER_SIZE ((sizeof(dsa_spill) + 15) & ~(size_t) 15)
+
+// Allocation fallback to the overflow handler, tracking the block in `spills`
+// after the `used` bytes of its end.
+static DSA_COLD void *dsa__spill(dsa_double_stack_allocator *memory, dsa_spill **spills, size_t *live_spills, size_t used,
+                                 size_t size, size_t alignment, size_t failed_size,
+                                 void *(*alloc_failed)(dsa_double_stack_allocator *, size_t)) {
+    size_t extra = DSA__SPILL_HEADER_SIZE + (alignment > 16 ? alignment - 1 : 0);
+    uint8_t *block;
+    if(memory->overflow.alloc == NULL
+       || size > SIZE_MAX - extra
+       || (block = (uint8_t *) memory->overflow.alloc(memory->overflow.ctx, extra + size)) == NULL) {
+        return alloc_failed(memory, failed_size);
+    }
+    dsa_spill *spill = (dsa_spill *) block;
+    spill->previous = *spills;
+    spill->marker = used + *live_spills;
+    *spills = spill;
+    (*live_spills)++;
+    memory->overflow.spill_count++;
+    memory->overflow.spilled_bytes += size;
+    uintptr_t address = (uintptr_t) (block + DSA__SPILL_HEADER_SIZE);
+    return (void *) ((address + alignment - 1) & ~(uintptr_t) (alignment - 1));
+}
+
+// Free blocks spilled from bottom at or past bottom `marker`, most recent first.
+// Returns the bottom position `marker` refers to, SIZE_MAX if it is invalid.
+static size_t dsa__free_bottom_spills(dsa_double_stack_allocator *memory, size_t marker) {
+    while(memory->overflow.bottom_spills != NULL && memory->overflow.bottom_spills->marker >= marker) {
+        dsa_spill *spill = memory->overflow.bottom_spills;
+        memory->overflow.bottom_spills = spill->previous;
+        memory->overflow.live_bottom_spills--;
+        memory->overflow.free(memory->overflow.ctx, spill);
+    }
+    size_t live = memory->overflow.live_bottom_spills;
+    return marker >= live ? marker - live : SIZE_MAX;
+}
+
+// Free blocks spilled from top at or past top `marker`, most recent first.
+// Returns the top position `marker` refers to.
+static size_t dsa__free_top_spills(dsa_double_stack_allocator *memory, size_t marker) {
+    // Top spills count used memory, which grows like bottom markers do
+    size_t used = memory->capacity - marker;
+    while(memory->overflow.top_spills != NULL && memory->overflow.top_spills->marker >= used) {
+        dsa_spill *spill = memory->overflow.top_spills;
+        memory->overflow.top_spills = spill->previous;
+        memory->overflow.live_top_spills--;
+        memory->overflow.free(memory->overflow.ctx, spill);
+    }
+    return marker + memory->overflow.live_top_spills;
+}
+
+// Popping doesn't free spilled blocks, so lower their markers below the ones
+// got after the pop, which would otherwise free them.
+static void dsa__lower_spills(dsa_spill *spill, size_t older, size_t used) {
+    for(; spill != NULL; spill = spill->previous) {
+        older--;
+        if(spill->marker <= used + older) break;
+        spill->marker = used + older;
+    }
+}
+
+    #define DSA_FREE_BOTTOM_SPILLS(memory, marker) dsa__free_bottom_spills((memory), (marker))
+    #define DSA_FREE_TOP_SPILLS(memory, marker) dsa__free_top_spills((memory), (marker))
+    #define DSA_LOWER_BOTTOM_SPILLS(memory) \
+        dsa__lower_spills((memory)->overflow.bottom_spills, (memory)->overflow.live_bottom_spills, (memory)->bottom)
+    #define DSA_LOWER_TOP_SPILLS(memory) \
+        dsa__lower_spills((memory)->overflow.top_spills, (memory)->overflow.live_top_spills, (memory)->capacity - (memory)->top)
+#else
+    #define DSA_FREE_BOTTOM_SPILLS(memory, marker)
+    #define DSA_FREE_TOP_SPILLS(memory, marker)
+    #define DSA_LOWER_BOTTOM_SPILLS(memory)
+    #define DSA_LOWER_TOP_SPILLS(memory)
+#endif
+
+// Markers for buffer positions, counting the blocks spilled from their end before them.
+static size_t dsa__bottom_marker(dsa_double_stack_allocator *memory, size_t position) {
+#ifdef DSA_OVERFLOW
+    return position + memory->overflow.live_bottom_spills;
+#else
+    (void) memory;
+    return position;
+#endif
+}
+
+static size_t dsa__top_marker(dsa_double_stack_allocator *memory, size_t position) {
+#ifdef DSA_OVERFLOW
+    return position - memory->overflow.live_top_spills;
+#else
+    (void) memory;
+    return position;
+#endif
+}
+
+#if defined(DSA_MARKER_STACK) || defined(STACK_ALLOCATOR_H)
+// Bottom allocation for memory that must live in the buffer, never spilled.
+static void *dsa__alloc_bottom_in_buffer(dsa_double_stack_allocator *memory, size_t size, size_t alignment) {
+#ifdef DSA_OVERFLOW
+    dsa_overflow_alloc_fn alloc = memory->overflow.alloc;
+    memory->overflow.alloc = NULL;
+    void *ptr = dsa_alloc_bottom_aligned(memory, size, alignment);
+    memory->overflow.alloc = alloc;
+    return ptr;
+#else
+    return dsa_alloc_bottom_aligned(memory, size, alignment);
+#endif
+}
+#endif
+
 DSA_DECL dsa_double_stack_allocator dsa_new(void *buffer, size_t capacity) {
     return DSA_NEW(buffer, capacity);
 }
@@ -278,90 +751,208 @@ DSA_DECL dsa_double_stack_allocator dsa_new_with_capacity(size_t capacity) {
 }
 
 DSA_DECL int dsa_init_with_capacity(dsa_double_stack_allocator *memory, size_t capacity) {
-    memory->buffer = DSA_MALLOC(capacity);
-    int malloc_success = memory->buffer != NULL;
-    capacity = malloc_success * capacity;
-    memory->capacity = capacity;
-    memory->top = capacity;
-    memory->bottom = 0;
+    void *buffer = DSA_MALLOC(capacity);
+    int malloc_success = buffer != NULL;
+    *memory = DSA_NEW(buffer, malloc_success * capacity);
     return malloc_success;
 }
 
 DSA_DECL void dsa_release(dsa_double_stack_allocator *memory) {
+    DSA_FREE_BOTTOM_SPILLS(memory, 0);
+    DSA_FREE_TOP_SPILLS(memory, memory->capacity);
+    DSA_TRACE(DSA_RELEASE, memory, memory->bottom + (memory->capacity - memory->top), 0);
     DSA_FREE(memory->buffer);
     *memory = (dsa_double_stack_allocator){};
 }
 
 DSA_DECL void *dsa_alloc_bottom(dsa_double_stack_allocator *memory, size_t size) {
-    if(memory->bottom + size > memory->top) return NULL;
-    void *ptr = ((uint8_t *) memory->buffer) + memory->bottom;
-    memory->bottom += size;
-    return ptr;
+    // Bottom is loaded once, so the overflow safe check costs a single subtraction
+    size_t bottom = memory->bottom;
+    if(DSA_UNLIKELY(size > memory->top - bottom)) {
+        return DSA_ALLOC_BOTTOM_FALLBACK(memory, size, 1, size);
+    }
+    memory->bottom = bottom + size;
+    DSA_STATS_ALLOCATION(memory, size);
+    DSA_TRACE(DSA_ALLOC_BOTTOM, memory, size, memory->bottom);
+    return ((uint8_t *) memory->buffer) + bottom;
 }
 
 DSA_DECL void *dsa_alloc_top(dsa_double_stack_allocator *memory, size_t size) {
-    if(memory->top < memory->bottom + size) return NULL;
+    if(DSA_UNLIKELY(size > memory->top - memory->bottom)) {
+        return DSA_ALLOC_TOP_FALLBACK(memory, size, 1, size);
+    }
     memory->top -= size;
     void *ptr = ((uint8_t *) memory->buffer) + memory->top;
+    DSA_STATS_ALLOCATION(memory, size);
+    DSA_TRACE(DSA_ALLOC_TOP, memory, size, memory->capacity - memory->top);
     return ptr;
 }
 
+DSA_DECL void *dsa_alloc_bottom_aligned(dsa_double_stack_allocator *memory, size_t size, size_t alignment) {
+    uintptr_t address = ((uintptr_t) memory->buffer) + memory->bottom;
+    size_t padding = (size_t) (-address & (alignment - 1));
+    size_t available = memory->top - memory->bottom;
+    if(DSA_UNLIKELY(size > available || padding > available - size)) {
+        return DSA_ALLOC_BOTTOM_FALLBACK(memory, size, alignment, padding + size);
+    }
+    memory->bottom += padding;
+    DSA_STATS_ALIGNMENT(memory, padding);
+    return dsa_alloc_bottom(memory, size);
+}
+
+DSA_DECL void *dsa_alloc_top_aligned(dsa_double_stack_allocator *memory, size_t size, size_t alignment) {
+    if(DSA_UNLIKELY(size > memory->top - memory->bottom)) {
+        return DSA_ALLOC_TOP_FALLBACK(memory, size, alignment, size);
+    }
+    uintptr_t address = ((uintptr_t) memory->buffer) + memory->top - size;
+    size_t padding = (size_t) (address & (alignment - 1));
+    if(DSA_UNLIKELY(padding > memory->top - size - memory->bottom)) {
+        return DSA_ALLOC_TOP_FALLBACK(memory, size, alignment, padding + size);
+    }
+    memory->top -= padding;
+    DSA_STATS_ALIGNMENT(memory, padding);
+    return dsa_alloc_top(memory, size);
+}
+
 DSA_DECL void dsa_clear_bottom(dsa_double_stack_allocator *memory) {
+    DSA_FREE_BOTTOM_SPILLS(memory, 0);
+    DSA_TRACE(DSA_CLEAR_BOTTOM_MARKER, memory, memory->bottom, 0);
     memory->bottom = 0;
+    DSA_RESET_MARKERS(memory);
 }
 
 DSA_DECL void dsa_clear_top(dsa_double_stack_allocator *memory) {
+    DSA_FREE_TOP_SPILLS(memory, memory->capacity);
+    DSA_TRACE(DSA_CLEAR_TOP_MARKER, memory, memory->capacity - memory->top, 0);
     memory->top = memory->capacity;
 }
 
 DSA_DECL size_t dsa_get_bottom_marker(dsa_double_stack_allocator *memory) {
-    return memory->bottom;
+    return dsa__bottom_marker(memory, memory->bottom);
 }
 
 DSA_DECL size_t dsa_get_top_marker(dsa_double_stack_allocator *memory) {
-    return memory->top;
+    return dsa__top_marker(memory, memory->top);
 }
 
 DSA_DECL void dsa_clear_bottom_marker(dsa_double_stack_allocator *memory, size_t marker) {
+#ifdef DSA_OVERFLOW
+    // Spilled blocks are freed even if no buffer memory is
+    marker = dsa__free_bottom_spills(memory, marker);
+#endif
     if(marker < memory->bottom) {
+        DSA_DROP_MARKERS(memory, marker);
+        DSA_TRACE(DSA_CLEAR_BOTTOM_MARKER, memory, memory->bottom - marker, marker);
         memory->bottom = marker;
     }
 }
 
 DSA_DECL void dsa_clear_top_marker(dsa_double_stack_allocator *memory, size_t marker) {
+#ifdef DSA_OVERFLOW
+    // Spilled blocks are freed even if no buffer memory is
+    marker = dsa__free_top_spills(memory, marker);
+#endif
     if(marker > memory->top && marker <= memory->capacity) {
+        DSA_TRACE(DSA_CLEAR_TOP_MARKER, memory, marker - memory->top, memory->capacity - marker);
         memory->top = marker;
     }
 }
 
+DSA_DECL dsa_marker dsa_get_marker(dsa_double_stack_allocator *memory) {
+    return (dsa_marker){ dsa_get_bottom_marker(memory), dsa_get_top_marker(memory) };
+}
+
+DSA_DECL void dsa_clear_to_marker(dsa_double_stack_allocator *memory, dsa_marker marker) {
+    dsa_clear_bottom_marker(memory, marker.bottom);
+    dsa_clear_top_marker(memory, marker.top);
+}
+
+#ifdef DSA_MARKER_STACK
+DSA_DECL int dsa_push_marker(dsa_double_stack_allocator *memory) {
+    dsa_marker marker = dsa_get_marker(memory);
+    dsa__saved_marker *entry = (dsa__saved_marker *) dsa__alloc_bottom_in_buffer(memory, sizeof(dsa__saved_marker), DSA_ALIGNOF(dsa__saved_marker));
+    if(entry == NULL) return 0;
+    entry->marker = marker;
+    entry->previous = memory->marker_stack;
+    memory->marker_stack = (size_t) ((uint8_t *) entry - (uint8_t *) memory->buffer) + 1;
+    return 1;
+}
+
+DSA_DECL int dsa_pop_marker(dsa_double_stack_allocator *memory) {
+    if(memory->marker_stack == 0) return 0;
+    dsa__saved_marker *entry = (dsa__saved_marker *) (((uint8_t *) memory->buffer) + memory->marker_stack - 1);
+    dsa_marker marker = entry->marker;
+    memory->marker_stack = entry->previous;
+    dsa_clear_to_marker(memory, marker);
+    return 1;
+}
+#endif
+
 DSA_DECL void dsa_pop_bottom(dsa_double_stack_allocator *memory, size_t size) {
     if(size > memory->bottom) {
+        size = memory->bottom;
         memory->bottom = 0;
+        DSA_RESET_MARKERS(memory);
     }
     else {
         memory->bottom -= size;
+        DSA_DROP_MARKERS(memory, memory->bottom);
     }
+    DSA_LOWER_BOTTOM_SPILLS(memory);
+    DSA_TRACE(DSA_POP_BOTTOM, memory, size, memory->bottom);
 }
 
 DSA_DECL void dsa_pop_top(dsa_double_stack_allocator *memory, size_t size) {
     if(size > memory->capacity - memory->top) {
+        size = memory->capacity - memory->top;
         memory->top = memory->capacity;
     }
     else {
         memory->top += size;
     }
+    DSA_LOWER_TOP_SPILLS(memory);
+    DSA_TRACE(DSA_POP_TOP, memory, size, memory->capacity - memory->top);
 }
 
 DSA_DECL void *dsa_peek_bottom(dsa_double_stack_allocator *memory, size_t size) {
-    if(memory->bottom < size) return NULL;
+    if(DSA_UNLIKELY(memory->bottom < size)) return NULL;
     return ((uint8_t *) memory->buffer) + memory->bottom - size;
 }
 
 DSA_DECL void *dsa_peek_top(dsa_double_stack_allocator *memory, size_t size) {
-    if(memory->capacity - memory->top < size) return NULL;
+    if(DSA_UNLIKELY(memory->capacity - memory->top < size)) return NULL;
     return ((uint8_t *) memory->buffer) + memory->top;
 }
 
+DSA_DECL void *dsa_promote_top_to_bottom(dsa_double_stack_allocator *memory, size_t size) {
+    if(DSA_UNLIKELY(memory->capacity - memory->top < size)) return NULL;
+    uint8_t *ptr = ((uint8_t *) memory->buffer) + memory->bottom;
+    if(memory->top != memory->bottom) {
+        memmove(ptr, ((uint8_t *) memory->buffer) + memory->top, size);
+    }
+    memory->top += size;
+    DSA_LOWER_TOP_SPILLS(memory);
+    DSA_TRACE(DSA_POP_TOP, memory, size, memory->capacity - memory->top);
+    memory->bottom += size;
+    DSA_TRACE(DSA_ALLOC_BOTTOM, memory, size, memory->bottom);
+    return ptr;
+}
+
+DSA_DECL void *dsa_demote_bottom_to_top(dsa_double_stack_allocator *memory, size_t size) {
+    if(DSA_UNLIKELY(memory->bottom < size)) return NULL;
+    uint8_t *ptr = ((uint8_t *) memory->buffer) + memory->top - size;
+    if(memory->top != memory->bottom) {
+        memmove(ptr, ((uint8_t *) memory->buffer) + memory->bottom - size, size);
+    }
+    memory->bottom -= size;
+    DSA_DROP_MARKERS(memory, memory->bottom);
+    DSA_LOWER_BOTTOM_SPILLS(memory);
+    DSA_TRACE(DSA_POP_BOTTOM, memory, size, memory->bottom);
+    memory->top -= size;
+    DSA_TRACE(DSA_ALLOC_TOP, memory, size, memory->capacity - memory->top);
+    return ptr;
+}
+
 DSA_DECL size_t dsa_available_memory(dsa_double_stack_allocator *memory) {
     return memory->top - memory->bottom;
 }
@@ -378,4 +969,99 @@ DSA_DECL size_t dsa_used_memory(dsa_double_stack_allocator *memory) {
     return dsa_used_memory_bottom(memory) + dsa_used_memory_top(memory);
 }
 
+#ifdef STACK_ALLOCATOR_H
+// Top allocation for memory that must live in the buffer, never spilled.
+static void *dsa__alloc_top_in_buffer(dsa_double_stack_allocator *memory, size_t size) {
+#ifdef DSA_OVERFLOW
+    dsa_overflow_alloc_fn alloc = memory->overflow.alloc;
+    memory->overflow.alloc = NULL;
+    void *ptr = dsa_alloc_top(memory, size);
+    memory->overflow.alloc = alloc;
+    return ptr;
+#else
+    return dsa_alloc_top(memory, size);
+#endif
+}
+
+// Whether `child` owns something besides its buffer memory, that committing would drop.
+static int dsa__child_has_owned_memory(sa_stack_allocator *child) {
+#ifdef SA_CLEANUP
+    if(child->cleanup != NULL) return 1;
+#endif
+#ifdef SA_OVERFLOW
+    if(child->overflow.spills != NULL) return 1;
+#endif
+    (void) child;
+    return 0;
+}
+
+DSA_DECL int dsa_child_begin_bottom(dsa_double_stack_allocator *memory, sa_stack_allocator *child, size_t capacity) {
+    void *buffer = dsa__alloc_bottom_in_buffer(memory, capacity, 1);
+    int alloc_success = buffer != NULL;
+    *child = SA_NEW(buffer, alloc_success * capacity);
+    return alloc_success;
+}
+
+DSA_DECL int dsa_child_begin_top(dsa_double_stack_allocator *memory, sa_stack_allocator *child, size_t capacity) {
+    void *buffer = dsa__alloc_top_in_buffer(memory, capacity);
+    int alloc_success = buffer != NULL;
+    *child = SA_NEW(buffer, alloc_success * capacity);
+    return alloc_success;
+}
+
+DSA_DECL void dsa_child_end_bottom(dsa_double_stack_allocator *memory, sa_stack_allocator *child) {
+    if(child->buffer == NULL) return;
+    sa_clear(child);
+    dsa_clear_bottom_marker(memory, dsa__bottom_marker(memory, (size_t) ((uint8_t *) child->buffer - (uint8_t *) memory->buffer)));
+    *child = (sa_stack_allocator){};
+}
+
+DSA_DECL void dsa_child_end_top(dsa_double_stack_allocator *memory, sa_stack_allocator *child) {
+    if(child->buffer == NULL) return;
+    sa_clear(child);
+    size_t end = (size_t) ((uint8_t *) child->buffer - (uint8_t *) memory->buffer) + child->capacity;
+    dsa_clear_top_marker(memory, dsa__top_marker(memory, end));
+    *child = (sa_stack_allocator){};
+}
+
+DSA_DECL void *dsa_child_commit_bottom(dsa_double_stack_allocator *memory, sa_stack_allocator *child) {
+    void *ptr = child->buffer;
+    if(ptr == NULL || dsa__child_has_owned_memory(child)) return NULL;
+    dsa_clear_bottom_marker(memory, dsa__bottom_marker(memory, (size_t) ((uint8_t *) ptr - (uint8_t *) memory->buffer) + child->marker));
+    *child = (sa_stack_allocator){};
+    return ptr;
+}
+
+DSA_DECL void *dsa_child_commit_top(dsa_double_stack_allocator *memory, sa_stack_allocator *child) {
+    if(child->buffer == NULL || dsa__child_has_owned_memory(child)) return NULL;
+    size_t end = (size_t) ((uint8_t *) child->buffer - (uint8_t *) memory->buffer) + child->capacity;
+    uint8_t *ptr = ((uint8_t *) memory->buffer) + end - child->marker;
+    memmove(ptr, child->buffer, child->marker);
+    dsa_clear_top_marker(memory, dsa__top_marker(memory, end - child->marker));
+    *child = (sa_stack_allocator){};
+    return ptr;
+}
+#endif
+
+#ifdef DSA_OVERFLOW
+DSA_DECL void dsa_set_overflow_handler(dsa_double_stack_allocator *memory, dsa_overflow_alloc_fn alloc_fn, dsa_overflow_free_fn free_fn, void *ctx) {
+    memory->overflow.alloc = alloc_fn;
+    memory->overflow.free = free_fn;
+    memory->overflow.ctx = ctx;
+}
+#endif
+
+#ifdef DSA_STATS
+DSA_DECL const dsa_stats *dsa_get_stats(dsa_double_stack_allocator *memory) {
+    return &memory->stats;
+}
+
+DSA_DECL void dsa_reset_stats(dsa_double_stack_allocator *memory) {
+    memory->stats = (dsa_stats){};
+    memory->stats.peak_bottom = dsa_used_memory_bottom(memory);
+    memory->stats.peak_top = dsa_used_memory_top(memory);
+    memory->stats.peak = dsa_used_memory(memory);
+}
+#endif
+
 #endif  // DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION
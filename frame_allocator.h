@@ -0,0 +1,218 @@
+/**
+ * frame_allocator.h -- Frame rotating Stack Allocators with epoch reclamation
+ *
+ * Project URL: https://github.com/gilzoide/c-allocators
+ *
+ * Do this:
+ *    #define FRAME_ALLOCATOR_IMPLEMENTATION
+ * before you include this file in *one* C or C++ file to create the implementation.
+ *
+ * i.e.:
+ *   #include ...
+ *   #include ...
+ *   #define FRAME_ALLOCATOR_IMPLEMENTATION
+ *   #include "frame_allocator.h"
+ *
+ * Frame Allocators hold N Stack Allocators used in rotation, one per frame
+ * (or tick), so that data allocated by a writer thread in one frame can be
+ * read by other threads while the writer moves on to the next ones, without
+ * copying.
+ *
+ * Frames are identified by increasing epochs. The writer allocates from the
+ * stack of the current epoch using #sa_frame_current and publishes it with
+ * #sa_frame_advance. Readers pin the latest published epoch with
+ * #sa_frame_pin, read its stack with #sa_frame_get and unpin it with
+ * #sa_frame_unpin. A stack is only cleared for reuse after every reader that
+ * pinned it has unpinned it, so readers may lag up to N - 2 frames behind
+ * without blocking the writer.
+ *
+ * This file uses stack_allocator.h, whose implementation must also be
+ * created in some C or C++ file.
+ *
+ * Optionally provide the following defines with your own implementations:
+ *
+ * SA_FRAME_STATIC  - if defined and SA_FRAME_DECL is not defined, functions will be declared `static` instead of `extern`
+ * SA_FRAME_DECL    - function declaration prefix (default: `extern` or `static` depending on SA_FRAME_STATIC)
+ */
+#ifndef FRAME_ALLOCATOR_H
+#define FRAME_ALLOCATOR_H
+
+#include "stack_allocator.h"
+
+#ifndef SA_FRAME_DECL
+    #ifdef SA_FRAME_STATIC
+        #define SA_FRAME_DECL static
+    #else
+        #define SA_FRAME_DECL extern
+    #endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __cplusplus
+    #define SA_FRAME_ALIGNOF(type) alignof(type)
+    #define SA_FRAME_ALIGNAS(n) alignas(n)
+#else
+    #define SA_FRAME_ALIGNOF(type) _Alignof(type)
+    #define SA_FRAME_ALIGNAS(n) _Alignas(n)
+#endif
+
+/// A frame's Stack Allocator, with its reader count in its own cache line.
+typedef struct sa_frame {
+    SA_FRAME_ALIGNAS(64) uint64_t readers;  ///< Number of readers pinning this frame, only accessed atomically.
+    uint64_t epoch;                         ///< Epoch of the frame stored in this stack.
+    sa_stack_allocator stack;               ///< Frame memory.
+} sa_frame;
+
+/// Frame Allocator, rotating between `frame_count` Stack Allocators.
+typedef struct sa_frame_allocator {
+    sa_frame *frames;    ///< Frames, aligned to cache lines inside `buffer`.
+    size_t frame_count;  ///< Number of frames.
+    void *buffer;        ///< Memory for frames, allocated with SA_MALLOC.
+    uint64_t epoch;      ///< Writer's current epoch, only written by the writer. The previous epoch is published to readers.
+    int pending;         ///< Whether #sa_frame_advance is waiting for readers to leave the next frame.
+} sa_frame_allocator;
+
+/// Initializes a Frame Allocator with `frame_count` frames of `capacity` bytes each.
+///
+/// `frame_count` must be at least 2.
+/// The writer starts at epoch 1 and epoch 0 is published as an empty frame.
+///
+/// @return Non-zero if memory was allocated successfully.
+/// @return 0 otherwise.
+SA_FRAME_DECL int sa_frame_init(sa_frame_allocator *memory, size_t frame_count, size_t capacity);
+
+/// Release the memory associated with a Frame Allocator.
+///
+/// @warning No reader may have a pinned frame.
+SA_FRAME_DECL void sa_frame_release(sa_frame_allocator *memory);
+
+/// Get the writer's Stack Allocator for the current epoch.
+///
+/// @return Stack Allocator for the current frame.
+/// @return NULL if the last #sa_frame_advance is still waiting for readers.
+SA_FRAME_DECL sa_stack_allocator *sa_frame_current(sa_frame_allocator *memory);
+
+/// Publish the writer's current frame to readers and move the writer to the next epoch, clearing its stack.
+///
+/// The next epoch reuses the stack of epoch `epoch - frame_count`, which
+/// can only be cleared after all of its readers unpin it. While they don't,
+/// the frame is published but #sa_frame_current returns NULL: call this
+/// function again later to finish advancing.
+///
+/// @return Non-zero if the writer's next frame is ready.
+/// @return 0 if readers still pin the frame being reused.
+SA_FRAME_DECL int sa_frame_advance(sa_frame_allocator *memory);
+
+/// Pin the latest published epoch, so that its frame is not cleared until #sa_frame_unpin.
+///
+/// Safe to call from any thread, concurrently with the writer.
+///
+/// @return The pinned epoch.
+SA_FRAME_DECL uint64_t sa_frame_pin(sa_frame_allocator *memory);
+
+/// Unpin an epoch returned by #sa_frame_pin.
+SA_FRAME_DECL void sa_frame_unpin(sa_frame_allocator *memory, uint64_t epoch);
+
+/// Get the Stack Allocator holding the frame of a pinned epoch.
+///
+/// @warning Readers must not allocate or free from the returned Stack Allocator.
+SA_FRAME_DECL sa_stack_allocator *sa_frame_get(sa_frame_allocator *memory, uint64_t epoch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // FRAME_ALLOCATOR_H
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(FRAME_ALLOCATOR_IMPLEMENTATION) && !defined(FRAME_ALLOCATOR_IMPLEMENTATION_INCLUDED)
+#define FRAME_ALLOCATOR_IMPLEMENTATION_INCLUDED
+
+#ifndef SA_MALLOC
+    #define SA_MALLOC(size) malloc(size)
+#endif
+#ifndef SA_FREE
+    #define SA_FREE(p) free(p)
+#endif
+
+SA_FRAME_DECL int sa_frame_init(sa_frame_allocator *memory, size_t frame_count, size_t capacity) {
+    *memory = (sa_frame_allocator){};
+    if(frame_count < 2 || frame_count > SIZE_MAX / sizeof(sa_frame) - 1) return 0;
+    // SA_MALLOC doesn't know about cache line alignment, so frames are aligned by hand
+    uint8_t *buffer = (uint8_t *) SA_MALLOC((frame_count + 1) * sizeof(sa_frame));
+    if(buffer == NULL) return 0;
+    uintptr_t alignment = SA_FRAME_ALIGNOF(sa_frame);
+    sa_frame *frames = (sa_frame *) (((uintptr_t) buffer + alignment - 1) & ~(alignment - 1));
+    for(size_t i = 0; i < frame_count; i++) {
+        frames[i] = (sa_frame){};
+        if(!sa_init_with_capacity(&frames[i].stack, capacity)) {
+            while(i-- > 0) {
+                sa_release(&frames[i].stack);
+            }
+            SA_FREE(buffer);
+            return 0;
+        }
+        frames[i].epoch = i;
+    }
+    memory->frames = frames;
+    memory->frame_count = frame_count;
+    memory->buffer = buffer;
+    memory->epoch = 1;
+    return 1;
+}
+
+SA_FRAME_DECL void sa_frame_release(sa_frame_allocator *memory) {
+    for(size_t i = 0; i < memory->frame_count; i++) {
+        sa_release(&memory->frames[i].stack);
+    }
+    SA_FREE(memory->buffer);
+    *memory = (sa_frame_allocator){};
+}
+
+SA_FRAME_DECL sa_stack_allocator *sa_frame_current(sa_frame_allocator *memory) {
+    if(memory->pending) return NULL;
+    return &memory->frames[memory->epoch % memory->frame_count].stack;
+}
+
+SA_FRAME_DECL int sa_frame_advance(sa_frame_allocator *memory) {
+    if(!memory->pending) {
+        // Publish the current frame before checking readers of the next one:
+        // readers pinning the reused frame concurrently will see the new epoch and retry
+        __atomic_store_n(&memory->epoch, memory->epoch + 1, __ATOMIC_SEQ_CST);
+        memory->pending = 1;
+    }
+    sa_frame *frame = &memory->frames[memory->epoch % memory->frame_count];
+    if(__atomic_load_n(&frame->readers, __ATOMIC_SEQ_CST) != 0) return 0;
+    sa_clear(&frame->stack);
+    frame->epoch = memory->epoch;
+    memory->pending = 0;
+    return 1;
+}
+
+SA_FRAME_DECL uint64_t sa_frame_pin(sa_frame_allocator *memory) {
+    for(;;) {
+        uint64_t epoch = __atomic_load_n(&memory->epoch, __ATOMIC_SEQ_CST) - 1;
+        sa_frame *frame = &memory->frames[epoch % memory->frame_count];
+        __atomic_fetch_add(&frame->readers, 1, __ATOMIC_SEQ_CST);
+        // The frame is only valid if the writer didn't move on to reuse it meanwhile
+        if(__atomic_load_n(&memory->epoch, __ATOMIC_SEQ_CST) - epoch < memory->frame_count) {
+            return epoch;
+        }
+        __atomic_fetch_sub(&frame->readers, 1, __ATOMIC_RELEASE);
+    }
+}
+
+SA_FRAME_DECL void sa_frame_unpin(sa_frame_allocator *memory, uint64_t epoch) {
+    sa_frame *frame = &memory->frames[epoch % memory->frame_count];
+    __atomic_fetch_sub(&frame->readers, 1, __ATOMIC_RELEASE);
+}
+
+SA_FRAME_DECL sa_stack_allocator *sa_frame_get(sa_frame_allocator *memory, uint64_t epoch) {
+    return &memory->frames[epoch % memory->frame_count].stack;
+}
+
+#endif  // FRAME_ALLOCATOR_IMPLEMENTATION
@@ -0,0 +1,630 @@
+/**
+ * mapped_stack_allocator.h -- Memory mapped Stack Allocators
+ *
+ * Project URL: https://github.com/gilzoide/c-allocators
+ *
+ * Do this:
+ *    #define MAPPED_STACK_ALLOCATOR_IMPLEMENTATION
+ * before you include this file in *one* C or C++ file to create the implementation.
+ *
+ * i.e.:
+ *   #include ...
+ *   #include ...
+ *   #define MAPPED_STACK_ALLOCATOR_IMPLEMENTATION
+ *   #include "mapped_stack_allocator.h"
+ *
+ * Save a Stack Allocator's used memory to an image file with #sa_save and
+ * map it back with #sa_map, so that data structures built in an arena can be
+ * loaded with a single `mmap`. The image will most likely be mapped at a
+ * different address, so link data structures with `sa_offset` instead of
+ * pointers.
+ *
+ * Shared Stack Allocators live in shared memory created with #sa_shared_create
+ * and attached by other processes with #sa_shared_attach, or inherited by
+ * `fork`. Their marker lives in the shared region and is advanced atomically,
+ * so multiple processes can allocate from the same arena.
+ *
+ * File-backed Stack Allocators, created with #sa_init_file_backed, use a
+ * shared file mapping as buffer, so data allocated with the usual `sa_alloc`
+ * API is written to the file and can be larger than RAM.
+ *
+ * This file uses stack_allocator.h, whose implementation must also be
+ * created in some C or C++ file. POSIX only.
+ *
+ * Optionally provide the following defines with your own implementations:
+ *
+ * SA_MAP_STATIC  - if defined and SA_MAP_DECL is not defined, functions will be declared `static` instead of `extern`
+ * SA_MAP_DECL    - function declaration prefix (default: `extern` or `static` depending on SA_MAP_STATIC)
+ */
+#ifndef MAPPED_STACK_ALLOCATOR_H
+#define MAPPED_STACK_ALLOCATOR_H
+
+#include "stack_allocator.h"
+
+#ifndef SA_MAP_DECL
+    #ifdef SA_MAP_STATIC
+        #define SA_MAP_DECL static
+    #else
+        #define SA_MAP_DECL extern
+    #endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// Header of image files, followed by the saved memory.
+typedef struct sa_image_header {
+    char magic[8];       ///< "SAIMAGE" followed by a null byte.
+    uint32_t version;    ///< Image format version, currently 1.
+    uint32_t header_size;  ///< Size of this header, where the saved memory starts.
+    uint64_t size;       ///< Number of bytes saved, the marker when saved.
+    uint64_t checksum;   ///< 64-bit FNV-1a hash of the saved memory.
+    uint8_t reserved[32];
+} sa_image_header;
+
+#define SA_IMAGE_MAGIC "SAIMAGE"
+#define SA_IMAGE_VERSION 1
+
+/// Flags for #sa_map.
+enum sa_map_flags {
+    /// Map image copy-on-write, so memory can be modified and allocated
+    /// without changing the file. Read-only otherwise.
+    SA_MAP_PRIVATE = 1 << 0,
+    /// Verify the image checksum, which reads all of its memory.
+    SA_MAP_VERIFY = 1 << 1,
+};
+
+/// Save the used memory of a Stack Allocator to an image file.
+///
+/// The file is written to a temporary path and then renamed, so readers
+/// never see partial images.
+///
+/// @return Non-zero if the image was saved successfully.
+/// @return 0 otherwise, with `errno` describing the error.
+SA_MAP_DECL int sa_save(sa_stack_allocator *memory, const char *path);
+
+/// Map an image file saved with #sa_save as a Stack Allocator.
+///
+/// The allocator's marker resumes where it was when the image was saved.
+/// Unless SA_MAP_PRIVATE is passed, memory is read-only and the allocator
+/// has no available memory. With SA_MAP_PRIVATE, `extra_capacity` bytes of
+/// zeroed memory are available for new allocations after the saved ones.
+///
+/// @return Non-zero if the image was mapped successfully, to be unmapped with #sa_unmap.
+/// @return 0 otherwise, with `errno` describing the error. Invalid images and checksum mismatches set `EINVAL`.
+SA_MAP_DECL int sa_map(sa_stack_allocator *memory, const char *path, int flags, size_t extra_capacity);
+
+/// Unmap an allocator mapped with #sa_map, zeroing out all its fields.
+SA_MAP_DECL void sa_unmap(sa_stack_allocator *memory);
+
+/// Header at the start of files backing File-backed Stack Allocators, padded to SA_FILE_HEADER_SIZE.
+typedef struct sa_file_header {
+    char magic[8];       ///< "SAFILE" followed by null bytes.
+    uint32_t version;    ///< File format version, currently 1.
+    uint32_t header_size;  ///< SA_FILE_HEADER_SIZE, where the buffer starts.
+    uint64_t marker;     ///< Marker persisted by the last #sa_sync.
+} sa_file_header;
+
+#define SA_FILE_MAGIC "SAFILE"
+#define SA_FILE_VERSION 1
+/// Size reserved for the file header, so that the buffer is page aligned.
+#define SA_FILE_HEADER_SIZE 4096
+
+/// Initialize a Stack Allocator backed by the file at `path`, created if it doesn't exist.
+///
+/// The file is mapped with `MAP_SHARED` and grown to fit `capacity` bytes
+/// with `ftruncate`, so it's sparse and only uses disk space for touched pages.
+/// Files with more capacity are not shrunk.
+/// If the file already backed an allocator, the marker resumes where it
+/// was persisted by the last #sa_sync.
+///
+/// @return Non-zero if the allocator was initialized successfully, to be released with #sa_release_file_backed.
+/// @return 0 otherwise, with `errno` describing the error. Files not created by #sa_init_file_backed set `EINVAL`.
+SA_MAP_DECL int sa_init_file_backed(sa_stack_allocator *memory, const char *path, size_t capacity);
+
+/// Flush allocated memory of a File-backed Stack Allocator to its file and persist its marker.
+///
+/// Memory is flushed before the marker, so a persisted marker never
+/// refers to memory that was not written.
+///
+/// @return Non-zero if memory was flushed successfully.
+/// @return 0 otherwise, with `errno` describing the error.
+SA_MAP_DECL int sa_sync(sa_stack_allocator *memory);
+
+/// Advise the kernel that the buffer of a File-backed Stack Allocator will
+/// be accessed sequentially, for aggressive read-ahead and early page reclaim
+/// when streaming through data larger than RAM.
+///
+/// @return Non-zero if the advice was accepted.
+/// @return 0 otherwise, with `errno` describing the error.
+SA_MAP_DECL int sa_advise_sequential(sa_stack_allocator *memory);
+
+/// Persist the marker of a File-backed Stack Allocator with #sa_sync and
+/// unmap its file, zeroing out all its fields.
+///
+/// @return Non-zero if memory was flushed successfully.
+/// @return 0 otherwise, with `errno` describing the error. The allocator is released either way.
+SA_MAP_DECL int sa_release_file_backed(sa_stack_allocator *memory);
+
+/// Header at the start of shared memory, followed by the shared buffer.
+typedef struct sa_shared_header {
+    uint64_t magic;      ///< SA_SHARED_MAGIC, set when the shared memory is initialized.
+    uint64_t capacity;   ///< Shared buffer capacity.
+    uint64_t marker;     ///< Shared marker, only accessed atomically.
+    uint8_t reserved[40];
+} sa_shared_header;
+
+#define SA_SHARED_MAGIC 0x4445524148534153ull  // "SASHARED"
+
+/// Stack Allocator whose buffer and marker live in memory shared between processes.
+///
+/// Each process has its own `sa_shared_allocator` pointing to the shared memory,
+/// mapped at different addresses, so link data structures with `sa_offset`.
+typedef struct sa_shared_allocator {
+    sa_shared_header *header;  ///< Shared header, with the shared marker.
+    uint8_t *buffer;           ///< Shared buffer.
+    size_t capacity;           ///< Shared buffer capacity.
+    int fd;                    ///< Shared memory file descriptor.
+} sa_shared_allocator;
+
+/// Create shared memory with `capacity` bytes and map it as a Shared Stack Allocator.
+///
+/// If `name` is NULL, anonymous shared memory is created with `memfd_create`,
+/// shared with child processes by `fork` or by passing `memory->fd` to
+/// #sa_shared_attach_fd. Otherwise, POSIX shared memory object `name` is
+/// created with `shm_open`, failing if it already exists.
+///
+/// `capacity` must be at most #SA_OFFSET_RANGE, so that every allocation has an offset.
+///
+/// @return Non-zero if shared memory was created successfully.
+/// @return 0 otherwise, with `errno` describing the error. Capacities over #SA_OFFSET_RANGE set `EINVAL`.
+SA_MAP_DECL int sa_shared_create(sa_shared_allocator *memory, const char *name, size_t capacity);
+
+/// Attach to POSIX shared memory object `name` created by #sa_shared_create.
+///
+/// @return Non-zero if shared memory was attached successfully, to be detached with #sa_shared_detach.
+/// @return 0 otherwise, with `errno` describing the error. Memory not created by #sa_shared_create sets `EINVAL`.
+SA_MAP_DECL int sa_shared_attach(sa_shared_allocator *memory, const char *name);
+
+/// Attach to shared memory file descriptor `fd` created by #sa_shared_create.
+///
+/// `fd` is duplicated, so callers still own it.
+///
+/// @return Non-zero if shared memory was attached successfully, to be detached with #sa_shared_detach.
+/// @return 0 otherwise, with `errno` describing the error. Memory not created by #sa_shared_create sets `EINVAL`.
+SA_MAP_DECL int sa_shared_attach_fd(sa_shared_allocator *memory, int fd);
+
+/// Detach from shared memory, zeroing out all fields.
+///
+/// Shared memory is freed after every process detaches from it and, for
+/// named memory, after it's removed with #sa_shared_unlink.
+SA_MAP_DECL void sa_shared_detach(sa_shared_allocator *memory);
+
+/// Remove POSIX shared memory object `name`, so it can't be attached anymore.
+SA_MAP_DECL int sa_shared_unlink(const char *name);
+
+/// Allocate `size` bytes from shared memory, safe to call from multiple processes and threads.
+///
+/// @return Pointer to allocated memory, mapped in the calling process.
+/// @return NULL if there is not enough available memory.
+SA_MAP_DECL void *sa_shared_alloc(sa_shared_allocator *memory, size_t size);
+
+/// Allocate `size` bytes aligned to `alignment` from shared memory, safe to call from multiple processes and threads.
+///
+/// Buffer positions are aligned, so alignment is the same in every process.
+/// The buffer starts right after the #sa_shared_header in a page aligned
+/// mapping, so `alignment` can be no greater than `sizeof(sa_shared_header)`.
+///
+/// @warning `alignment` must be a power of two.
+///
+/// @return Pointer to allocated memory, mapped in the calling process.
+/// @return NULL if there is not enough available memory or `alignment` is too large.
+SA_MAP_DECL void *sa_shared_alloc_aligned(sa_shared_allocator *memory, size_t size, size_t alignment);
+
+/// Release all allocated memory.
+///
+/// @warning No process should be using allocated memory when clearing.
+SA_MAP_DECL void sa_shared_clear(sa_shared_allocator *memory);
+
+/// Get the shared marker.
+SA_MAP_DECL size_t sa_shared_get_marker(sa_shared_allocator *memory);
+
+/// Get the number of bytes available for allocations.
+SA_MAP_DECL size_t sa_shared_available_memory(sa_shared_allocator *memory);
+
+/// Get the number of bytes allocated.
+SA_MAP_DECL size_t sa_shared_used_memory(sa_shared_allocator *memory);
+
+/// Get the offset of a pointer allocated from shared memory, valid in every process.
+SA_MAP_DECL sa_offset sa_shared_ptr_to_offset(sa_shared_allocator *memory, const void *ptr);
+
+/// Get the pointer mapped in the calling process for an offset returned by #sa_shared_ptr_to_offset.
+SA_MAP_DECL void *sa_shared_offset_to_ptr(sa_shared_allocator *memory, sa_offset offset);
+
+/// Helper macro for allocating `type` from shared memory, aligned to its alignment.
+#define sa_shared_alloc_(memory, type) \
+    ((type *) sa_shared_alloc_aligned(memory, sizeof(type), SA_ALIGNOF(type)))
+/// Helper macro for allocating `n` elements of `type` from shared memory, aligned to its alignment.
+#define sa_shared_alloc_array_(memory, type, n) \
+    ((type *) sa_shared_alloc_aligned(memory, (n) * sizeof(type), SA_ALIGNOF(type)))
+/// Helper macro for converting an offset to a pointer to `type`.
+#define sa_shared_offset_to_ptr_(memory, type, offset) \
+    ((type *) sa_shared_offset_to_ptr(memory, offset))
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // MAPPED_STACK_ALLOCATOR_H
+
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef MAPPED_STACK_ALLOCATOR_IMPLEMENTATION
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+    #include <sys/syscall.h>
+#endif
+
+static uint64_t sa__fnv1a(const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *) data;
+    uint64_t hash = 14695981039346656037ull;
+    for(size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static int sa__write_all(int fd, const void *data, size_t size) {
+    const uint8_t *bytes = (const uint8_t *) data;
+    while(size > 0) {
+        ssize_t written = write(fd, bytes, size);
+        if(written < 0) {
+            if(errno == EINTR) continue;
+            return 0;
+        }
+        bytes += written;
+        size -= written;
+    }
+    return 1;
+}
+
+SA_MAP_DECL int sa_save(sa_stack_allocator *memory, const char *path) {
+    size_t path_length = strlen(path);
+    char *tmp_path = (char *) malloc(path_length + 5);
+    if(tmp_path == NULL) return 0;
+    memcpy(tmp_path, path, path_length);
+    memcpy(tmp_path + path_length, ".tmp", 5);
+
+    sa_image_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SA_IMAGE_MAGIC, sizeof(SA_IMAGE_MAGIC));
+    header.version = SA_IMAGE_VERSION;
+    header.header_size = sizeof(sa_image_header);
+    header.size = memory->marker;
+    header.checksum = sa__fnv1a(memory->buffer, memory->marker);
+
+    int success = 0;
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd >= 0) {
+        success = sa__write_all(fd, &header, sizeof(header))
+               && sa__write_all(fd, memory->buffer, memory->marker)
+               && fsync(fd) == 0;
+        if(close(fd) != 0) success = 0;
+        success = success && rename(tmp_path, path) == 0;
+        if(!success) {
+            int saved_errno = errno;
+            unlink(tmp_path);
+            errno = saved_errno;
+        }
+    }
+    free(tmp_path);
+    return success;
+}
+
+SA_MAP_DECL int sa_map(sa_stack_allocator *memory, const char *path, int flags, size_t extra_capacity) {
+    int fd = open(path, O_RDONLY);
+    if(fd < 0) return 0;
+
+    sa_image_header header;
+    struct stat st;
+    if(fstat(fd, &st) != 0) {
+        close(fd);
+        return 0;
+    }
+    if(pread(fd, &header, sizeof(header), 0) != sizeof(header)
+       || memcmp(header.magic, SA_IMAGE_MAGIC, sizeof(SA_IMAGE_MAGIC)) != 0
+       || header.version != SA_IMAGE_VERSION
+       || header.header_size != sizeof(sa_image_header)
+       || header.size > (uint64_t) st.st_size - sizeof(header)) {
+        close(fd);
+        errno = EINVAL;
+        return 0;
+    }
+
+    size_t file_size = sizeof(header) + header.size;
+    size_t map_size = file_size;
+    uint8_t *base;
+    if(flags & SA_MAP_PRIVATE) {
+        // Reserve room for the extra capacity, then map the image over its start
+        map_size += extra_capacity;
+        base = (uint8_t *) mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(base != MAP_FAILED
+           && mmap(base, file_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED) {
+            int saved_errno = errno;
+            munmap(base, map_size);
+            errno = saved_errno;
+            base = (uint8_t *) MAP_FAILED;
+        }
+    }
+    else {
+        base = (uint8_t *) mmap(NULL, map_size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    int saved_errno = errno;
+    close(fd);
+    if(base == MAP_FAILED) {
+        errno = saved_errno;
+        return 0;
+    }
+
+    uint8_t *buffer = base + sizeof(header);
+    if((flags & SA_MAP_VERIFY) && sa__fnv1a(buffer, header.size) != header.checksum) {
+        munmap(base, map_size);
+        errno = EINVAL;
+        return 0;
+    }
+
+    *memory = SA_NEW(buffer, map_size - sizeof(header));
+    memory->marker = header.size;
+    return 1;
+}
+
+SA_MAP_DECL void sa_unmap(sa_stack_allocator *memory) {
+    if(memory->buffer != NULL) {
+        munmap(((uint8_t *) memory->buffer) - sizeof(sa_image_header), memory->capacity + sizeof(sa_image_header));
+    }
+    *memory = (sa_stack_allocator){};
+}
+
+static sa_file_header *sa__file_header(sa_stack_allocator *memory) {
+    return (sa_file_header *) (((uint8_t *) memory->buffer) - SA_FILE_HEADER_SIZE);
+}
+
+static int sa__file_map(sa_stack_allocator *memory, int fd, size_t capacity) {
+    sa_file_header header;
+    struct stat st;
+    if(fstat(fd, &st) != 0) return 0;
+    if(st.st_size == 0) {
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, SA_FILE_MAGIC, sizeof(SA_FILE_MAGIC));
+        header.version = SA_FILE_VERSION;
+        header.header_size = SA_FILE_HEADER_SIZE;
+        if(pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) return 0;
+    }
+    else if(pread(fd, &header, sizeof(header), 0) != sizeof(header)
+            || memcmp(header.magic, SA_FILE_MAGIC, sizeof(SA_FILE_MAGIC)) != 0
+            || header.version != SA_FILE_VERSION
+            || header.header_size != SA_FILE_HEADER_SIZE
+            || (uint64_t) st.st_size < SA_FILE_HEADER_SIZE
+            || header.marker > (uint64_t) st.st_size - SA_FILE_HEADER_SIZE) {
+        errno = EINVAL;
+        return 0;
+    }
+
+    size_t size = SA_FILE_HEADER_SIZE + capacity;
+    if((uint64_t) st.st_size > size) {
+        size = st.st_size;
+    }
+    else if(ftruncate(fd, size) != 0) {
+        return 0;
+    }
+    uint8_t *base = (uint8_t *) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(base == MAP_FAILED) return 0;
+
+    *memory = SA_NEW(base + SA_FILE_HEADER_SIZE, size - SA_FILE_HEADER_SIZE);
+    memory->marker = header.marker;
+    return 1;
+}
+
+SA_MAP_DECL int sa_init_file_backed(sa_stack_allocator *memory, const char *path, size_t capacity) {
+    if(capacity > SIZE_MAX - SA_FILE_HEADER_SIZE) {
+        errno = ENOMEM;
+        return 0;
+    }
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if(fd < 0) return 0;
+    int success = sa__file_map(memory, fd, capacity);
+    // The mapping keeps the file alive, no need for keeping it open
+    int saved_errno = errno;
+    close(fd);
+    errno = saved_errno;
+    return success;
+}
+
+SA_MAP_DECL int sa_sync(sa_stack_allocator *memory) {
+    sa_file_header *header = sa__file_header(memory);
+    if(msync(memory->buffer, memory->marker, MS_SYNC) != 0) return 0;
+    header->marker = memory->marker;
+    return msync(header, SA_FILE_HEADER_SIZE, MS_SYNC) == 0;
+}
+
+SA_MAP_DECL int sa_advise_sequential(sa_stack_allocator *memory) {
+    return madvise(memory->buffer, memory->capacity, MADV_SEQUENTIAL) == 0;
+}
+
+SA_MAP_DECL int sa_release_file_backed(sa_stack_allocator *memory) {
+    int success = 1;
+    if(memory->buffer != NULL) {
+        success = sa_sync(memory);
+        int saved_errno = errno;
+        munmap(sa__file_header(memory), SA_FILE_HEADER_SIZE + memory->capacity);
+        errno = saved_errno;
+    }
+    *memory = (sa_stack_allocator){};
+    return success;
+}
+
+static int sa__shared_map(sa_shared_allocator *memory, int fd) {
+    struct stat st;
+    if(fstat(fd, &st) != 0) return 0;
+    if((uint64_t) st.st_size < sizeof(sa_shared_header)) {
+        errno = EINVAL;
+        return 0;
+    }
+    void *base = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(base == MAP_FAILED) return 0;
+    sa_shared_header *header = (sa_shared_header *) base;
+    if(__atomic_load_n(&header->magic, __ATOMIC_ACQUIRE) != SA_SHARED_MAGIC
+       || header->capacity != (uint64_t) st.st_size - sizeof(sa_shared_header)
+       || header->capacity > SA_OFFSET_RANGE) {
+        munmap(base, st.st_size);
+        errno = EINVAL;
+        return 0;
+    }
+    memory->header = header;
+    memory->buffer = (uint8_t *) (header + 1);
+    memory->capacity = header->capacity;
+    memory->fd = fd;
+    return 1;
+}
+
+SA_MAP_DECL int sa_shared_create(sa_shared_allocator *memory, const char *name, size_t capacity) {
+    if(capacity > SA_OFFSET_RANGE) {
+        errno = EINVAL;
+        return 0;
+    }
+    int fd;
+    if(name == NULL) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+        fd = (int) syscall(SYS_memfd_create, "sa_shared", 0);
+#else
+        // Emulate anonymous shared memory with a unique name unlinked right away
+        char unique_name[64];
+        snprintf(unique_name, sizeof(unique_name), "/sa_shared.%ld.%p", (long) getpid(), (void *) memory);
+        fd = shm_open(unique_name, O_RDWR | O_CREAT | O_EXCL, 0600);
+        if(fd >= 0) shm_unlink(unique_name);
+#endif
+    }
+    else {
+        fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    }
+    if(fd < 0) return 0;
+
+    size_t size = sizeof(sa_shared_header) + capacity;
+    void *base = MAP_FAILED;
+    if(size >= capacity && ftruncate(fd, size) == 0) {
+        base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    else if(size < capacity) {
+        errno = ENOMEM;
+    }
+    if(base == MAP_FAILED) {
+        int saved_errno = errno;
+        close(fd);
+        if(name != NULL) shm_unlink(name);
+        errno = saved_errno;
+        return 0;
+    }
+
+    sa_shared_header *header = (sa_shared_header *) base;
+    header->capacity = capacity;
+    header->marker = 0;
+    // Publish magic last, so attaching processes never see half initialized headers
+    __atomic_store_n(&header->magic, SA_SHARED_MAGIC, __ATOMIC_RELEASE);
+    memory->header = header;
+    memory->buffer = (uint8_t *) (header + 1);
+    memory->capacity = capacity;
+    memory->fd = fd;
+    return 1;
+}
+
+SA_MAP_DECL int sa_shared_attach(sa_shared_allocator *memory, const char *name) {
+    int fd = shm_open(name, O_RDWR, 0);
+    if(fd < 0) return 0;
+    if(!sa__shared_map(memory, fd)) {
+        int saved_errno = errno;
+        close(fd);
+        errno = saved_errno;
+        return 0;
+    }
+    return 1;
+}
+
+SA_MAP_DECL int sa_shared_attach_fd(sa_shared_allocator *memory, int fd) {
+    int dup_fd = dup(fd);
+    if(dup_fd < 0) return 0;
+    if(!sa__shared_map(memory, dup_fd)) {
+        int saved_errno = errno;
+        close(dup_fd);
+        errno = saved_errno;
+        return 0;
+    }
+    return 1;
+}
+
+SA_MAP_DECL void sa_shared_detach(sa_shared_allocator *memory) {
+    if(memory->header != NULL) {
+        munmap(memory->header, sizeof(sa_shared_header) + memory->capacity);
+        close(memory->fd);
+    }
+    *memory = (sa_shared_allocator){};
+}
+
+SA_MAP_DECL int sa_shared_unlink(const char *name) {
+    return shm_unlink(name) == 0;
+}
+
+SA_MAP_DECL void *sa_shared_alloc(sa_shared_allocator *memory, size_t size) {
+    uint64_t marker = __atomic_load_n(&memory->header->marker, __ATOMIC_RELAXED);
+    do {
+        if(size > memory->capacity - marker) return NULL;
+    } while(!__atomic_compare_exchange_n(&memory->header->marker, &marker, marker + size, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return memory->buffer + marker;
+}
+
+SA_MAP_DECL void *sa_shared_alloc_aligned(sa_shared_allocator *memory, size_t size, size_t alignment) {
+    if(alignment > sizeof(sa_shared_header)) return NULL;
+    uint64_t marker = __atomic_load_n(&memory->header->marker, __ATOMIC_RELAXED);
+    uint64_t start;
+    do {
+        start = (marker + (alignment - 1)) & ~(uint64_t) (alignment - 1);
+        if(start < marker || start > memory->capacity || size > memory->capacity - start) return NULL;
+    } while(!__atomic_compare_exchange_n(&memory->header->marker, &marker, start + size, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return memory->buffer + start;
+}
+
+SA_MAP_DECL void sa_shared_clear(sa_shared_allocator *memory) {
+    __atomic_store_n(&memory->header->marker, 0, __ATOMIC_RELAXED);
+}
+
+SA_MAP_DECL size_t sa_shared_get_marker(sa_shared_allocator *memory) {
+    return __atomic_load_n(&memory->header->marker, __ATOMIC_RELAXED);
+}
+
+SA_MAP_DECL size_t sa_shared_available_memory(sa_shared_allocator *memory) {
+    return memory->header ? memory->capacity - sa_shared_get_marker(memory) : 0;
+}
+
+SA_MAP_DECL size_t sa_shared_used_memory(sa_shared_allocator *memory) {
+    return memory->header ? sa_shared_get_marker(memory) : 0;
+}
+
+SA_MAP_DECL sa_offset sa_shared_ptr_to_offset(sa_shared_allocator *memory, const void *ptr) {
+    if(ptr == NULL) return SA_OFFSET_NULL;
+    return (sa_offset) ((const uint8_t *) ptr - memory->buffer) + 1;
+}
+
+SA_MAP_DECL void *sa_shared_offset_to_ptr(sa_shared_allocator *memory, sa_offset offset) {
+    if(offset == SA_OFFSET_NULL) return NULL;
+    return memory->buffer + (offset - 1);
+}
+
+#endif  // MAPPED_STACK_ALLOCATOR_IMPLEMENTATION
@@ -0,0 +1,398 @@
+/**
+ * multi_stack_allocator.h -- Multi Stack Allocator with dynamic boundaries
+ *
+ * Project URL: https://github.com/gilzoide/c-allocators
+ *
+ * Do this:
+ *    #define MULTI_STACK_ALLOCATOR_IMPLEMENTATION
+ * before you include this file in *one* C or C++ file to create the implementation.
+ *
+ * i.e.:
+ *   #include ...
+ *   #include ...
+ *   #define MULTI_STACK_ALLOCATOR_IMPLEMENTATION
+ *   #include "multi_stack_allocator.h"
+ *
+ * Multi Stack Allocators generalize Double Stack Allocators to any number of
+ * stacks sharing a single buffer, all growing upwards from their own base.
+ *
+ * When a stack grows into the next one, free memory is redistributed between
+ * all stacks and their data is moved with `memmove` (Garwick's algorithm):
+ * 10% of the free memory is split evenly and 90% in proportion to how much
+ * each stack grew since the last redistribution. Allocations only fail when
+ * there is no free memory left in the whole buffer.
+ *
+ * Since moving stacks invalidates pointers, allocations can be referenced by
+ * #msa_offset values relative to their stack's base, which remain valid.
+ * Markers are offsets too.
+ *
+ * Optionally provide the following defines with your own implementations:
+ *
+ * MSA_MALLOC(size)  - your own malloc function (default: malloc(size))
+ * MSA_FREE(p)       - your own free function (default: free(p))
+ * MSA_STATIC        - if defined and MSA_DECL is not defined, functions will be declared `static` instead of `extern`
+ * MSA_DECL          - function declaration prefix (default: `extern` or `static` depending on MSA_STATIC)
+ */
+#ifndef MULTI_STACK_ALLOCATOR_H
+#define MULTI_STACK_ALLOCATOR_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef MSA_DECL
+    #ifdef MSA_STATIC
+        #define MSA_DECL static
+    #else
+        #define MSA_DECL extern
+    #endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __cplusplus
+    #define MSA_ALIGNOF(type) alignof(type)
+#else
+    #define MSA_ALIGNOF(type) _Alignof(type)
+#endif
+
+/// Alignment of stack bases, the maximum alignment for allocations.
+#define MSA_ALIGNMENT 16
+
+/// Position of a memory block relative to its stack's base.
+///
+/// Offsets are stored biased by one, so that 0 represents NULL.
+/// They remain valid when stacks are moved.
+typedef size_t msa_offset;
+
+/// Offset that represents NULL.
+#define MSA_OFFSET_NULL ((msa_offset) 0)
+
+/// Bounds of a stack inside the Multi Stack Allocator buffer.
+typedef struct msa_stack {
+    size_t base;      ///< Start of the stack, aligned to MSA_ALIGNMENT.
+    size_t top;       ///< Marker that points to the next available memory block.
+    size_t old_top;   ///< Top at the last redistribution, used for measuring growth.
+} msa_stack;
+
+/// Multi Stack Allocator, with `stack_count` stacks sharing a buffer.
+///
+/// Stack `i` may grow up to the base of stack `i + 1`.
+typedef struct msa_multi_stack_allocator {
+    uint8_t *buffer;          ///< Memory buffer used, allocated together with stacks.
+    size_t capacity;          ///< Capacity of memory buffer.
+    msa_stack *stacks;        ///< Stack bounds, followed by a sentinel with base at `capacity`.
+    size_t stack_count;       ///< Number of stacks.
+    size_t relocations;       ///< Number of redistributions.
+    size_t relocated_bytes;   ///< Bytes moved by redistributions.
+} msa_multi_stack_allocator;
+
+/// Initializes a Multi Stack Allocator with `stack_count` stacks sharing a
+/// memory size, split evenly between them.
+///
+/// Uses MSA_MALLOC to allocate the buffer.
+/// Upon failure, allocator will have a capacity of 0.
+///
+/// @return Non-zero if memory was allocated successfully.
+/// @return 0 otherwise.
+MSA_DECL int msa_init_with_capacity(msa_multi_stack_allocator *memory, size_t stack_count, size_t capacity);
+
+/// Release the memory associated with a Multi Stack Allocator with MSA_FREE.
+///
+/// This also zeroes out all fields in Allocator.
+MSA_DECL void msa_release(msa_multi_stack_allocator *memory);
+
+/// Allocates a sized chunk of memory from a stack, moving other stacks if needed.
+///
+/// The returned pointer is only valid until the next allocation from any
+/// stack, which may move memory. Use #msa_alloc_offset to keep references.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available in the whole buffer.
+MSA_DECL void *msa_alloc(msa_multi_stack_allocator *memory, size_t stack, size_t size);
+/// Typed version of msa_alloc
+#define msa_alloc_(memory, stack, type) \
+    ((type *) msa_alloc((memory), (stack), sizeof(type)))
+
+/// Allocates a sized chunk of memory from a stack, with address aligned to
+/// `alignment` bytes, moving other stacks if needed.
+///
+/// `alignment` must be a power of two no greater than MSA_ALIGNMENT.
+/// Bytes skipped for alignment are freed together with the allocated block.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available in the whole buffer.
+MSA_DECL void *msa_alloc_aligned(msa_multi_stack_allocator *memory, size_t stack, size_t size, size_t alignment);
+/// Typed version of msa_alloc_aligned
+#define msa_alloc_aligned_(memory, stack, type) \
+    ((type *) msa_alloc_aligned((memory), (stack), sizeof(type), MSA_ALIGNOF(type)))
+
+/// Allocates a sized chunk of memory from a stack, returning its offset.
+///
+/// @return Offset of allocated block memory on success.
+/// @return #MSA_OFFSET_NULL if not enought memory is available in the whole buffer.
+MSA_DECL msa_offset msa_alloc_offset(msa_multi_stack_allocator *memory, size_t stack, size_t size);
+/// Typed version of msa_alloc_offset, allocating aligned memory for `type`
+#define msa_alloc_offset_(memory, stack, type) \
+    msa_ptr_to_offset((memory), (stack), msa_alloc_aligned((memory), (stack), sizeof(type), MSA_ALIGNOF(type)))
+
+/// Get the offset of `ptr` relative to a stack's base.
+///
+/// @return Offset of `ptr`, which may be converted back with #msa_offset_to_ptr.
+/// @return #MSA_OFFSET_NULL if `ptr` is NULL.
+MSA_DECL msa_offset msa_ptr_to_offset(msa_multi_stack_allocator *memory, size_t stack, const void *ptr);
+
+/// Get the pointer an offset refers to in a stack.
+///
+/// @return Pointer inside the stack, valid until the next allocation.
+/// @return NULL if `offset` is #MSA_OFFSET_NULL.
+MSA_DECL void *msa_offset_to_ptr(msa_multi_stack_allocator *memory, size_t stack, msa_offset offset);
+/// Typed version of msa_offset_to_ptr
+#define msa_offset_to_ptr_(memory, stack, type, offset) \
+    ((type *) msa_offset_to_ptr((memory), (stack), (offset)))
+
+/// Free all used memory from a stack, making it available for allocation once more.
+MSA_DECL void msa_clear(msa_multi_stack_allocator *memory, size_t stack);
+
+/// Free all used memory from every stack.
+MSA_DECL void msa_clear_all(msa_multi_stack_allocator *memory);
+
+/// Get a marker for the current allocation state of a stack.
+///
+/// Markers are relative to the stack's base, so they remain valid when stacks are moved.
+MSA_DECL size_t msa_get_marker(msa_multi_stack_allocator *memory, size_t stack);
+
+/// Free the used memory from a stack up until `marker`.
+///
+/// Memory is only freed if `marker` points to allocated memory, so invalid
+/// markers are ignored.
+MSA_DECL void msa_clear_marker(msa_multi_stack_allocator *memory, size_t stack, size_t marker);
+
+/// Free the last `size` bytes from a stack.
+///
+/// It's safe to pop more bytes than there are allocated.
+MSA_DECL void msa_pop(msa_multi_stack_allocator *memory, size_t stack, size_t size);
+/// Typed version of msa_pop
+#define msa_pop_(memory, stack, type) \
+    msa_pop((memory), (stack), sizeof(type))
+
+/// Retrieve a pointer to the top `size` bytes allocated from a stack.
+///
+/// @return Pointer to the allocated memory, if at least `size` bytes are allocated.
+/// @return NULL otherwise.
+MSA_DECL void *msa_peek(msa_multi_stack_allocator *memory, size_t stack, size_t size);
+/// Typed version of msa_peek
+#define msa_peek_(memory, stack, type) \
+    ((type *) msa_peek((memory), (stack), sizeof(type)))
+
+/// Get the quantity of free memory available in the whole buffer.
+MSA_DECL size_t msa_available_memory(msa_multi_stack_allocator *memory);
+
+/// Get the quantity of used memory in a stack.
+MSA_DECL size_t msa_used_memory(msa_multi_stack_allocator *memory, size_t stack);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // MULTI_STACK_ALLOCATOR_H
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(MULTI_STACK_ALLOCATOR_IMPLEMENTATION) && !defined(MULTI_STACK_ALLOCATOR_IMPLEMENTATION_INCLUDED)
+#define MULTI_STACK_ALLOCATOR_IMPLEMENTATION_INCLUDED
+
+#include <string.h>
+
+#ifndef MSA_MALLOC
+    #define MSA_MALLOC(size) malloc(size)
+#endif
+#ifndef MSA_FREE
+    #define MSA_FREE(p) free(p)
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define MSA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+    #define MSA_COLD __attribute__((cold, noinline))
+#else
+    #define MSA_UNLIKELY(x) (x)
+    #define MSA_COLD
+#endif
+
+#define MSA__ALIGN_DOWN(n) ((n) & ~(size_t) (MSA_ALIGNMENT - 1))
+#define MSA__ALIGN_UP(n) MSA__ALIGN_DOWN((n) + MSA_ALIGNMENT - 1)
+
+MSA_DECL int msa_init_with_capacity(msa_multi_stack_allocator *memory, size_t stack_count, size_t capacity) {
+    *memory = (msa_multi_stack_allocator){};
+    if(stack_count == 0 || stack_count >= SIZE_MAX / sizeof(msa_stack)) return 0;
+    // Stacks and the buffer in a single allocation, with the buffer aligned like stack bases
+    size_t stacks_size = MSA__ALIGN_UP((stack_count + 1) * sizeof(msa_stack));
+    capacity = MSA__ALIGN_DOWN(capacity);
+    if(capacity > SIZE_MAX - stacks_size) return 0;
+    msa_stack *stacks = (msa_stack *) MSA_MALLOC(stacks_size + capacity);
+    if(stacks == NULL) return 0;
+    size_t portion = MSA__ALIGN_DOWN(capacity / stack_count);
+    for(size_t i = 0; i < stack_count; i++) {
+        stacks[i] = (msa_stack){ i * portion, i * portion, i * portion };
+    }
+    stacks[stack_count] = (msa_stack){ capacity, capacity, capacity };
+    memory->buffer = ((uint8_t *) stacks) + stacks_size;
+    memory->capacity = capacity;
+    memory->stacks = stacks;
+    memory->stack_count = stack_count;
+    return 1;
+}
+
+MSA_DECL void msa_release(msa_multi_stack_allocator *memory) {
+    MSA_FREE(memory->stacks);
+    *memory = (msa_multi_stack_allocator){};
+}
+
+// Move a stack to the new base stored in its `old_top` field.
+static void msa__move_stack(msa_multi_stack_allocator *memory, msa_stack *stack) {
+    size_t used = stack->top - stack->base;
+    memmove(memory->buffer + stack->old_top, memory->buffer + stack->base, used);
+    memory->relocated_bytes += used;
+    stack->base = stack->old_top;
+    stack->top = stack->base + used;
+}
+
+// Redistribute free memory so that `stack` has at least `size` bytes available,
+// moving stacks with Garwick's algorithm. Kept out of line so the fast path stays small.
+static MSA_COLD int msa__make_room(msa_multi_stack_allocator *memory, size_t stack, size_t size) {
+    msa_stack *stacks = memory->stacks;
+    size_t count = memory->stack_count;
+    size_t needed = 0, total_growth = 0;
+    for(size_t i = 0; i < count; i++) {
+        size_t used = stacks[i].top - stacks[i].base;
+        if(i == stack) {
+            if(size > memory->capacity - used) return 0;
+            used += size;
+        }
+        needed += MSA__ALIGN_UP(used);
+        if(needed > memory->capacity) return 0;
+        size_t growth = stacks[i].top > stacks[i].old_top ? stacks[i].top - stacks[i].old_top : 0;
+        total_growth += growth + (i == stack ? size : 0);
+    }
+    size_t free_memory = memory->capacity - needed;
+    double even_share = (double) free_memory * 0.1 / count;
+    double growth_share = total_growth > 0 ? (double) free_memory * 0.9 / total_growth : 0;
+
+    // Compute new bases in the `old_top` fields, reset after moving
+    size_t base = 0;
+    for(size_t i = 0; i < count; i++) {
+        size_t used = stacks[i].top - stacks[i].base;
+        size_t growth = stacks[i].top > stacks[i].old_top ? stacks[i].top - stacks[i].old_top : 0;
+        if(i == stack) {
+            used += size;
+            growth += size;
+        }
+        // Clamped to the free memory left, in case of floating point rounding
+        size_t extra = MSA__ALIGN_DOWN((size_t) (even_share + growth * growth_share));
+        if(extra > free_memory) extra = free_memory;
+        free_memory -= extra;
+        stacks[i].old_top = base;
+        base += MSA__ALIGN_UP(used) + extra;
+    }
+
+    // Stacks moving down are moved first in ascending order and stacks moving
+    // up in descending order, so that no stack overwrites data not moved yet
+    for(size_t i = 0; i < count; i++) {
+        if(stacks[i].old_top < stacks[i].base) {
+            msa__move_stack(memory, &stacks[i]);
+        }
+    }
+    for(size_t i = count; i-- > 0; ) {
+        if(stacks[i].old_top > stacks[i].base) {
+            msa__move_stack(memory, &stacks[i]);
+        }
+    }
+    for(size_t i = 0; i < count; i++) {
+        stacks[i].old_top = stacks[i].top;
+    }
+    memory->relocations++;
+    return 1;
+}
+
+MSA_DECL void *msa_alloc_aligned(msa_multi_stack_allocator *memory, size_t stack, size_t size, size_t alignment) {
+    msa_stack *s = &memory->stacks[stack];
+    size_t padding = (size_t) (-(s->top - s->base) & (alignment - 1));
+    size_t available = s[1].base - s->top;
+    if(MSA_UNLIKELY(size > available || padding > available - size)) {
+        if(size > SIZE_MAX - padding || !msa__make_room(memory, stack, padding + size)) return NULL;
+    }
+    void *ptr = memory->buffer + s->top + padding;
+    s->top += padding + size;
+    return ptr;
+}
+
+MSA_DECL void *msa_alloc(msa_multi_stack_allocator *memory, size_t stack, size_t size) {
+    msa_stack *s = &memory->stacks[stack];
+    if(MSA_UNLIKELY(size > s[1].base - s->top) && !msa__make_room(memory, stack, size)) {
+        return NULL;
+    }
+    void *ptr = memory->buffer + s->top;
+    s->top += size;
+    return ptr;
+}
+
+MSA_DECL msa_offset msa_alloc_offset(msa_multi_stack_allocator *memory, size_t stack, size_t size) {
+    return msa_ptr_to_offset(memory, stack, msa_alloc(memory, stack, size));
+}
+
+MSA_DECL msa_offset msa_ptr_to_offset(msa_multi_stack_allocator *memory, size_t stack, const void *ptr) {
+    if(ptr == NULL) return MSA_OFFSET_NULL;
+    return (msa_offset) ((const uint8_t *) ptr - (memory->buffer + memory->stacks[stack].base)) + 1;
+}
+
+MSA_DECL void *msa_offset_to_ptr(msa_multi_stack_allocator *memory, size_t stack, msa_offset offset) {
+    if(offset == MSA_OFFSET_NULL) return NULL;
+    return memory->buffer + memory->stacks[stack].base + (offset - 1);
+}
+
+MSA_DECL void msa_clear(msa_multi_stack_allocator *memory, size_t stack) {
+    memory->stacks[stack].top = memory->stacks[stack].base;
+}
+
+MSA_DECL void msa_clear_all(msa_multi_stack_allocator *memory) {
+    for(size_t i = 0; i < memory->stack_count; i++) {
+        msa_clear(memory, i);
+    }
+}
+
+MSA_DECL size_t msa_get_marker(msa_multi_stack_allocator *memory, size_t stack) {
+    return msa_used_memory(memory, stack);
+}
+
+MSA_DECL void msa_clear_marker(msa_multi_stack_allocator *memory, size_t stack, size_t marker) {
+    msa_stack *s = &memory->stacks[stack];
+    if(marker < s->top - s->base) {
+        s->top = s->base + marker;
+    }
+}
+
+MSA_DECL void msa_pop(msa_multi_stack_allocator *memory, size_t stack, size_t size) {
+    msa_stack *s = &memory->stacks[stack];
+    s->top -= size > s->top - s->base ? s->top - s->base : size;
+}
+
+MSA_DECL void *msa_peek(msa_multi_stack_allocator *memory, size_t stack, size_t size) {
+    msa_stack *s = &memory->stacks[stack];
+    if(MSA_UNLIKELY(s->top - s->base < size)) return NULL;
+    return memory->buffer + s->top - size;
+}
+
+MSA_DECL size_t msa_available_memory(msa_multi_stack_allocator *memory) {
+    size_t used = 0;
+    for(size_t i = 0; i < memory->stack_count; i++) {
+        used += msa_used_memory(memory, i);
+    }
+    return memory->capacity - used;
+}
+
+MSA_DECL size_t msa_used_memory(msa_multi_stack_allocator *memory, size_t stack) {
+    return memory->stacks[stack].top - memory->stacks[stack].base;
+}
+
+#endif  // MULTI_STACK_ALLOCATOR_IMPLEMENTATION
@@ -0,0 +1,255 @@
+/**
+ * partitioned_allocator.h -- Partitioned Allocator with capacity stealing
+ *
+ * Project URL: https://github.com/gilzoide/c-allocators
+ *
+ * Do this:
+ *    #define PARTITIONED_ALLOCATOR_IMPLEMENTATION
+ * before you include this file in *one* C or C++ file to create the implementation.
+ *
+ * i.e.:
+ *   #include ...
+ *   #include ...
+ *   #define PARTITIONED_ALLOCATOR_IMPLEMENTATION
+ *   #include "partitioned_allocator.h"
+ *
+ * Partitioned Allocators carve one buffer into sub-stacks for a fixed
+ * number of workers, usually one per thread, that adapt to uneven load.
+ *
+ * Workers are paired and each pair shares a region like a Double Stack
+ * Allocator: even workers allocate from the bottom and odd workers from the
+ * top, so either one can use all of the pair's free memory. Both ends of a
+ * region are packed into a single 64-bit word updated with compare-and-swap.
+ * When a pair's region is full, workers steal free memory from the other
+ * pairs' regions instead of failing.
+ *
+ * Memory is only released all at once with #pa_clear.
+ *
+ * Optionally provide the following defines with your own implementations:
+ *
+ * PA_MALLOC(size)  - your own malloc function (default: malloc(size))
+ * PA_FREE(p)       - your own free function (default: free(p))
+ * PA_STATIC        - if defined and PA_DECL is not defined, functions will be declared `static` instead of `extern`
+ * PA_DECL          - function declaration prefix (default: `extern` or `static` depending on PA_STATIC)
+ */
+#ifndef PARTITIONED_ALLOCATOR_H
+#define PARTITIONED_ALLOCATOR_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef PA_DECL
+    #ifdef PA_STATIC
+        #define PA_DECL static
+    #else
+        #define PA_DECL extern
+    #endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __cplusplus
+    #define PA_ALIGNOF(type) alignof(type)
+    #define PA_ALIGNAS(n) alignas(n)
+#else
+    #define PA_ALIGNOF(type) _Alignof(type)
+    #define PA_ALIGNAS(n) _Alignas(n)
+#endif
+
+/// Cache line size, the alignment of regions and maximum allocation alignment.
+#define PA_CACHE_LINE 64
+
+/// Region shared by a pair of workers, in its own cache line.
+typedef struct pa_pair {
+    PA_ALIGNAS(PA_CACHE_LINE) uint64_t bounds;  ///< Top offset in the high 32 bits, bottom offset in the low 32 bits, only accessed atomically.
+    uint8_t *buffer;                            ///< Region memory.
+    uint32_t capacity;                          ///< Region capacity.
+} pa_pair;
+
+/// Partitioned Allocator, with regions shared by pairs of workers.
+typedef struct pa_partitioned_allocator {
+    pa_pair *pairs;          ///< Regions, one per pair of workers.
+    size_t pair_count;       ///< Number of pairs, half the number of workers rounded up.
+    size_t worker_count;     ///< Number of workers.
+    void *buffer;            ///< Memory for pairs and their regions, allocated with PA_MALLOC.
+    int steal;               ///< Whether to steal memory from other pairs when a pair's region is full, enabled by default.
+    uint64_t steal_count;    ///< Number of allocations stolen from other pairs, only accessed atomically.
+} pa_partitioned_allocator;
+
+/// Initializes a Partitioned Allocator with `capacity` bytes split evenly between `worker_count` workers.
+///
+/// Each pair of workers shares a region of less than 4GB.
+///
+/// @return Non-zero if memory was allocated successfully.
+/// @return 0 otherwise.
+PA_DECL int pa_init(pa_partitioned_allocator *memory, size_t capacity, size_t worker_count);
+
+/// Release the memory associated with a Partitioned Allocator.
+///
+/// This also zeroes out all fields in Allocator.
+PA_DECL void pa_release(pa_partitioned_allocator *memory);
+
+/// Allocates a sized chunk of memory for `worker`, from its pair's region or stolen from other pairs.
+///
+/// Safe to call from multiple threads concurrently.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+PA_DECL void *pa_alloc(pa_partitioned_allocator *memory, size_t worker, size_t size);
+/// Typed version of pa_alloc
+#define pa_alloc_(memory, worker, type) \
+    ((type *) pa_alloc_aligned((memory), (worker), sizeof(type), PA_ALIGNOF(type)))
+
+/// Allocates a sized chunk of memory for `worker`, with address aligned to
+/// `alignment` bytes, which must be a power of two no greater than PA_CACHE_LINE.
+///
+/// Safe to call from multiple threads concurrently.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+PA_DECL void *pa_alloc_aligned(pa_partitioned_allocator *memory, size_t worker, size_t size, size_t alignment);
+
+/// Release all allocated memory from every region.
+///
+/// @warning No thread should be allocating when clearing.
+PA_DECL void pa_clear(pa_partitioned_allocator *memory);
+
+/// Get the number of bytes available for allocations in every region.
+PA_DECL size_t pa_available_memory(pa_partitioned_allocator *memory);
+
+/// Get the number of bytes allocated from every region.
+PA_DECL size_t pa_used_memory(pa_partitioned_allocator *memory);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // PARTITIONED_ALLOCATOR_H
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(PARTITIONED_ALLOCATOR_IMPLEMENTATION) && !defined(PARTITIONED_ALLOCATOR_IMPLEMENTATION_INCLUDED)
+#define PARTITIONED_ALLOCATOR_IMPLEMENTATION_INCLUDED
+
+#ifndef PA_MALLOC
+    #define PA_MALLOC(size) malloc(size)
+#endif
+#ifndef PA_FREE
+    #define PA_FREE(p) free(p)
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define PA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+    #define PA_UNLIKELY(x) (x)
+#endif
+
+#define PA__BOUNDS(bottom, top) ((((uint64_t) (top)) << 32) | (uint64_t) (bottom))
+
+PA_DECL int pa_init(pa_partitioned_allocator *memory, size_t capacity, size_t worker_count) {
+    *memory = (pa_partitioned_allocator){};
+    if(worker_count == 0) return 0;
+    size_t pair_count = (worker_count + 1) / 2;
+    // Regions are rounded down to cache lines, so that they are aligned
+    size_t region_capacity = capacity / pair_count & ~(size_t) (PA_CACHE_LINE - 1);
+    if(region_capacity > UINT32_MAX) return 0;
+
+    // Pairs and their regions in a single allocation, with pairs aligned to cache lines
+    size_t header_size = (pair_count + 1) * sizeof(pa_pair);
+    uint8_t *buffer = (uint8_t *) PA_MALLOC(header_size + pair_count * region_capacity);
+    if(buffer == NULL) return 0;
+    pa_pair *pairs = (pa_pair *) (((uintptr_t) buffer + PA_CACHE_LINE - 1) & ~(uintptr_t) (PA_CACHE_LINE - 1));
+    uint8_t *regions = (uint8_t *) (pairs + pair_count);
+    for(size_t i = 0; i < pair_count; i++) {
+        pairs[i] = (pa_pair){};
+        pairs[i].bounds = PA__BOUNDS(0, region_capacity);
+        pairs[i].buffer = regions + i * region_capacity;
+        pairs[i].capacity = (uint32_t) region_capacity;
+    }
+    memory->pairs = pairs;
+    memory->pair_count = pair_count;
+    memory->worker_count = worker_count;
+    memory->buffer = buffer;
+    memory->steal = 1;
+    return 1;
+}
+
+PA_DECL void pa_release(pa_partitioned_allocator *memory) {
+    PA_FREE(memory->buffer);
+    *memory = (pa_partitioned_allocator){};
+}
+
+static void *pa__pair_alloc(pa_pair *pair, size_t size, size_t alignment, int from_top) {
+    uint64_t bounds = __atomic_load_n(&pair->bounds, __ATOMIC_RELAXED);
+    uint64_t start, new_bounds;
+    do {
+        uint64_t bottom = (uint32_t) bounds;
+        uint64_t top = bounds >> 32;
+        if(from_top) {
+            if(size > top) return NULL;
+            start = (top - size) & ~(uint64_t) (alignment - 1);
+            if(start < bottom) return NULL;
+            new_bounds = PA__BOUNDS(bottom, start);
+        }
+        else {
+            start = (bottom + alignment - 1) & ~(uint64_t) (alignment - 1);
+            if(start > top || size > top - start) return NULL;
+            new_bounds = PA__BOUNDS(start + size, top);
+        }
+    } while(!__atomic_compare_exchange_n(&pair->bounds, &bounds, new_bounds, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return pair->buffer + start;
+}
+
+static void *pa__steal(pa_partitioned_allocator *memory, size_t pair_index, size_t size, size_t alignment, int from_top) {
+    for(size_t i = 1; i < memory->pair_count; i++) {
+        pa_pair *pair = &memory->pairs[(pair_index + i) % memory->pair_count];
+        void *ptr = pa__pair_alloc(pair, size, alignment, from_top);
+        if(ptr != NULL) {
+            __atomic_fetch_add(&memory->steal_count, 1, __ATOMIC_RELAXED);
+            return ptr;
+        }
+    }
+    return NULL;
+}
+
+PA_DECL void *pa_alloc_aligned(pa_partitioned_allocator *memory, size_t worker, size_t size, size_t alignment) {
+    size_t pair_index = worker / 2;
+    int from_top = worker & 1;
+    void *ptr = pa__pair_alloc(&memory->pairs[pair_index], size, alignment, from_top);
+    if(PA_UNLIKELY(ptr == NULL) && memory->steal) {
+        ptr = pa__steal(memory, pair_index, size, alignment, from_top);
+    }
+    return ptr;
+}
+
+PA_DECL void *pa_alloc(pa_partitioned_allocator *memory, size_t worker, size_t size) {
+    return pa_alloc_aligned(memory, worker, size, 1);
+}
+
+PA_DECL void pa_clear(pa_partitioned_allocator *memory) {
+    for(size_t i = 0; i < memory->pair_count; i++) {
+        __atomic_store_n(&memory->pairs[i].bounds, PA__BOUNDS(0, memory->pairs[i].capacity), __ATOMIC_RELAXED);
+    }
+    __atomic_store_n(&memory->steal_count, 0, __ATOMIC_RELAXED);
+}
+
+PA_DECL size_t pa_available_memory(pa_partitioned_allocator *memory) {
+    size_t available = 0;
+    for(size_t i = 0; i < memory->pair_count; i++) {
+        uint64_t bounds = __atomic_load_n(&memory->pairs[i].bounds, __ATOMIC_RELAXED);
+        available += (bounds >> 32) - (uint32_t) bounds;
+    }
+    return available;
+}
+
+PA_DECL size_t pa_used_memory(pa_partitioned_allocator *memory) {
+    size_t used = 0;
+    for(size_t i = 0; i < memory->pair_count; i++) {
+        used += memory->pairs[i].capacity;
+    }
+    return used - pa_available_memory(memory);
+}
+
+#endif  // PARTITIONED_ALLOCATOR_IMPLEMENTATION
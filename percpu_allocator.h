@@ -0,0 +1,305 @@
+/**
+ * percpu_allocator.h -- Per-CPU Stack Allocators
+ *
+ * Project URL: https://github.com/gilzoide/c-allocators
+ *
+ * Do this:
+ *    #define PERCPU_ALLOCATOR_IMPLEMENTATION
+ * before you include this file in *one* C or C++ file to create the implementation.
+ *
+ * i.e.:
+ *   #include ...
+ *   #include ...
+ *   #define PERCPU_ALLOCATOR_IMPLEMENTATION
+ *   #include "percpu_allocator.h"
+ *
+ * Per-CPU Allocators hold one Stack Allocator slice per CPU, so that any
+ * number of threads allocate from as many arenas as there are CPUs, without
+ * contending on a single shared marker.
+ *
+ * On x86_64 Linux with glibc 2.35 or newer, allocations run inside a
+ * restartable sequence (rseq) critical section: the kernel restarts it if
+ * the thread is preempted or migrated to another CPU before the marker is
+ * updated, so allocating is a plain load, compare and store.
+ * Otherwise, allocations find the current CPU with `sched_getcpu` and
+ * update its marker with compare-and-swap.
+ *
+ * Allocations fail when the current CPU's slice is full, even if other
+ * slices have available memory.
+ *
+ * This file uses stack_allocator.h, whose implementation must also be
+ * created in some C or C++ file. Linux only.
+ *
+ * Optionally provide the following defines with your own implementations:
+ *
+ * SA_PERCPU_NO_RSEQ  - if defined, always use compare-and-swap instead of rseq
+ * SA_PERCPU_STATIC   - if defined and SA_PERCPU_DECL is not defined, functions will be declared `static` instead of `extern`
+ * SA_PERCPU_DECL     - function declaration prefix (default: `extern` or `static` depending on SA_PERCPU_STATIC)
+ */
+#ifndef PERCPU_ALLOCATOR_H
+#define PERCPU_ALLOCATOR_H
+
+#include "stack_allocator.h"
+
+#ifndef SA_PERCPU_DECL
+    #ifdef SA_PERCPU_STATIC
+        #define SA_PERCPU_DECL static
+    #else
+        #define SA_PERCPU_DECL extern
+    #endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __cplusplus
+    #define SA_PERCPU_ALIGNOF(type) alignof(type)
+    #define SA_PERCPU_ALIGNAS(n) alignas(n)
+#else
+    #define SA_PERCPU_ALIGNOF(type) _Alignof(type)
+    #define SA_PERCPU_ALIGNAS(n) _Alignas(n)
+#endif
+
+/// A CPU's Stack Allocator, in its own cache line.
+typedef struct sa_percpu_slice {
+    SA_PERCPU_ALIGNAS(64) sa_stack_allocator stack;
+} sa_percpu_slice;
+
+/// Per-CPU Allocator, with one Stack Allocator slice per CPU.
+typedef struct sa_percpu_allocator {
+    sa_percpu_slice *slices;  ///< Slices, indexed by CPU number, aligned to cache lines inside `buffer`.
+    size_t slice_count;       ///< Number of slices, the number of configured CPUs.
+    void *buffer;             ///< Memory for slices and their buffers, allocated with SA_MALLOC.
+    int use_rseq;             ///< Whether allocations use rseq. May be set to 0 before allocating to force compare-and-swap.
+} sa_percpu_allocator;
+
+/// Initializes a Per-CPU Allocator with `capacity` bytes for each configured CPU.
+///
+/// Capacity is rounded up to a multiple of 16, so every slice buffer starts
+/// aligned like `malloc` memory.
+///
+/// @return Non-zero if memory was allocated successfully.
+/// @return 0 otherwise.
+SA_PERCPU_DECL int sa_percpu_init(sa_percpu_allocator *memory, size_t capacity);
+
+/// Release the memory associated with a Per-CPU Allocator.
+///
+/// This also zeroes out all fields in Allocator.
+SA_PERCPU_DECL void sa_percpu_release(sa_percpu_allocator *memory);
+
+/// Allocates a sized chunk of memory from the current CPU's slice.
+///
+/// Safe to call from any number of threads concurrently.
+/// Memory is not aligned: allocating sizes that are multiples of an
+/// alignment keeps blocks aligned.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available in the current CPU's slice.
+SA_PERCPU_DECL void *sa_percpu_alloc(sa_percpu_allocator *memory, size_t size);
+/// Typed version of sa_percpu_alloc
+#define sa_percpu_alloc_(memory, type) \
+    ((type *) sa_percpu_alloc((memory), sizeof(type)))
+
+/// Release all allocated memory from every slice.
+///
+/// @warning No thread should be allocating when clearing.
+SA_PERCPU_DECL void sa_percpu_clear(sa_percpu_allocator *memory);
+
+/// Get the number of bytes allocated from every slice.
+SA_PERCPU_DECL size_t sa_percpu_used_memory(sa_percpu_allocator *memory);
+
+/// Whether rseq is available, so that allocations avoid compare-and-swap.
+SA_PERCPU_DECL int sa_percpu_rseq_available(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // PERCPU_ALLOCATOR_H
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(PERCPU_ALLOCATOR_IMPLEMENTATION) && !defined(PERCPU_ALLOCATOR_IMPLEMENTATION_INCLUDED)
+#define PERCPU_ALLOCATOR_IMPLEMENTATION_INCLUDED
+
+#include <sched.h>
+#include <stddef.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#if !defined(SA_PERCPU_NO_RSEQ) && defined(__x86_64__) && defined(__linux__) && defined(__has_include)
+    #if __has_include(<sys/rseq.h>)
+        #include <sys/rseq.h>
+        #define SA_PERCPU_RSEQ 1
+    #endif
+#endif
+
+#ifndef SA_MALLOC
+    #define SA_MALLOC(size) malloc(size)
+#endif
+#ifndef SA_FREE
+    #define SA_FREE(p) free(p)
+#endif
+
+SA_PERCPU_DECL int sa_percpu_rseq_available(void) {
+#ifdef SA_PERCPU_RSEQ
+    // glibc registers rseq for every thread, unless disabled by tunables or unsupported by the kernel
+    return __rseq_size > 0;
+#else
+    return 0;
+#endif
+}
+
+SA_PERCPU_DECL int sa_percpu_init(sa_percpu_allocator *memory, size_t capacity) {
+    *memory = (sa_percpu_allocator){};
+    long cpus = sysconf(_SC_NPROCESSORS_CONF);
+    size_t slice_count = cpus > 0 ? (size_t) cpus : 1;
+    size_t header_size = slice_count * sizeof(sa_percpu_slice) + SA_PERCPU_ALIGNOF(sa_percpu_slice) - 1;
+    if(capacity > SIZE_MAX - 15) return 0;
+    capacity = (capacity + 15) & ~(size_t) 15;
+    if(capacity > 0 && slice_count > (SIZE_MAX - header_size) / capacity) return 0;
+
+    // Slices and their buffers in a single allocation, with slices aligned to cache lines
+    uint8_t *buffer = (uint8_t *) SA_MALLOC(header_size + slice_count * capacity);
+    if(buffer == NULL) return 0;
+    uintptr_t alignment = SA_PERCPU_ALIGNOF(sa_percpu_slice);
+    sa_percpu_slice *slices = (sa_percpu_slice *) (((uintptr_t) buffer + alignment - 1) & ~(alignment - 1));
+    // Slices are a multiple of their alignment in size, so buffers start aligned past them
+    uint8_t *slice_buffers = (uint8_t *) (slices + slice_count);
+    for(size_t i = 0; i < slice_count; i++) {
+        slices[i] = (sa_percpu_slice){};
+        slices[i].stack = SA_NEW(slice_buffers + i * capacity, capacity);
+    }
+    memory->slices = slices;
+    memory->slice_count = slice_count;
+    memory->buffer = buffer;
+    memory->use_rseq = sa_percpu_rseq_available();
+    return 1;
+}
+
+SA_PERCPU_DECL void sa_percpu_release(sa_percpu_allocator *memory) {
+    SA_FREE(memory->buffer);
+    *memory = (sa_percpu_allocator){};
+}
+
+#ifdef SA_PERCPU_RSEQ
+enum {
+    SA_PERCPU__RSEQ_OK,
+    SA_PERCPU__RSEQ_RETRY,
+    SA_PERCPU__RSEQ_FULL,
+};
+
+// Bump `stack`'s marker if the thread is still running on `cpu`, restarted by the kernel on preemption or migration
+static inline int sa__percpu_rseq_bump(struct rseq *rs, sa_stack_allocator *stack, uint32_t cpu, size_t size, size_t *marker) {
+    int status;
+    size_t old_marker, new_marker;
+    __asm__ __volatile__(
+        // Critical section descriptor: start, length and abort handler
+        ".pushsection __rseq_cs, \"aw\"\n\t"
+        ".balign 32\n\t"
+        "3:\n\t"
+        ".long 0, 0\n\t"
+        ".quad 1f, (2f - 1f), 4f\n\t"
+        ".popsection\n\t"
+        "leaq 3b(%%rip), %[new_marker]\n\t"
+        "movq %[new_marker], %c[rseq_cs](%[rs])\n\t"
+        "movl %[retry], %[status]\n\t"
+        "1:\n\t"
+        "cmpl %[cpu], %c[cpu_id](%[rs])\n\t"
+        "jnz 6f\n\t"
+        "movq %c[marker_offset](%[stack]), %[old_marker]\n\t"
+        "movq %[old_marker], %[new_marker]\n\t"
+        "addq %[size], %[new_marker]\n\t"
+        "jc 5f\n\t"
+        "cmpq %c[capacity_offset](%[stack]), %[new_marker]\n\t"
+        "ja 5f\n\t"
+        "movl %[ok], %[status]\n\t"
+        // Commit: the single store that makes the allocation visible
+        "movq %[new_marker], %c[marker_offset](%[stack])\n\t"
+        "2:\n\t"
+        "jmp 6f\n\t"
+        "5:\n\t"
+        "movl %[full], %[status]\n\t"
+        "jmp 6f\n\t"
+        // Abort handler, preceded by the signature registered by glibc
+        ".pushsection __rseq_failure, \"ax\"\n\t"
+        ".byte 0x0f, 0xb9, 0x3d\n\t"
+        ".long %c[sig]\n\t"
+        "4:\n\t"
+        "movl %[retry], %[status]\n\t"
+        "jmp 6f\n\t"
+        ".popsection\n\t"
+        "6:\n\t"
+        : [status] "=&r" (status), [old_marker] "=&r" (old_marker), [new_marker] "=&r" (new_marker)
+        : [rs] "r" (rs), [stack] "r" (stack), [cpu] "r" (cpu), [size] "r" (size),
+          [rseq_cs] "i" (offsetof(struct rseq, rseq_cs)), [cpu_id] "i" (offsetof(struct rseq, cpu_id)),
+          [marker_offset] "i" (offsetof(sa_stack_allocator, marker)),
+          [capacity_offset] "i" (offsetof(sa_stack_allocator, capacity)),
+          [sig] "i" (RSEQ_SIG), [ok] "i" (SA_PERCPU__RSEQ_OK), [retry] "i" (SA_PERCPU__RSEQ_RETRY), [full] "i" (SA_PERCPU__RSEQ_FULL)
+        : "memory", "cc"
+    );
+    *marker = old_marker;
+    return status;
+}
+
+static void *sa__percpu_rseq_alloc(sa_percpu_allocator *memory, size_t size) {
+    uint8_t *thread_pointer;
+    __asm__("movq %%fs:0, %0" : "=r" (thread_pointer));
+    struct rseq *rs = (struct rseq *) (thread_pointer + __rseq_offset);
+    for(;;) {
+        uint32_t cpu = __atomic_load_n(&rs->cpu_id_start, __ATOMIC_RELAXED);
+        if(cpu >= memory->slice_count) return NULL;
+        sa_stack_allocator *stack = &memory->slices[cpu].stack;
+        size_t marker;
+        switch(sa__percpu_rseq_bump(rs, stack, cpu, size, &marker)) {
+            case SA_PERCPU__RSEQ_OK:
+                return ((uint8_t *) stack->buffer) + marker;
+            case SA_PERCPU__RSEQ_FULL:
+                return NULL;
+            default:
+                break;
+        }
+    }
+}
+#endif
+
+static void *sa__percpu_atomic_alloc(sa_percpu_allocator *memory, size_t size) {
+    unsigned cpu = 0;
+#ifdef _GNU_SOURCE
+    int current_cpu = sched_getcpu();
+    if(current_cpu >= 0) cpu = (unsigned) current_cpu;
+#else
+    syscall(SYS_getcpu, &cpu, NULL, NULL);
+#endif
+    // Slices are picked modulo count, since CPUs may be shared without rseq
+    sa_stack_allocator *stack = &memory->slices[cpu % memory->slice_count].stack;
+    size_t marker = __atomic_load_n(&stack->marker, __ATOMIC_RELAXED);
+    do {
+        if(size > stack->capacity - marker) return NULL;
+    } while(!__atomic_compare_exchange_n(&stack->marker, &marker, marker + size, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+    return ((uint8_t *) stack->buffer) + marker;
+}
+
+SA_PERCPU_DECL void *sa_percpu_alloc(sa_percpu_allocator *memory, size_t size) {
+#ifdef SA_PERCPU_RSEQ
+    if(memory->use_rseq) return sa__percpu_rseq_alloc(memory, size);
+#endif
+    return sa__percpu_atomic_alloc(memory, size);
+}
+
+SA_PERCPU_DECL void sa_percpu_clear(sa_percpu_allocator *memory) {
+    for(size_t i = 0; i < memory->slice_count; i++) {
+        sa_clear(&memory->slices[i].stack);
+    }
+}
+
+SA_PERCPU_DECL size_t sa_percpu_used_memory(sa_percpu_allocator *memory) {
+    size_t used = 0;
+    for(size_t i = 0; i < memory->slice_count; i++) {
+        used += __atomic_load_n(&memory->slices[i].stack.marker, __ATOMIC_RELAXED);
+    }
+    return used;
+}
+
+#endif  // PERCPU_ALLOCATOR_IMPLEMENTATION
@@ -0,0 +1,344 @@
+/**
+ * ring_allocator.h -- Ring Allocator implementation
+ *
+ * Project URL: https://github.com/gilzoide/c-allocators
+ *
+ * Do this:
+ *    #define RING_ALLOCATOR_IMPLEMENTATION
+ * before you include this file in *one* C or C++ file to create the implementation.
+ *
+ * i.e.:
+ *   #include ...
+ *   #include ...
+ *   #define RING_ALLOCATOR_IMPLEMENTATION
+ *   #include "ring_allocator.h"
+ *
+ * Ring Allocators allocate at the head of a circular buffer and free at its
+ * tail, so memory is released oldest first, like a FIFO queue of streaming
+ * data such as packets.
+ *
+ * The buffer is mapped twice back-to-back in virtual memory, so that
+ * allocations crossing the end of the buffer continue at its start and are
+ * still contiguous in memory.
+ * Head and tail are byte counters that only grow, so full and empty buffers
+ * are told apart without wasting space.
+ *
+ * Besides single-threaded functions, `ra_spsc_*` functions support one
+ * producer thread allocating and one consumer thread freeing concurrently
+ * without locks.
+ *
+ * POSIX only: buffers are mapped using `memfd_create`, or `shm_open` where
+ * it's not available.
+ *
+ * Optionally provide the following defines with your own implementations:
+ *
+ * RA_STATIC  - if defined and RA_DECL is not defined, functions will be declared `static` instead of `extern`
+ * RA_DECL    - function declaration prefix (default: `extern` or `static` depending on RA_STATIC)
+ */
+#ifndef RING_ALLOCATOR_H
+#define RING_ALLOCATOR_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef RA_DECL
+    #ifdef RA_STATIC
+        #define RA_DECL static
+    #else
+        #define RA_DECL extern
+    #endif
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef __cplusplus
+    #define RA_ALIGNOF(type) alignof(type)
+    #define RA_ALIGNAS(n) alignas(n)
+#else
+    #define RA_ALIGNOF(type) _Alignof(type)
+    #define RA_ALIGNAS(n) _Alignas(n)
+#endif
+
+/// Cache line size used to keep head and tail from sharing cache lines.
+#define RA_CACHE_LINE 64
+
+/// Ring Allocator, allocating at the head and freeing at the tail of a mirrored buffer.
+typedef struct ra_ring_allocator {
+    uint8_t *buffer;  ///< Memory buffer, mapped twice back-to-back.
+    size_t capacity;  ///< Buffer capacity, a power of two multiple of the page size.
+    RA_ALIGNAS(RA_CACHE_LINE) size_t head;  ///< Total bytes allocated, written by the producer.
+    size_t cached_tail;  ///< Producer's copy of tail, used by `ra_spsc_*` functions.
+    RA_ALIGNAS(RA_CACHE_LINE) size_t tail;  ///< Total bytes freed, written by the consumer.
+    size_t cached_head;  ///< Consumer's copy of head, used by `ra_spsc_*` functions.
+} ra_ring_allocator;
+
+/// Initializes a Ring Allocator with a mirrored buffer of at least `capacity` bytes.
+///
+/// Capacity is rounded up to a power of two multiple of the page size.
+/// Upon failure, allocator will have a capacity of 0.
+///
+/// @return Non-zero if memory was mapped successfully.
+/// @return 0 otherwise, with `errno` describing the error.
+RA_DECL int ra_init_with_capacity(ra_ring_allocator *memory, size_t capacity);
+
+/// Release the memory associated with a Ring Allocator.
+///
+/// This also zeroes out all fields in Allocator.
+RA_DECL void ra_release(ra_ring_allocator *memory);
+
+/// Allocates a sized chunk of memory at the head of a Ring Allocator.
+///
+/// Memory is contiguous even if it crosses the end of the buffer.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+RA_DECL void *ra_alloc(ra_ring_allocator *memory, size_t size);
+/// Typed version of ra_alloc
+#define ra_alloc_(memory, type) \
+    ((type *) ra_alloc_aligned((memory), sizeof(type), RA_ALIGNOF(type)))
+
+/// Allocates a sized chunk of memory at the head of a Ring Allocator, with
+/// address aligned to `alignment` bytes, which must be a power of two no
+/// greater than the page size.
+///
+/// Padding is freed by #ra_free_aligned with the same size and alignment.
+///
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+RA_DECL void *ra_alloc_aligned(ra_ring_allocator *memory, size_t size, size_t alignment);
+
+/// Frees the oldest `size` bytes at the tail of a Ring Allocator.
+///
+/// Blocks must be freed in the order they were allocated.
+/// Freeing more than the used memory frees all of it.
+RA_DECL void ra_free(ra_ring_allocator *memory, size_t size);
+
+/// Frees the oldest block allocated by #ra_alloc_aligned with the same `size` and `alignment`, including its padding.
+RA_DECL void ra_free_aligned(ra_ring_allocator *memory, size_t size, size_t alignment);
+/// Typed version of ra_free_aligned
+#define ra_free_(memory, type) \
+    ra_free_aligned((memory), sizeof(type), RA_ALIGNOF(type))
+
+/// Get the oldest allocated memory, at the tail of a Ring Allocator.
+///
+/// If `size` is not NULL, it receives the number of used bytes, all
+/// contiguous starting at the returned pointer.
+///
+/// @return Pointer to oldest allocated memory.
+/// @return NULL if Ring Allocator is empty.
+RA_DECL void *ra_peek(ra_ring_allocator *memory, size_t *size);
+
+/// Get the oldest block allocated by #ra_alloc_aligned with `alignment`, skipping its padding.
+///
+/// @return Pointer to oldest allocated memory.
+/// @return NULL if Ring Allocator is empty.
+RA_DECL void *ra_peek_aligned(ra_ring_allocator *memory, size_t alignment);
+/// Typed version of ra_peek_aligned
+#define ra_peek_(memory, type) \
+    ((type *) ra_peek_aligned((memory), RA_ALIGNOF(type)))
+
+/// Frees all allocated memory.
+RA_DECL void ra_clear(ra_ring_allocator *memory);
+
+/// Get the number of bytes available for allocations.
+RA_DECL size_t ra_available_memory(ra_ring_allocator *memory);
+
+/// Get the number of bytes allocated and not yet freed.
+RA_DECL size_t ra_used_memory(ra_ring_allocator *memory);
+
+/// Reserves a sized chunk of memory at the head of a Ring Allocator, from the producer thread.
+///
+/// Memory is only visible to the consumer thread after #ra_spsc_commit.
+/// Allocating sizes that are multiples of an alignment keeps every block aligned.
+///
+/// @return Reserved block memory on success.
+/// @return NULL if not enought memory is available.
+RA_DECL void *ra_spsc_reserve(ra_ring_allocator *memory, size_t size);
+
+/// Publishes `size` bytes reserved by #ra_spsc_reserve to the consumer thread.
+RA_DECL void ra_spsc_commit(ra_ring_allocator *memory, size_t size);
+
+/// Get the oldest published memory, from the consumer thread.
+///
+/// If `size` is not NULL, it receives the number of published bytes, all
+/// contiguous starting at the returned pointer.
+///
+/// @return Pointer to oldest published memory.
+/// @return NULL if there is no published memory.
+RA_DECL void *ra_spsc_peek(ra_ring_allocator *memory, size_t *size);
+
+/// Frees the oldest `size` bytes of published memory, from the consumer thread,
+/// making them available to the producer thread.
+RA_DECL void ra_spsc_free(ra_ring_allocator *memory, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RING_ALLOCATOR_H
+
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(RING_ALLOCATOR_IMPLEMENTATION) && !defined(RING_ALLOCATOR_IMPLEMENTATION_INCLUDED)
+#define RING_ALLOCATOR_IMPLEMENTATION_INCLUDED
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#ifdef __linux__
+    #include <sys/syscall.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+    #define RA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+    #define RA_UNLIKELY(x) (x)
+#endif
+
+static int ra__create_fd(void *unique) {
+#if defined(__linux__) && defined(SYS_memfd_create)
+    (void) unique;
+    return (int) syscall(SYS_memfd_create, "ra_ring_allocator", 0);
+#else
+    // Emulate anonymous memory with a unique name unlinked right away
+    char name[64];
+    snprintf(name, sizeof(name), "/ra_ring.%ld.%p", (long) getpid(), unique);
+    int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if(fd >= 0) shm_unlink(name);
+    return fd;
+#endif
+}
+
+RA_DECL int ra_init_with_capacity(ra_ring_allocator *memory, size_t capacity) {
+    *memory = (ra_ring_allocator){};
+    size_t rounded = (size_t) sysconf(_SC_PAGESIZE);
+    while(rounded < capacity) {
+        rounded <<= 1;
+        if(rounded == 0 || rounded > SIZE_MAX / 2) {
+            errno = ENOMEM;
+            return 0;
+        }
+    }
+
+    int fd = ra__create_fd(memory);
+    if(fd < 0) return 0;
+    uint8_t *buffer = (uint8_t *) MAP_FAILED;
+    if(ftruncate(fd, rounded) == 0) {
+        // Reserve address space for both copies, then map the same memory over each half
+        buffer = (uint8_t *) mmap(NULL, 2 * rounded, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(buffer != MAP_FAILED
+           && (mmap(buffer, rounded, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED
+               || mmap(buffer + rounded, rounded, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)) {
+            int saved_errno = errno;
+            munmap(buffer, 2 * rounded);
+            errno = saved_errno;
+            buffer = (uint8_t *) MAP_FAILED;
+        }
+    }
+    // The mappings keep the memory alive, no need for keeping it open
+    int saved_errno = errno;
+    close(fd);
+    errno = saved_errno;
+    if(buffer == MAP_FAILED) return 0;
+
+    memory->buffer = buffer;
+    memory->capacity = rounded;
+    return 1;
+}
+
+RA_DECL void ra_release(ra_ring_allocator *memory) {
+    if(memory->buffer != NULL) {
+        munmap(memory->buffer, 2 * memory->capacity);
+    }
+    *memory = (ra_ring_allocator){};
+}
+
+RA_DECL void *ra_alloc(ra_ring_allocator *memory, size_t size) {
+    if(RA_UNLIKELY(size > memory->capacity - (memory->head - memory->tail))) return NULL;
+    uint8_t *ptr = memory->buffer + (memory->head & (memory->capacity - 1));
+    memory->head += size;
+    return ptr;
+}
+
+RA_DECL void *ra_alloc_aligned(ra_ring_allocator *memory, size_t size, size_t alignment) {
+    size_t available = memory->capacity - (memory->head - memory->tail);
+    size_t padding = (0 - memory->head) & (alignment - 1);
+    if(RA_UNLIKELY(size > available || padding > available - size)) return NULL;
+    memory->head += padding;
+    uint8_t *ptr = memory->buffer + (memory->head & (memory->capacity - 1));
+    memory->head += size;
+    return ptr;
+}
+
+RA_DECL void ra_free(ra_ring_allocator *memory, size_t size) {
+    size_t used = memory->head - memory->tail;
+    memory->tail += size < used ? size : used;
+}
+
+RA_DECL void ra_free_aligned(ra_ring_allocator *memory, size_t size, size_t alignment) {
+    size_t padding = (0 - memory->tail) & (alignment - 1);
+    ra_free(memory, padding + size);
+}
+
+RA_DECL void *ra_peek(ra_ring_allocator *memory, size_t *size) {
+    size_t used = memory->head - memory->tail;
+    if(size) *size = used;
+    if(used == 0) return NULL;
+    return memory->buffer + (memory->tail & (memory->capacity - 1));
+}
+
+RA_DECL void *ra_peek_aligned(ra_ring_allocator *memory, size_t alignment) {
+    size_t used = memory->head - memory->tail;
+    size_t padding = (0 - memory->tail) & (alignment - 1);
+    if(used <= padding) return NULL;
+    return memory->buffer + ((memory->tail + padding) & (memory->capacity - 1));
+}
+
+RA_DECL void ra_clear(ra_ring_allocator *memory) {
+    memory->head = memory->tail = 0;
+    memory->cached_head = memory->cached_tail = 0;
+}
+
+RA_DECL size_t ra_available_memory(ra_ring_allocator *memory) {
+    return memory->capacity - (memory->head - memory->tail);
+}
+
+RA_DECL size_t ra_used_memory(ra_ring_allocator *memory) {
+    return memory->head - memory->tail;
+}
+
+RA_DECL void *ra_spsc_reserve(ra_ring_allocator *memory, size_t size) {
+    size_t head = memory->head;
+    if(RA_UNLIKELY(size > memory->capacity - (head - memory->cached_tail))) {
+        // Only read the consumer's cache line when the cached tail is not enough
+        memory->cached_tail = __atomic_load_n(&memory->tail, __ATOMIC_ACQUIRE);
+        if(size > memory->capacity - (head - memory->cached_tail)) return NULL;
+    }
+    return memory->buffer + (head & (memory->capacity - 1));
+}
+
+RA_DECL void ra_spsc_commit(ra_ring_allocator *memory, size_t size) {
+    __atomic_store_n(&memory->head, memory->head + size, __ATOMIC_RELEASE);
+}
+
+RA_DECL void *ra_spsc_peek(ra_ring_allocator *memory, size_t *size) {
+    size_t tail = memory->tail;
+    if(memory->cached_head == tail) {
+        // Only read the producer's cache line when all cached data was consumed
+        memory->cached_head = __atomic_load_n(&memory->head, __ATOMIC_ACQUIRE);
+    }
+    size_t used = memory->cached_head - tail;
+    if(size) *size = used;
+    if(used == 0) return NULL;
+    return memory->buffer + (tail & (memory->capacity - 1));
+}
+
+RA_DECL void ra_spsc_free(ra_ring_allocator *memory, size_t size) {
+    __atomic_store_n(&memory->tail, memory->tail + size, __ATOMIC_RELEASE);
+}
+
+#endif  // RING_ALLOCATOR_IMPLEMENTATION
@@ -18,16 +18,35 @@
  * SA_MALLOC(size)  - your own malloc function (default: malloc(size))
  * SA_FREE(p)       - your own free function (default: free(p))
  * SA_STATIC        - if defined and SA_DECL is not defined, functions will be declared `static` instead of `extern`
- * SA_DECL          - function declaration prefix (default: `extern` or `static` depending on SA_STATIC)
+ * SA_INLINE        - if defined, functions are defined `static inline` in every file that includes this header,
+ *                    so that allocations can be inlined. STACK_ALLOCATOR_IMPLEMENTATION is not needed then.
+ * SA_DECL          - function declaration prefix (default: `extern`, `static` or `static inline` depending on
+ *                    SA_STATIC and SA_INLINE)
+ * SA_CLEANUP       - if defined, enables cleanup functions registered with #sa_push_cleanup.
+ *                    Must be defined equally in every file that includes this header.
+ * SA_STATS         - if defined, gathers allocation statistics, queried with #sa_get_stats.
+ *                    Must be defined equally in every file that includes this header.
+ * SA_OVERFLOW      - if defined, enables overflow handlers set with #sa_set_overflow_handler.
+ *                    Must be defined equally in every file that includes this header.
+ * SA_MARKER_STACK  - if defined, enables marker stacks kept in the buffer with #sa_push_marker.
+ *                    Must be defined equally in every file that includes this header.
+ * SA_TRACE(event, memory, size, marker)
+ *                  - called after allocations and frees, with `event` being one of the tokens
+ *                    SA_ALLOC, SA_ALLOC_FAILED, SA_POP, SA_CLEAR_MARKER or SA_RELEASE, `size` the
+ *                    number of bytes requested or freed and `marker` the resulting marker (default: nothing).
+ *                    alloc_trace.h provides an implementation that records events to a file.
  */
 
 #ifndef STACK_ALLOCATOR_H
 #define STACK_ALLOCATOR_H
 
+#include <stdint.h>
 #include <stdlib.h>
 
 #ifndef SA_DECL
-    #ifdef SA_STATIC
+    #if defined(SA_INLINE)
+        #define SA_DECL static inline
+    #elif defined(SA_STATIC)
         #define SA_DECL static
     #else
         #define SA_DECL extern
@@ -38,6 +57,79 @@
 extern "C" {
 #endif
 
+#ifdef __cplusplus
+    #define SA_ALIGNOF(type) alignof(type)
+#else
+    #define SA_ALIGNOF(type) _Alignof(type)
+#endif
+
+#ifdef SA_CLEANUP
+/// Function called when memory is freed past its cleanup entry.
+typedef void (*sa_cleanup_fn)(void *ctx);
+
+/// Cleanup entry, stored in the Stack Allocator buffer itself.
+typedef struct sa_cleanup {
+    sa_cleanup_fn fn;              ///< Function to be called.
+    void *ctx;                     ///< Argument passed to `fn`.
+    struct sa_cleanup *previous;   ///< Previously registered entry.
+} sa_cleanup;
+#endif
+
+#ifdef SA_STATS
+/// Number of buckets in the allocation size histogram.
+#define SA_STATS_BUCKETS (sizeof(size_t) * 8 + 1)
+
+/// Allocation statistics of a Stack Allocator.
+typedef struct sa_stats {
+    size_t peak;                ///< Highest memory usage.
+    size_t allocations;         ///< Number of successful allocations.
+    size_t failed_allocations;  ///< Number of allocations that returned NULL.
+    size_t alignment_waste;     ///< Bytes skipped for aligning allocations.
+    /// Successful allocations by size: bucket 0 counts empty allocations,
+    /// bucket `i` counts sizes from `2^(i-1)` up to `2^i - 1`.
+    size_t size_histogram[SA_STATS_BUCKETS];
+} sa_stats;
+#endif
+
+#ifdef SA_OVERFLOW
+/// Function that allocates `size` bytes from an upstream allocator, aligned like `malloc`.
+typedef void *(*sa_overflow_alloc_fn)(void *ctx, size_t size);
+/// Function that frees memory returned by a #sa_overflow_alloc_fn.
+typedef void (*sa_overflow_free_fn)(void *ctx, void *ptr);
+
+/// Header of a block spilled to the overflow handler, stored before the block itself.
+typedef struct sa_spill {
+    struct sa_spill *previous;  ///< Previously spilled block.
+    size_t marker;              ///< Marker before the block was spilled.
+} sa_spill;
+
+/// Overflow handler and spilled blocks of a Stack Allocator.
+typedef struct sa_overflow {
+    sa_overflow_alloc_fn alloc;  ///< Upstream allocation function, NULL if disabled.
+    sa_overflow_free_fn free;    ///< Upstream free function.
+    void *ctx;                   ///< Argument passed to `alloc` and `free`.
+    sa_spill *spills;            ///< Last spilled block that was not freed yet.
+    size_t live_spills;          ///< Number of spilled blocks not freed yet, counted in markers.
+    size_t spill_count;          ///< Number of allocations spilled since the handler was set.
+    size_t spilled_bytes;        ///< Bytes requested by allocations spilled since the handler was set.
+} sa_overflow;
+#endif
+
+/// Position of a memory block inside a Stack Allocator's buffer.
+///
+/// Offsets are stored biased by one, so that 0 represents NULL and
+/// zero-initialized memory holds null offsets.
+/// Data structures linked by offsets instead of pointers take half the
+/// space on 64-bit platforms and remain valid when the buffer is moved,
+/// copied or mapped somewhere else.
+typedef uint32_t sa_offset;
+
+/// Offset that represents NULL.
+#define SA_OFFSET_NULL ((sa_offset) 0)
+
+/// Number of bytes at the start of a buffer that offsets can refer to, a little under 4GB.
+#define SA_OFFSET_RANGE ((size_t) UINT32_MAX)
+
 /// A static stack allocator.
 /// 
 /// Memory blocks pushed have increasing addresses.
@@ -47,6 +139,18 @@ typedef struct sa_stack_allocator {
     void *buffer;     ///< Memory buffer used.
     size_t capacity;  ///< Capacity of memory buffer.
     size_t marker;    ///< Marker that points to the next available memory block.
+#ifdef SA_MARKER_STACK
+    size_t marker_stack;  ///< Position of the last marker pushed with #sa_push_marker biased by one, 0 if there is none.
+#endif
+#ifdef SA_CLEANUP
+    sa_cleanup *cleanup;  ///< Last registered cleanup entry.
+#endif
+#ifdef SA_STATS
+    sa_stats stats;       ///< Allocation statistics.
+#endif
+#ifdef SA_OVERFLOW
+    sa_overflow overflow; ///< Overflow handler and spilled blocks.
+#endif
 } sa_stack_allocator;
 
 /// Helper macro to construct Stack Allocators from already allocated buffer
@@ -119,6 +223,19 @@ SA_DECL void *sa_alloc(sa_stack_allocator *memory, size_t size);
 #define sa_alloc_(memory, type) \
     ((type *) sa_alloc((memory), sizeof(type)))
 
+/// Allocates a sized chunk of memory from Stack Allocator, with address
+/// aligned to `alignment` bytes.
+/// 
+/// `alignment` must be a power of two.
+/// Bytes skipped for alignment are freed together with the allocated block.
+/// 
+/// @return Allocated block memory on success.
+/// @return NULL if not enought memory is available.
+SA_DECL void *sa_alloc_aligned(sa_stack_allocator *memory, size_t size, size_t alignment);
+/// Typed version of sa_alloc_aligned
+#define sa_alloc_aligned_(memory, type) \
+    ((type *) sa_alloc_aligned((memory), sizeof(type), SA_ALIGNOF(type)))
+
 // Aliases for Stack implementation semantics.
 #define sa_push sa_alloc
 #define sa_push_ sa_alloc_
@@ -134,6 +251,8 @@ SA_DECL void sa_clear(sa_stack_allocator *memory);
 /// Get a marker for the current allocation state.
 /// 
 /// The result can be used for freeing a Stack Allocator back to this state.
+/// Blocks spilled with #sa_set_overflow_handler count as one byte each, so
+/// markers got before and after a spill differ.
 SA_DECL size_t sa_get_marker(sa_stack_allocator *memory);
 
 /// Free the used memory from Stack Allocator up until `marker`, making it
@@ -147,6 +266,25 @@ SA_DECL size_t sa_get_marker(sa_stack_allocator *memory);
 /// To actually reclaim the used memory for the OS, use #sa_release instead.
 SA_DECL void sa_clear_marker(sa_stack_allocator *memory, size_t marker);
 
+#ifdef SA_MARKER_STACK
+/// Save the current marker in the Stack Allocator itself.
+///
+/// Markers are pushed on a stack stored in the allocator's buffer, so deep
+/// recursion can checkpoint without caller-side storage.
+/// Freeing memory past a pushed marker also discards it.
+///
+/// @return Non-zero if the marker was pushed.
+/// @return 0 if not enought memory is available.
+SA_DECL int sa_push_marker(sa_stack_allocator *memory);
+
+/// Free the used memory from Stack Allocator up until the last marker
+/// pushed with #sa_push_marker, discarding it.
+///
+/// @return Non-zero if a marker was popped.
+/// @return 0 if there are no pushed markers.
+SA_DECL int sa_pop_marker(sa_stack_allocator *memory);
+#endif
+
 /// Free the last `size` bytes from Stack Allocator.
 ///
 /// It's safe to pop more bytes than there are allocated.
@@ -170,15 +308,183 @@ SA_DECL size_t sa_available_memory(sa_stack_allocator *memory);
 /// Get the quantity of used memory in a Stack Allocator.
 SA_DECL size_t sa_used_memory(sa_stack_allocator *memory);
 
+/// Get the offset of `ptr` relative to a Stack Allocator's buffer.
+///
+/// `ptr` must be NULL or point inside the buffer.
+///
+/// @return Offset of `ptr`, which may be converted back with #sa_offset_to_ptr.
+/// @return #SA_OFFSET_NULL if `ptr` is NULL or past the first #SA_OFFSET_RANGE bytes of the buffer.
+SA_DECL sa_offset sa_ptr_to_offset(sa_stack_allocator *memory, const void *ptr);
+
+/// Get the pointer an offset refers to in a Stack Allocator's buffer.
+///
+/// @return Pointer inside the buffer.
+/// @return NULL if `offset` is #SA_OFFSET_NULL.
+SA_DECL void *sa_offset_to_ptr(sa_stack_allocator *memory, sa_offset offset);
+/// Typed version of sa_offset_to_ptr
+#define sa_offset_to_ptr_(memory, type, offset) \
+    ((type *) sa_offset_to_ptr((memory), (offset)))
+
+/// Allocates a sized chunk of memory from Stack Allocator, returning its offset.
+///
+/// @return Offset of allocated block memory on success.
+/// @return #SA_OFFSET_NULL if not enought memory is available or the block
+///         would start past the first #SA_OFFSET_RANGE bytes of the buffer.
+SA_DECL sa_offset sa_alloc_offset(sa_stack_allocator *memory, size_t size);
+
+/// Allocates a sized chunk of memory from Stack Allocator, with address
+/// aligned to `alignment` bytes, returning its offset.
+///
+/// @return Offset of allocated block memory on success.
+/// @return #SA_OFFSET_NULL if not enought memory is available or the block
+///         would start past the first #SA_OFFSET_RANGE bytes of the buffer.
+SA_DECL sa_offset sa_alloc_offset_aligned(sa_stack_allocator *memory, size_t size, size_t alignment);
+/// Typed version of sa_alloc_offset, allocating aligned memory for `type`
+#define sa_alloc_offset_(memory, type) \
+    sa_alloc_offset_aligned((memory), sizeof(type), SA_ALIGNOF(type))
+
+/// Initializes `child` as a Stack Allocator using `capacity` bytes of the parent's free memory.
+///
+/// The child's buffer is allocated from `parent` like any other block, so
+/// nested subsystems get isolated arenas without calling SA_MALLOC.
+/// Children may have children of their own.
+/// Until the child is finished with #sa_child_end or #sa_child_commit,
+/// `parent` must not be allocated from or freed past the child's buffer.
+///
+/// Upon failure, `child` will have a capacity of 0.
+///
+/// @return Non-zero if the child was created successfully.
+/// @return 0 if not enought memory is available in `parent`.
+SA_DECL int sa_child_begin(sa_stack_allocator *parent, sa_stack_allocator *child, size_t capacity);
+/// Typed version of sa_child_begin
+#define sa_child_begin_(parent, child, type, capacity) \
+    sa_child_begin((parent), (child), sizeof(type) * (capacity))
+
+/// Free all memory used by `child`, returning its buffer to `parent`.
+///
+/// This also zeroes out all fields in `child`.
+SA_DECL void sa_child_end(sa_stack_allocator *parent, sa_stack_allocator *child);
+
+/// Keep the memory used by `child` as a single allocation in `parent`,
+/// returning only its unused memory.
+///
+/// Cleanup entries registered in `child` are moved to `parent`.
+/// Blocks spilled by `child` are moved to `parent` if both use the same
+/// overflow handler, otherwise they are freed.
+/// This also zeroes out all fields in `child`.
+SA_DECL void sa_child_commit(sa_stack_allocator *parent, sa_stack_allocator *child);
+
+#ifdef SA_CLEANUP
+/// Register a function to be called when memory is freed past this point.
+/// 
+/// The entry is allocated from the Stack Allocator itself, so no extra
+/// memory is needed.
+/// Cleanup functions run in reverse order of registration whenever
+/// #sa_clear, #sa_clear_marker, #sa_pop or #sa_release free the entry.
+/// They must not allocate from the same Stack Allocator.
+/// 
+/// @return Non-zero if the entry was registered.
+/// @return 0 if not enought memory is available.
+SA_DECL int sa_push_cleanup(sa_stack_allocator *memory, sa_cleanup_fn fn, void *ctx);
+#endif
+
+#ifdef SA_OVERFLOW
+/// Set a handler that supplies memory from an upstream allocator when the
+/// Stack Allocator's buffer is full, instead of returning NULL.
+///
+/// Spilled blocks are tracked with a small header and freed with `free_fn`
+/// by #sa_clear, #sa_clear_marker and #sa_release, like memory allocated
+/// from the buffer at the same point. #sa_pop doesn't free them.
+/// Spills are counted in the `overflow` field, to help sizing buffers.
+///
+/// Memory that must live in the buffer is never spilled: offsets, cleanup
+/// entries, pushed markers and children.
+/// Pass NULL `alloc_fn` to disable spilling.
+///
+/// @warning The handler must not be changed while there are spilled blocks.
+SA_DECL void sa_set_overflow_handler(sa_stack_allocator *memory, sa_overflow_alloc_fn alloc_fn, sa_overflow_free_fn free_fn, void *ctx);
+#endif
+
+#ifdef SA_STATS
+/// Get the allocation statistics gathered since the allocator was created
+/// or since the last #sa_reset_stats.
+SA_DECL const sa_stats *sa_get_stats(sa_stack_allocator *memory);
+
+/// Reset allocation statistics.
+/// 
+/// Peak usage starts over from the current memory usage.
+SA_DECL void sa_reset_stats(sa_stack_allocator *memory);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
 #ifdef __cplusplus
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace sa {
+
+namespace detail {
+    template<typename T>
+    void destroy(void *object) {
+        static_cast<T *>(object)->~T();
+    }
+
+    template<typename T, bool = std::is_trivially_destructible<T>::value>
+    struct destructor {
+        static bool push(sa_stack_allocator *, T *) { return true; }
+    };
+
+    template<typename T>
+    struct destructor<T, false> {
+        static bool push(sa_stack_allocator *memory, T *object) {
+#ifdef SA_CLEANUP
+            return sa_push_cleanup(memory, &destroy<T>, object);
+#else
+            static_assert(sizeof(T) == 0, "sa::make needs SA_CLEANUP for types that are not trivially destructible");
+            return false;
+#endif
+        }
+    };
+}
+
+/// Construct a `T` in memory allocated from Stack Allocator.
+/// 
+/// If `T` is not trivially destructible, its destructor is registered with
+/// #sa_push_cleanup, so it runs when the object's memory is freed.
+/// 
+/// @return Constructed object on success.
+/// @return NULL if not enought memory is available.
+template<typename T, typename... Args>
+T *make(sa_stack_allocator *memory, Args&&... args) {
+    size_t marker = sa_get_marker(memory);
+    void *ptr = sa_alloc_aligned(memory, sizeof(T), alignof(T));
+    if(ptr == NULL) return NULL;
+    T *object = new (ptr) T(std::forward<Args>(args)...);
+    if(!detail::destructor<T>::push(memory, object)) {
+        object->~T();
+        sa_clear_marker(memory, marker);
+        return NULL;
+    }
+    return object;
+}
+
 }
 #endif
 
 #endif  // __STACK_ALLOCATOR_H__
 
+#if defined(SA_INLINE) && !defined(STACK_ALLOCATOR_IMPLEMENTATION)
+    #define STACK_ALLOCATOR_IMPLEMENTATION
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////
 
-#ifdef STACK_ALLOCATOR_IMPLEMENTATION
+#if defined(STACK_ALLOCATOR_IMPLEMENTATION) && !defined(STACK_ALLOCATOR_IMPLEMENTATION_INCLUDED)
+#define STACK_ALLOCATOR_IMPLEMENTATION_INCLUDED
 
 #include <stdint.h>
 
@@ -189,6 +495,174 @@ SA_DECL size_t sa_used_memory(sa_stack_allocator *memory);
     #define SA_FREE(size) free(size)
 #endif
 
+#if defined(__GNUC__) || defined(__clang__)
+    #define SA_LIKELY(x) __builtin_expect(!!(x), 1)
+    #define SA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+    #define SA_COLD __attribute__((cold, noinline))
+#else
+    #define SA_LIKELY(x) (x)
+    #define SA_UNLIKELY(x) (x)
+    #define SA_COLD
+#endif
+
+#ifdef SA_CLEANUP
+    #define SA_RUN_CLEANUPS(memory, marker) sa__run_cleanups((memory), (marker))
+#else
+    #define SA_RUN_CLEANUPS(memory, marker)
+#endif
+
+#ifdef SA_MARKER_STACK
+    #define SA_DROP_MARKERS(memory, marker) sa__drop_markers((memory), (marker))
+    #define SA_RESET_MARKERS(memory) ((memory)->marker_stack = 0)
+#else
+    #define SA_DROP_MARKERS(memory, marker)
+    #define SA_RESET_MARKERS(memory)
+#endif
+
+#ifndef SA_TRACE
+    #define SA_TRACE(event, memory, size, marker)
+#endif
+
+#ifdef SA_OVERFLOW
+    #define SA_ALLOC_FALLBACK(memory, size, alignment, failed_size) sa__spill((memory), (size), (alignment), (failed_size))
+    #define SA_FREE_SPILLS(memory, marker) sa__free_spills((memory), (marker))
+    #define SA_LOWER_SPILLS(memory) sa__lower_spills(memory)
+#else
+    #define SA_ALLOC_FALLBACK(memory, size, alignment, failed_size) sa__alloc_failed((memory), (failed_size))
+    #define SA_FREE_SPILLS(memory, marker)
+    #define SA_LOWER_SPILLS(memory)
+#endif
+
+#ifdef SA_STATS
+    #define SA_STATS_ALLOCATION(memory, size) sa__stats_allocation((memory), (size))
+    #define SA_STATS_FAILURE(memory) ((memory)->stats.failed_allocations++)
+    #define SA_STATS_ALIGNMENT(memory, padding) ((memory)->stats.alignment_waste += (padding))
+#else
+    #define SA_STATS_ALLOCATION(memory, size)
+    #define SA_STATS_FAILURE(memory)
+    #define SA_STATS_ALIGNMENT(memory, padding)
+#endif
+
+#ifdef SA_STATS
+static void sa__stats_allocation(sa_stack_allocator *memory, size_t size) {
+    size_t bucket = 0;
+    for(; size > 0; size >>= 1) bucket++;
+    memory->stats.allocations++;
+    memory->stats.size_histogram[bucket]++;
+    if(memory->marker > memory->stats.peak) {
+        memory->stats.peak = memory->marker;
+    }
+}
+#endif
+
+#ifdef SA_CLEANUP
+// Run cleanup entries that end past `marker`, most recent first.
+static void sa__run_cleanups(sa_stack_allocator *memory, size_t marker) {
+    uint8_t *limit = ((uint8_t *) memory->buffer) + marker;
+    while(memory->cleanup != NULL && (uint8_t *) (memory->cleanup + 1) > limit) {
+        sa_cleanup *entry = memory->cleanup;
+        memory->cleanup = entry->previous;
+        entry->fn(entry->ctx);
+    }
+}
+#endif
+
+#ifdef SA_MARKER_STACK
+// Saved marker entry, stored in the Stack Allocator buffer itself.
+typedef struct sa__saved_marker {
+    size_t marker;    // Marker before the entry was pushed.
+    size_t previous;  // Previous value of `marker_stack`.
+} sa__saved_marker;
+
+// Discard pushed markers whose entries end past `marker`, most recent first.
+static void sa__drop_markers(sa_stack_allocator *memory, size_t marker) {
+    while(memory->marker_stack != 0 && memory->marker_stack - 1 + sizeof(sa__saved_marker) > marker) {
+        sa__saved_marker *entry = (sa__saved_marker *) (((uint8_t *) memory->buffer) + memory->marker_stack - 1);
+        memory->marker_stack = entry->previous;
+    }
+}
+#endif
+
+// Failure path of allocations, kept out of line so the fast path stays small.
+static SA_COLD void *sa__alloc_failed(sa_stack_allocator *memory, size_t size) {
+    (void) memory;
+    (void) size;
+    SA_STATS_FAILURE(memory);
+    SA_TRACE(SA_ALLOC_FAILED, memory, size, memory->marker);
+    return NULL;
+}
+
+#ifdef SA_OVERFLOW
+// Spilled block headers keep blocks aligned like `malloc` would
+#define SA__SPILL_HEADER_SIZE ((sizeof(sa_spill) + 15) & ~(size_t) 15)
+
+// Allocation fallback to the overflow handler.
+static SA_COLD void *sa__spill(sa_stack_allocator *memory, size_t size, size_t alignment, size_t failed_size) {
+    size_t extra = SA__SPILL_HEADER_SIZE + (alignment > 16 ? alignment - 1 : 0);
+    uint8_t *block;
+    if(memory->overflow.alloc == NULL
+       || size > SIZE_MAX - extra
+       || (block = (uint8_t *) memory->overflow.alloc(memory->overflow.ctx, extra + size)) == NULL) {
+        return sa__alloc_failed(memory, failed_size);
+    }
+    sa_spill *spill = (sa_spill *) block;
+    spill->previous = memory->overflow.spills;
+    spill->marker = memory->marker + memory->overflow.live_spills;
+    memory->overflow.spills = spill;
+    memory->overflow.live_spills++;
+    memory->overflow.spill_count++;
+    memory->overflow.spilled_bytes += size;
+    uintptr_t address = (uintptr_t) (block + SA__SPILL_HEADER_SIZE);
+    return (void *) ((address + alignment - 1) & ~(uintptr_t) (alignment - 1));
+}
+
+// Free spilled blocks that were allocated at or past `marker`, most recent first.
+// Returns the buffer position `marker` refers to, SIZE_MAX if it is invalid.
+static size_t sa__free_spills(sa_stack_allocator *memory, size_t marker) {
+    while(memory->overflow.spills != NULL && memory->overflow.spills->marker >= marker) {
+        sa_spill *spill = memory->overflow.spills;
+        memory->overflow.spills = spill->previous;
+        memory->overflow.live_spills--;
+        memory->overflow.free(memory->overflow.ctx, spill);
+    }
+    return marker >= memory->overflow.live_spills ? marker - memory->overflow.live_spills : SIZE_MAX;
+}
+
+// Popping doesn't free spilled blocks, so lower their markers below the ones
+// got after the pop, which would otherwise free them.
+static void sa__lower_spills(sa_stack_allocator *memory) {
+    size_t older = memory->overflow.live_spills;
+    for(sa_spill *spill = memory->overflow.spills; spill != NULL; spill = spill->previous) {
+        older--;
+        if(spill->marker <= memory->marker + older) break;
+        spill->marker = memory->marker + older;
+    }
+}
+#endif
+
+// Marker for a buffer position, counting the blocks spilled before it.
+static size_t sa__position_marker(sa_stack_allocator *memory, size_t position) {
+#ifdef SA_OVERFLOW
+    return position + memory->overflow.live_spills;
+#else
+    (void) memory;
+    return position;
+#endif
+}
+
+// Allocation for memory that must live in the buffer, never spilled.
+static void *sa__alloc_in_buffer(sa_stack_allocator *memory, size_t size, size_t alignment) {
+#ifdef SA_OVERFLOW
+    sa_overflow_alloc_fn alloc = memory->overflow.alloc;
+    memory->overflow.alloc = NULL;
+    void *ptr = sa_alloc_aligned(memory, size, alignment);
+    memory->overflow.alloc = alloc;
+    return ptr;
+#else
+    return sa_alloc_aligned(memory, size, alignment);
+#endif
+}
+
 SA_DECL sa_stack_allocator sa_new(void *buffer, size_t capacity) {
     return SA_NEW(buffer, capacity);
 }
@@ -200,50 +674,112 @@ SA_DECL sa_stack_allocator sa_new_with_capacity(size_t capacity) {
 }
 
 SA_DECL int sa_init_with_capacity(sa_stack_allocator *memory, size_t capacity) {
-    memory->buffer = SA_MALLOC(capacity);
-    int malloc_success = memory->buffer != NULL;
-    memory->capacity = malloc_success * capacity;
-    memory->marker = 0;
+    void *buffer = SA_MALLOC(capacity);
+    int malloc_success = buffer != NULL;
+    *memory = SA_NEW(buffer, malloc_success * capacity);
     return malloc_success;
 }
 
 SA_DECL void sa_release(sa_stack_allocator *memory) {
+    SA_RUN_CLEANUPS(memory, 0);
+    SA_FREE_SPILLS(memory, 0);
+    SA_TRACE(SA_RELEASE, memory, memory->marker, 0);
     SA_FREE(memory->buffer);
     *memory = (sa_stack_allocator){};
 }
 
 SA_DECL void *sa_alloc(sa_stack_allocator *memory, size_t size) {
-    if(memory->marker + size > memory->capacity) return NULL;
+    // Marker is loaded once, so the overflow safe check costs a single subtraction
+    size_t marker = memory->marker;
+    if(SA_UNLIKELY(size > memory->capacity - marker)) {
+        return SA_ALLOC_FALLBACK(memory, size, 1, size);
+    }
+    memory->marker = marker + size;
+    SA_STATS_ALLOCATION(memory, size);
+    SA_TRACE(SA_ALLOC, memory, size, memory->marker);
+    return ((uint8_t *) memory->buffer) + marker;
+}
+
+SA_DECL void *sa_alloc_aligned(sa_stack_allocator *memory, size_t size, size_t alignment) {
+    uintptr_t address = ((uintptr_t) memory->buffer) + memory->marker;
+    size_t padding = (size_t) (-address & (alignment - 1));
+    size_t available = memory->capacity - memory->marker;
+    if(SA_UNLIKELY(size > available || padding > available - size)) {
+        return SA_ALLOC_FALLBACK(memory, size, alignment, padding + size);
+    }
+    memory->marker += padding;
+    SA_STATS_ALIGNMENT(memory, padding);
     void *ptr = ((uint8_t *) memory->buffer) + memory->marker;
     memory->marker += size;
+    SA_STATS_ALLOCATION(memory, size);
+    SA_TRACE(SA_ALLOC, memory, size, memory->marker);
     return ptr;
 }
 
 SA_DECL void sa_clear(sa_stack_allocator *memory) {
+    SA_RUN_CLEANUPS(memory, 0);
+    SA_FREE_SPILLS(memory, 0);
+    SA_RESET_MARKERS(memory);
+    SA_TRACE(SA_CLEAR_MARKER, memory, memory->marker, 0);
     memory->marker = 0;
 }
 
 SA_DECL size_t sa_get_marker(sa_stack_allocator *memory) {
-    return memory->marker;
+    return sa__position_marker(memory, memory->marker);
 }
 
 SA_DECL void sa_clear_marker(sa_stack_allocator *memory, size_t marker) {
+#ifdef SA_OVERFLOW
+    // Spilled blocks are freed even if no buffer memory is
+    marker = sa__free_spills(memory, marker);
+#endif
     if(marker < memory->marker) {
+        SA_RUN_CLEANUPS(memory, marker);
+        SA_DROP_MARKERS(memory, marker);
+        SA_TRACE(SA_CLEAR_MARKER, memory, memory->marker - marker, marker);
         memory->marker = marker;
     }
 }
 
+#ifdef SA_MARKER_STACK
+SA_DECL int sa_push_marker(sa_stack_allocator *memory) {
+    size_t marker = sa_get_marker(memory);
+    sa__saved_marker *entry = (sa__saved_marker *) sa__alloc_in_buffer(memory, sizeof(sa__saved_marker), SA_ALIGNOF(sa__saved_marker));
+    if(entry == NULL) return 0;
+    entry->marker = marker;
+    entry->previous = memory->marker_stack;
+    memory->marker_stack = (size_t) ((uint8_t *) entry - (uint8_t *) memory->buffer) + 1;
+    return 1;
+}
+
+SA_DECL int sa_pop_marker(sa_stack_allocator *memory) {
+    if(memory->marker_stack == 0) return 0;
+    sa__saved_marker *entry = (sa__saved_marker *) (((uint8_t *) memory->buffer) + memory->marker_stack - 1);
+    size_t marker = entry->marker;
+    memory->marker_stack = entry->previous;
+    sa_clear_marker(memory, marker);
+    return 1;
+}
+#endif
+
 SA_DECL void sa_pop(sa_stack_allocator *memory, size_t size) {
     if(size > memory->marker) {
+        SA_RUN_CLEANUPS(memory, 0);
+        SA_RESET_MARKERS(memory);
+        size = memory->marker;
         memory->marker = 0;
     }
     else {
+        SA_RUN_CLEANUPS(memory, memory->marker - size);
+        SA_DROP_MARKERS(memory, memory->marker - size);
         memory->marker -= size;
     }
+    SA_LOWER_SPILLS(memory);
+    SA_TRACE(SA_POP, memory, size, memory->marker);
 }
 
 SA_DECL void *sa_peek(sa_stack_allocator *memory, size_t size) {
-    if(memory->marker < size) return NULL;
+    if(SA_UNLIKELY(memory->marker < size)) return NULL;
     return ((uint8_t *) memory->buffer) + memory->marker - size;
 }
 
@@ -255,4 +791,112 @@ SA_DECL size_t sa_used_memory(sa_stack_allocator *memory) {
     return memory->marker;
 }
 
+SA_DECL sa_offset sa_ptr_to_offset(sa_stack_allocator *memory, const void *ptr) {
+    if(ptr == NULL) return SA_OFFSET_NULL;
+    size_t position = (size_t) ((const uint8_t *) ptr - (const uint8_t *) memory->buffer);
+    if(SA_UNLIKELY(position >= SA_OFFSET_RANGE)) return SA_OFFSET_NULL;
+    return (sa_offset) (position + 1);
+}
+
+SA_DECL void *sa_offset_to_ptr(sa_stack_allocator *memory, sa_offset offset) {
+    if(offset == SA_OFFSET_NULL) return NULL;
+    return ((uint8_t *) memory->buffer) + (offset - 1);
+}
+
+SA_DECL sa_offset sa_alloc_offset_aligned(sa_stack_allocator *memory, size_t size, size_t alignment) {
+    // Blocks past the offset range can't be referred to, so they fail before allocating
+    uintptr_t address = ((uintptr_t) memory->buffer) + memory->marker;
+    size_t position = memory->marker + (size_t) (-address & (alignment - 1));
+    if(SA_UNLIKELY(position >= SA_OFFSET_RANGE)) {
+        sa__alloc_failed(memory, size);
+        return SA_OFFSET_NULL;
+    }
+    return sa_ptr_to_offset(memory, sa__alloc_in_buffer(memory, size, alignment));
+}
+
+SA_DECL sa_offset sa_alloc_offset(sa_stack_allocator *memory, size_t size) {
+    return sa_alloc_offset_aligned(memory, size, 1);
+}
+
+SA_DECL int sa_child_begin(sa_stack_allocator *parent, sa_stack_allocator *child, size_t capacity) {
+    void *buffer = sa__alloc_in_buffer(parent, capacity, 1);
+    int alloc_success = buffer != NULL;
+    *child = SA_NEW(buffer, alloc_success * capacity);
+    return alloc_success;
+}
+
+SA_DECL void sa_child_end(sa_stack_allocator *parent, sa_stack_allocator *child) {
+    if(child->buffer == NULL) return;
+    sa_clear(child);
+    sa_clear_marker(parent, sa__position_marker(parent, (size_t) ((uint8_t *) child->buffer - (uint8_t *) parent->buffer)));
+    *child = (sa_stack_allocator){};
+}
+
+SA_DECL void sa_child_commit(sa_stack_allocator *parent, sa_stack_allocator *child) {
+    if(child->buffer == NULL) return;
+    size_t start = (size_t) ((uint8_t *) child->buffer - (uint8_t *) parent->buffer);
+    sa_clear_marker(parent, sa__position_marker(parent, start + child->marker));
+#ifdef SA_OVERFLOW
+    if(child->overflow.spills != NULL) {
+        if(child->overflow.free == parent->overflow.free && child->overflow.ctx == parent->overflow.ctx) {
+            // Child blocks are newer than the parent's, so rebase their markers past the child's start
+            size_t base = sa__position_marker(parent, start);
+            sa_spill *oldest = child->overflow.spills;
+            oldest->marker += base;
+            while(oldest->previous != NULL) {
+                oldest = oldest->previous;
+                oldest->marker += base;
+            }
+            oldest->previous = parent->overflow.spills;
+            parent->overflow.spills = child->overflow.spills;
+            parent->overflow.live_spills += child->overflow.live_spills;
+        }
+        else {
+            sa__free_spills(child, 0);
+        }
+    }
+#endif
+#ifdef SA_CLEANUP
+    // Child entries are newer than the parent's, so link the oldest one to the parent's chain
+    if(child->cleanup != NULL) {
+        sa_cleanup *oldest = child->cleanup;
+        while(oldest->previous != NULL) oldest = oldest->previous;
+        oldest->previous = parent->cleanup;
+        parent->cleanup = child->cleanup;
+    }
+#endif
+    *child = (sa_stack_allocator){};
+}
+
+#ifdef SA_CLEANUP
+SA_DECL int sa_push_cleanup(sa_stack_allocator *memory, sa_cleanup_fn fn, void *ctx) {
+    sa_cleanup *entry = (sa_cleanup *) sa__alloc_in_buffer(memory, sizeof(sa_cleanup), SA_ALIGNOF(sa_cleanup));
+    if(entry == NULL) return 0;
+    entry->fn = fn;
+    entry->ctx = ctx;
+    entry->previous = memory->cleanup;
+    memory->cleanup = entry;
+    return 1;
+}
+#endif
+
+#ifdef SA_OVERFLOW
+SA_DECL void sa_set_overflow_handler(sa_stack_allocator *memory, sa_overflow_alloc_fn alloc_fn, sa_overflow_free_fn free_fn, void *ctx) {
+    memory->overflow.alloc = alloc_fn;
+    memory->overflow.free = free_fn;
+    memory->overflow.ctx = ctx;
+}
+#endif
+
+#ifdef SA_STATS
+SA_DECL const sa_stats *sa_get_stats(sa_stack_allocator *memory) {
+    return &memory->stats;
+}
+
+SA_DECL void sa_reset_stats(sa_stack_allocator *memory) {
+    memory->stats = (sa_stats){};
+    memory->stats.peak = memory->marker;
+}
+#endif
+
 #endif  // STACK_ALLOCATOR_IMPLEMENTATION
@@ -0,0 +1,46 @@
+# Compile SOURCE to assembly and check that functions don't exceed a
+# maximum number of instructions.
+#
+# Usage: cmake -DCOMPILER=cc -DSOURCE=file.c -DINCLUDE_DIR=dir -DOUTPUT=file.s
+#              -DFUNCTIONS=name:max,name:max -P check_codegen.cmake
+#
+# Only the hot part of each function is counted, so code moved to cold
+# sections by the compiler is ignored.
+execute_process(
+	COMMAND ${COMPILER} -O2 -S -I${INCLUDE_DIR} -o ${OUTPUT} ${SOURCE}
+	RESULT_VARIABLE result
+)
+if(NOT result EQUAL 0)
+	message(FATAL_ERROR "Compiling ${SOURCE} failed")
+endif()
+
+file(STRINGS ${OUTPUT} lines)
+string(REPLACE "," ";" functions "${FUNCTIONS}")
+set(failed FALSE)
+foreach(entry ${functions})
+	string(REPLACE ":" ";" entry "${entry}")
+	list(GET entry 0 function)
+	list(GET entry 1 max_instructions)
+	set(inside FALSE)
+	set(count 0)
+	foreach(line IN LISTS lines)
+		if(line MATCHES "^_?${function}:")
+			set(inside TRUE)
+		elseif(inside)
+			if(line MATCHES "^[ \t]*\\.cfi_endproc" OR line MATCHES "^[ \t]*\\.size" OR line MATCHES "^[A-Za-z_]")
+				break()
+			elseif(line MATCHES "^[ \t]+[a-z]")
+				math(EXPR count "${count} + 1")
+			endif()
+		endif()
+	endforeach()
+	if(count EQUAL 0)
+		message(SEND_ERROR "${function}: not found in ${OUTPUT}")
+		set(failed TRUE)
+	elseif(count GREATER max_instructions)
+		message(SEND_ERROR "${function}: ${count} instructions, expected at most ${max_instructions}")
+		set(failed TRUE)
+	else()
+		message(STATUS "${function}: ${count} instructions")
+	endif()
+endforeach()
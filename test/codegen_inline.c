@@ -0,0 +1,52 @@
+// Compiled to assembly by check_codegen.cmake, which counts the
+// instructions of each `codegen_*` function.
+#define SA_INLINE
+#include "stack_allocator.h"
+#define DSA_INLINE
+#include "double_stack_allocator.h"
+#define BA_INLINE
+#include "bump_allocator.h"
+
+void *codegen_sa_alloc(sa_stack_allocator *memory, size_t size) {
+    return sa_alloc(memory, size);
+}
+
+void *codegen_sa_peek(sa_stack_allocator *memory, size_t size) {
+    return sa_peek(memory, size);
+}
+
+void *codegen_dsa_alloc_bottom(dsa_double_stack_allocator *memory, size_t size) {
+    return dsa_alloc_bottom(memory, size);
+}
+
+void *codegen_dsa_alloc_top(dsa_double_stack_allocator *memory, size_t size) {
+    return dsa_alloc_top(memory, size);
+}
+
+long codegen_sa_foreach(sa_stack_allocator *memory) {
+    long sum = 0;
+    SA_FOREACH(int, number, memory) {
+        sum += *number;
+    }
+    return sum;
+}
+
+void *codegen_ba_alloc(ba_bump_allocator *memory, size_t size) {
+    return ba_alloc(memory, size);
+}
+
+void *codegen_ba_down_alloc(ba_down_allocator *memory, size_t size) {
+    return ba_down_alloc(memory, size);
+}
+
+void *codegen_sa_alloc_aligned(sa_stack_allocator *memory, size_t size) {
+    return sa_alloc_aligned(memory, size, 16);
+}
+
+void *codegen_ba_alloc_aligned(ba_bump_allocator *memory, size_t size) {
+    return ba_alloc_aligned(memory, size, 16);
+}
+
+void *codegen_ba_down_alloc_aligned(ba_down_allocator *memory, size_t size) {
+    return ba_down_alloc_aligned(memory, size, 16);
+}
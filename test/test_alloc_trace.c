@@ -0,0 +1,129 @@
+#define ALLOC_TRACE_IMPLEMENTATION
+#include "alloc_trace.h"
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION
+#include "double_stack_allocator.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <criterion/criterion.h>
+
+static size_t read_trace(const char *path, at_file_header *header, at_record *records, size_t max_records) {
+	FILE *file = fopen(path, "rb");
+	cr_assert_not_null(file);
+	cr_assert_eq(fread(header, sizeof(*header), 1, file), 1);
+	size_t count = fread(records, sizeof(at_record), max_records, file);
+	fclose(file);
+	return count;
+}
+
+Test(alloc_trace, records) {
+	char path[] = "/tmp/alloc_trace_XXXXXX";
+	close(mkstemp(path));
+	cr_assert(at_open(path));
+
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 16));
+	cr_assert_not_null(sa_alloc(&allocator, 4));
+	size_t marker = sa_get_marker(&allocator);
+	cr_assert_not_null(sa_alloc(&allocator, 8));
+	cr_assert_null(sa_alloc(&allocator, 8));
+	sa_pop(&allocator, 2);
+	sa_clear_marker(&allocator, marker);
+	sa_release(&allocator);
+
+	dsa_double_stack_allocator double_allocator;
+	cr_assert(dsa_init_with_capacity(&double_allocator, 16));
+	cr_assert_not_null(dsa_alloc_top(&double_allocator, 4));
+	dsa_clear_top(&double_allocator);
+	dsa_release(&double_allocator);
+
+	at_close();
+	cr_assert_null(sa_alloc(&allocator, 1));
+
+	at_file_header header;
+	at_record records[16];
+	size_t count = read_trace(path, &header, records, 16);
+	unlink(path);
+
+	cr_assert_str_eq(header.magic, AT_MAGIC);
+	cr_assert_eq(header.version, AT_VERSION);
+	cr_assert_eq(header.record_size, sizeof(at_record));
+	cr_assert_eq(count, 9);
+
+	cr_assert_eq(records[0].op, AT_SA_ALLOC);
+	cr_assert_eq(records[0].allocator, (uintptr_t) &allocator);
+	cr_assert_eq(records[0].size, 4);
+	cr_assert_eq(records[0].marker, 4);
+	cr_assert_eq(records[1].op, AT_SA_ALLOC);
+	cr_assert_eq(records[1].marker, 12);
+	cr_assert_eq(records[2].op, AT_SA_ALLOC_FAILED);
+	cr_assert_eq(records[2].size, 8);
+	cr_assert_eq(records[3].op, AT_SA_POP);
+	cr_assert_eq(records[3].marker, 10);
+	cr_assert_eq(records[4].op, AT_SA_CLEAR_MARKER);
+	cr_assert_eq(records[4].size, 6);
+	cr_assert_eq(records[4].marker, 4);
+	cr_assert_eq(records[5].op, AT_SA_RELEASE);
+	cr_assert_eq(records[5].size, 4);
+	cr_assert_eq(records[5].marker, 0);
+	cr_assert_eq(records[6].op, AT_DSA_ALLOC_TOP);
+	cr_assert_eq(records[6].marker, 4);
+	cr_assert_eq(records[7].op, AT_DSA_CLEAR_TOP_MARKER);
+	cr_assert_eq(records[7].marker, 0);
+	cr_assert_eq(records[8].op, AT_DSA_RELEASE);
+	cr_assert_eq(records[8].size, 0);
+	cr_assert_geq(records[8].timestamp, records[0].timestamp);
+}
+
+static void *alloc_in_thread(void *allocator) {
+	sa_alloc((sa_stack_allocator *) allocator, 1);
+	return NULL;
+}
+
+Test(alloc_trace, flushes) {
+	char first[] = "/tmp/alloc_trace_XXXXXX", second[] = "/tmp/alloc_trace_XXXXXX";
+	close(mkstemp(first));
+	close(mkstemp(second));
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 16));
+
+	// Opening another file flushes and closes the previous one
+	cr_assert(at_open(first));
+	cr_assert_not_null(sa_alloc(&allocator, 1));
+	cr_assert(at_open(second));
+
+	// Threads flush their records when they exit
+	pthread_t thread;
+	cr_assert_eq(pthread_create(&thread, NULL, alloc_in_thread, &allocator), 0);
+	cr_assert_eq(pthread_join(thread, NULL), 0);
+	at_close();
+
+	at_file_header header;
+	at_record records[4];
+	cr_assert_eq(read_trace(first, &header, records, 4), 1);
+	cr_assert_eq(read_trace(second, &header, records, 4), 1);
+	cr_assert_eq(records[0].marker, 2);
+	cr_assert_neq(records[0].thread, 0);
+
+	// The process exiting flushes the thread that called exit
+	pid_t child = fork();
+	cr_assert_geq(child, 0);
+	if(child == 0) {
+		at_open(first);
+		sa_alloc(&allocator, 1);
+		exit(0);
+	}
+	int status;
+	cr_assert_eq(waitpid(child, &status, 0), child);
+	cr_assert_eq(read_trace(first, &header, records, 4), 1);
+	cr_assert_eq(records[0].marker, 3);
+
+	sa_release(&allocator);
+	unlink(first);
+	unlink(second);
+}
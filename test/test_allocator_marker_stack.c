@@ -0,0 +1,79 @@
+#define SA_MARKER_STACK
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define DSA_MARKER_STACK
+#define DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION
+#include "double_stack_allocator.h"
+
+#include <criterion/criterion.h>
+
+Test(sa_marker_stack, push_pop) {
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 256));
+	cr_assert_not(sa_pop_marker(&allocator));
+
+	cr_assert_not_null(sa_alloc(&allocator, 3));
+	size_t markers[3];
+	for(int i = 0; i < 3; i++) {
+		markers[i] = sa_get_marker(&allocator);
+		cr_assert(sa_push_marker(&allocator));
+		cr_assert_not_null(sa_alloc(&allocator, 5));
+	}
+
+	for(int i = 2; i >= 0; i--) {
+		cr_assert(sa_pop_marker(&allocator));
+		cr_assert_eq(sa_get_marker(&allocator), markers[i]);
+	}
+	cr_assert_eq(sa_used_memory(&allocator), 3);
+	cr_assert_not(sa_pop_marker(&allocator));
+
+	// Freeing memory past pushed markers discards them
+	cr_assert(sa_push_marker(&allocator));
+	cr_assert(sa_push_marker(&allocator));
+	sa_clear_marker(&allocator, 3);
+	cr_assert_not(sa_pop_marker(&allocator));
+	cr_assert(sa_push_marker(&allocator));
+	sa_pop(&allocator, 1);
+	cr_assert_not(sa_pop_marker(&allocator));
+	cr_assert(sa_push_marker(&allocator));
+	sa_clear(&allocator);
+	cr_assert_not(sa_pop_marker(&allocator));
+
+	sa_stack_allocator small;
+	cr_assert(sa_init_with_capacity(&small, 8));
+	cr_assert_not(sa_push_marker(&small));
+	sa_release(&small);
+
+	sa_release(&allocator);
+}
+
+Test(dsa_marker_stack, push_pop) {
+	dsa_double_stack_allocator allocator;
+	cr_assert(dsa_init_with_capacity(&allocator, 256));
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 3));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 5));
+
+	cr_assert_not(dsa_pop_marker(&allocator));
+	cr_assert(dsa_push_marker(&allocator));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 7));
+	cr_assert(dsa_push_marker(&allocator));
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 9));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 11));
+
+	cr_assert(dsa_pop_marker(&allocator));
+	cr_assert_eq(dsa_used_memory_top(&allocator), 12);
+	cr_assert(dsa_pop_marker(&allocator));
+	cr_assert_eq(dsa_used_memory_bottom(&allocator), 3);
+	cr_assert_eq(dsa_used_memory_top(&allocator), 5);
+	cr_assert_not(dsa_pop_marker(&allocator));
+
+	// Freeing bottom memory past pushed markers discards them
+	cr_assert(dsa_push_marker(&allocator));
+	dsa_clear_bottom_marker(&allocator, 3);
+	cr_assert_not(dsa_pop_marker(&allocator));
+	cr_assert(dsa_push_marker(&allocator));
+	dsa_clear_bottom(&allocator);
+	cr_assert_not(dsa_pop_marker(&allocator));
+
+	dsa_release(&allocator);
+}
@@ -0,0 +1,305 @@
+#define SA_OVERFLOW
+#define SA_MARKER_STACK
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define DSA_OVERFLOW
+#define DSA_MARKER_STACK
+#define DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION
+#include "double_stack_allocator.h"
+
+#include <criterion/criterion.h>
+#include <string.h>
+
+typedef struct upstream {
+	int allocations;
+	int frees;
+} upstream;
+
+static void *upstream_alloc(void *ctx, size_t size) {
+	((upstream *) ctx)->allocations++;
+	return malloc(size);
+}
+
+static void upstream_free(void *ctx, void *ptr) {
+	((upstream *) ctx)->frees++;
+	free(ptr);
+}
+
+static int in_buffer(void *buffer, size_t capacity, void *ptr) {
+	return (uint8_t *) ptr >= (uint8_t *) buffer && (uint8_t *) ptr < (uint8_t *) buffer + capacity;
+}
+
+Test(sa_overflow, disabled) {
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 16));
+	cr_assert_null(sa_alloc(&allocator, 17));
+	cr_assert_eq(allocator.overflow.spill_count, 0);
+	sa_release(&allocator);
+}
+
+Test(sa_overflow, spill_and_free) {
+	upstream up = {};
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 32));
+	sa_set_overflow_handler(&allocator, upstream_alloc, upstream_free, &up);
+
+	cr_assert_not_null(sa_alloc(&allocator, 24));
+	size_t marker = sa_get_marker(&allocator);
+	char *spilled = (char *) sa_alloc(&allocator, 100);
+	cr_assert_not_null(spilled);
+	cr_assert_not(in_buffer(allocator.buffer, allocator.capacity, spilled));
+	memset(spilled, 1, 100);
+	double *aligned = (double *) sa_alloc_aligned(&allocator, 64, 64);
+	cr_assert_not_null(aligned);
+	cr_assert_eq((uintptr_t) aligned % 64, 0);
+	cr_assert_eq(allocator.overflow.spill_count, 2);
+	cr_assert_eq(allocator.overflow.spilled_bytes, 164);
+	cr_assert_eq(sa_get_marker(&allocator), marker + 2);
+
+	// Spills happened after the marker, so clearing to it frees them
+	sa_clear_marker(&allocator, marker);
+	cr_assert_eq(up.frees, 2);
+	cr_assert_null(allocator.overflow.spills);
+	cr_assert_eq(sa_get_marker(&allocator), marker);
+
+	// Spills are freed with memory allocated before them
+	cr_assert_not_null(sa_alloc(&allocator, 200));
+	sa_clear_marker(&allocator, marker + 1);
+	cr_assert_eq(up.frees, 2);
+	sa_clear_marker(&allocator, 8);
+	cr_assert_eq(up.frees, 3);
+
+	cr_assert_not_null(sa_alloc(&allocator, 200));
+	sa_clear(&allocator);
+	cr_assert_eq(up.frees, 4);
+	cr_assert_not_null(sa_alloc(&allocator, 200));
+	sa_release(&allocator);
+	cr_assert_eq(up.frees, 5);
+	cr_assert_eq(up.allocations, 5);
+}
+
+Test(sa_overflow, marker_between_spills) {
+	upstream up = {};
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 16));
+	sa_set_overflow_handler(&allocator, upstream_alloc, upstream_free, &up);
+
+	cr_assert_not_null(sa_alloc(&allocator, 16));
+	char *outer = (char *) sa_alloc(&allocator, 32);
+	cr_assert_not_null(outer);
+	size_t marker = sa_get_marker(&allocator);
+	cr_assert_not_null(sa_alloc(&allocator, 32));
+
+	// Only the spill made after the marker is freed
+	sa_clear_marker(&allocator, marker);
+	cr_assert_eq(up.frees, 1);
+	cr_assert_eq(sa_get_marker(&allocator), marker);
+	memset(outer, 1, 32);
+
+	// Popping buffer memory doesn't make markers got later free older spills
+	sa_pop(&allocator, 16);
+	marker = sa_get_marker(&allocator);
+	cr_assert_not_null(sa_alloc(&allocator, 8));
+	sa_clear_marker(&allocator, marker);
+	cr_assert_eq(up.frees, 1);
+	cr_assert_eq(sa_used_memory(&allocator), 0);
+	memset(outer, 2, 32);
+
+	sa_release(&allocator);
+	cr_assert_eq(up.frees, 2);
+}
+
+Test(sa_overflow, child) {
+	upstream up = {}, child_up = {};
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 64));
+	sa_set_overflow_handler(&allocator, upstream_alloc, upstream_free, &up);
+	size_t marker = sa_get_marker(&allocator);
+
+	sa_stack_allocator child;
+	cr_assert(sa_child_begin(&allocator, &child, 16));
+	sa_set_overflow_handler(&child, upstream_alloc, upstream_free, &up);
+	cr_assert_not_null(sa_alloc(&child, 32));
+	sa_child_end(&allocator, &child);
+	cr_assert_eq(up.frees, 1);
+
+	// Spills move to the parent when the handlers match, after its own spills
+	cr_assert_not_null(sa_alloc(&allocator, 128));
+	size_t child_marker = sa_get_marker(&allocator);
+	cr_assert(sa_child_begin(&allocator, &child, 16));
+	sa_set_overflow_handler(&child, upstream_alloc, upstream_free, &up);
+	cr_assert_not_null(sa_alloc(&child, 8));
+	cr_assert_not_null(sa_alloc(&child, 32));
+	sa_child_commit(&allocator, &child);
+	cr_assert_eq(up.frees, 1);
+	cr_assert_eq(allocator.overflow.live_spills, 2);
+	cr_assert_eq(sa_get_marker(&allocator), child_marker + 9);
+	sa_clear_marker(&allocator, child_marker);
+	cr_assert_eq(up.frees, 2);
+	sa_clear_marker(&allocator, marker);
+	cr_assert_eq(up.frees, 3);
+
+	// Otherwise they are freed
+	cr_assert(sa_child_begin(&allocator, &child, 16));
+	sa_set_overflow_handler(&child, upstream_alloc, upstream_free, &child_up);
+	cr_assert_not_null(sa_alloc(&child, 32));
+	sa_child_commit(&allocator, &child);
+	cr_assert_eq(child_up.frees, 1);
+	cr_assert_null(allocator.overflow.spills);
+
+	sa_release(&allocator);
+	cr_assert_eq(up.frees, up.allocations);
+}
+
+Test(sa_overflow, buffer_only_memory) {
+	upstream up = {};
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 16));
+	sa_set_overflow_handler(&allocator, upstream_alloc, upstream_free, &up);
+
+	cr_assert_eq(sa_alloc_offset(&allocator, 17), SA_OFFSET_NULL);
+	cr_assert_eq(sa_alloc_offset_aligned(&allocator, 17, 8), SA_OFFSET_NULL);
+	sa_stack_allocator child;
+	cr_assert_not(sa_child_begin(&allocator, &child, 17));
+	cr_assert_not_null(sa_alloc(&allocator, 1));
+	cr_assert_not(sa_push_marker(&allocator));
+	cr_assert_eq(up.allocations, 0);
+
+	sa_release(&allocator);
+}
+
+Test(dsa_overflow, spill_and_free) {
+	upstream up = {};
+	dsa_double_stack_allocator allocator;
+	cr_assert(dsa_init_with_capacity(&allocator, 32));
+	dsa_set_overflow_handler(&allocator, upstream_alloc, upstream_free, &up);
+
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 8));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 8));
+	size_t bottom = dsa_get_bottom_marker(&allocator);
+	size_t top = dsa_get_top_marker(&allocator);
+
+	void *bottom_spill = dsa_alloc_bottom(&allocator, 64);
+	cr_assert_not_null(bottom_spill);
+	cr_assert_not(in_buffer(allocator.buffer, allocator.capacity, bottom_spill));
+	void *top_spill = dsa_alloc_top_aligned(&allocator, 64, 32);
+	cr_assert_not_null(top_spill);
+	cr_assert_eq((uintptr_t) top_spill % 32, 0);
+	cr_assert_not_null(dsa_alloc_bottom_aligned(&allocator, 64, 16));
+	cr_assert_eq(allocator.overflow.spill_count, 3);
+	cr_assert_eq(allocator.overflow.spilled_bytes, 192);
+
+	// Each end frees its own spills
+	dsa_clear_top_marker(&allocator, top);
+	cr_assert_eq(up.frees, 1);
+	dsa_clear_bottom_marker(&allocator, bottom);
+	cr_assert_eq(up.frees, 3);
+
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 64));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 64));
+	dsa_clear_top(&allocator);
+	cr_assert_eq(up.frees, 4);
+	dsa_clear_bottom(&allocator);
+	cr_assert_eq(up.frees, 5);
+
+	// Pushed markers and children are never spilled
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 30));
+	cr_assert_not(dsa_push_marker(&allocator));
+	cr_assert_eq(up.allocations, 5);
+
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 64));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 64));
+	dsa_release(&allocator);
+	cr_assert_eq(up.frees, 7);
+	cr_assert_eq(up.allocations, 7);
+}
+
+Test(dsa_overflow, marker_between_spills) {
+	upstream up = {};
+	dsa_double_stack_allocator allocator;
+	cr_assert(dsa_init_with_capacity(&allocator, 16));
+	dsa_set_overflow_handler(&allocator, upstream_alloc, upstream_free, &up);
+
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 8));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 8));
+	char *outer_bottom = (char *) dsa_alloc_bottom(&allocator, 32);
+	char *outer_top = (char *) dsa_alloc_top(&allocator, 32);
+	cr_assert_not_null(outer_bottom);
+	cr_assert_not_null(outer_top);
+	dsa_marker marker = dsa_get_marker(&allocator);
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 32));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 32));
+
+	// Only the spills made after the marker are freed
+	dsa_clear_to_marker(&allocator, marker);
+	cr_assert_eq(up.frees, 2);
+	cr_assert_eq(dsa_get_bottom_marker(&allocator), marker.bottom);
+	cr_assert_eq(dsa_get_top_marker(&allocator), marker.top);
+	memset(outer_bottom, 1, 32);
+	memset(outer_top, 1, 32);
+
+	// Popping buffer memory doesn't make markers got later free older spills
+	dsa_pop_bottom(&allocator, 8);
+	dsa_pop_top(&allocator, 8);
+	marker = dsa_get_marker(&allocator);
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 4));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 4));
+	dsa_clear_to_marker(&allocator, marker);
+	cr_assert_eq(up.frees, 2);
+	cr_assert_eq(dsa_used_memory(&allocator), 0);
+
+	dsa_release(&allocator);
+	cr_assert_eq(up.frees, 4);
+}
+
+Test(dsa_overflow, child) {
+	upstream up = {}, child_up = {};
+	dsa_double_stack_allocator allocator;
+	cr_assert(dsa_init_with_capacity(&allocator, 64));
+	dsa_set_overflow_handler(&allocator, upstream_alloc, upstream_free, &up);
+
+	sa_stack_allocator child;
+	cr_assert(dsa_child_begin_bottom(&allocator, &child, 16));
+	sa_set_overflow_handler(&child, upstream_alloc, upstream_free, &child_up);
+	cr_assert_not_null(sa_alloc(&child, 32));
+	dsa_child_end_bottom(&allocator, &child);
+	cr_assert_eq(child_up.frees, 1);
+
+	cr_assert(dsa_child_begin_top(&allocator, &child, 16));
+	sa_set_overflow_handler(&child, upstream_alloc, upstream_free, &child_up);
+	cr_assert_not_null(sa_alloc(&child, 32));
+	dsa_child_end_top(&allocator, &child);
+	cr_assert_eq(child_up.frees, 2);
+
+	// Children with spills can't be committed, and are left intact
+	cr_assert(dsa_child_begin_bottom(&allocator, &child, 16));
+	sa_set_overflow_handler(&child, upstream_alloc, upstream_free, &child_up);
+	cr_assert_not_null(sa_alloc(&child, 8));
+	cr_assert_not_null(sa_alloc(&child, 32));
+	cr_assert_null(dsa_child_commit_bottom(&allocator, &child));
+	cr_assert_not_null(child.buffer);
+	cr_assert_not_null(child.overflow.spills);
+	cr_assert_eq(child_up.frees, 2);
+	dsa_child_end_bottom(&allocator, &child);
+	cr_assert_eq(child_up.frees, 3);
+
+	cr_assert(dsa_child_begin_top(&allocator, &child, 16));
+	sa_set_overflow_handler(&child, upstream_alloc, upstream_free, &child_up);
+	cr_assert_not_null(sa_alloc(&child, 32));
+	cr_assert_null(dsa_child_commit_top(&allocator, &child));
+	cr_assert_not_null(child.overflow.spills);
+	dsa_child_end_top(&allocator, &child);
+	cr_assert_eq(child_up.frees, 4);
+	cr_assert_eq(dsa_used_memory(&allocator), 0);
+
+	// Without spills, committed children keep their buffer memory
+	cr_assert(dsa_child_begin_bottom(&allocator, &child, 16));
+	sa_set_overflow_handler(&child, upstream_alloc, upstream_free, &child_up);
+	cr_assert_not_null(sa_alloc(&child, 8));
+	cr_assert_not_null(dsa_child_commit_bottom(&allocator, &child));
+	cr_assert_eq(dsa_used_memory_bottom(&allocator), 8);
+
+	cr_assert_eq(child_up.frees, child_up.allocations);
+	dsa_release(&allocator);
+	cr_assert_eq(up.allocations, 0);
+}
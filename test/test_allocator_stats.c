@@ -0,0 +1,81 @@
+#define SA_STATS
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define DSA_STATS
+#define DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION
+#include "double_stack_allocator.h"
+
+#include <criterion/criterion.h>
+
+Test(sa_stats, counters) {
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 64));
+
+	cr_assert_not_null(sa_alloc(&allocator, 1));
+	size_t marker = sa_get_marker(&allocator);
+	cr_assert_not_null(sa_alloc_aligned(&allocator, 16, 16));
+	cr_assert_null(sa_alloc(&allocator, 64));
+	cr_assert_not_null(sa_alloc(&allocator, 0));
+
+	const sa_stats *stats = sa_get_stats(&allocator);
+	cr_assert_eq(stats->allocations, 3);
+	cr_assert_eq(stats->failed_allocations, 1);
+	cr_assert_eq(stats->alignment_waste, 15);
+	cr_assert_eq(stats->peak, 32);
+	cr_assert_eq(stats->size_histogram[0], 1);
+	cr_assert_eq(stats->size_histogram[1], 1);
+	cr_assert_eq(stats->size_histogram[5], 1);
+
+	sa_clear_marker(&allocator, marker);
+	cr_assert_not_null(sa_alloc(&allocator, 3));
+	cr_assert_eq(stats->peak, 32);
+	cr_assert_eq(stats->size_histogram[2], 1);
+
+	sa_reset_stats(&allocator);
+	cr_assert_eq(stats->allocations, 0);
+	cr_assert_eq(stats->peak, 4);
+
+	sa_release(&allocator);
+}
+
+Test(sa_stats, offset_range) {
+	if(SIZE_MAX <= UINT32_MAX) return;
+	// Only addresses are computed, so a small buffer can pose as a huge one
+	static uint8_t buffer[16];
+	sa_stack_allocator allocator = sa_new(buffer, SA_OFFSET_RANGE + 16);
+	allocator.marker = SA_OFFSET_RANGE;
+
+	// Offsets past the range fail once, without counting an allocation
+	cr_assert_eq(sa_alloc_offset(&allocator, 1), SA_OFFSET_NULL);
+	const sa_stats *stats = sa_get_stats(&allocator);
+	cr_assert_eq(stats->allocations, 0);
+	cr_assert_eq(stats->failed_allocations, 1);
+	cr_assert_eq(sa_used_memory(&allocator), SA_OFFSET_RANGE);
+}
+
+Test(dsa_stats, counters) {
+	dsa_double_stack_allocator allocator;
+	cr_assert(dsa_init_with_capacity(&allocator, 64));
+
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 8));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 24));
+	cr_assert_null(dsa_alloc_bottom(&allocator, 64));
+	dsa_clear_top(&allocator);
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 16));
+
+	const dsa_stats *stats = dsa_get_stats(&allocator);
+	cr_assert_eq(stats->allocations, 3);
+	cr_assert_eq(stats->failed_allocations, 1);
+	cr_assert_eq(stats->peak_bottom, 24);
+	cr_assert_eq(stats->peak_top, 24);
+	cr_assert_eq(stats->peak, 32);
+	cr_assert_eq(stats->size_histogram[4], 1);
+	cr_assert_eq(stats->size_histogram[5], 2);
+
+	dsa_reset_stats(&allocator);
+	cr_assert_eq(stats->allocations, 0);
+	cr_assert_eq(stats->peak_bottom, 24);
+	cr_assert_eq(stats->peak_top, 0);
+
+	dsa_release(&allocator);
+}
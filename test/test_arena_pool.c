@@ -0,0 +1,110 @@
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define SA_POOL_SHRINK_INTERVAL 4
+#define ARENA_POOL_IMPLEMENTATION
+#include "arena_pool.h"
+
+#include <pthread.h>
+
+#include <criterion/criterion.h>
+
+Test(sa_arena_pool, checkout_return) {
+	size_t capacity = 64;
+
+	sa_arena_pool pool;
+	cr_assert(sa_pool_init(&pool, 2, capacity));
+
+	sa_stack_allocator *first = sa_pool_checkout(&pool);
+	sa_stack_allocator *second = sa_pool_checkout(&pool);
+	cr_assert_not_null(first);
+	cr_assert_not_null(second);
+	cr_assert_neq(first, second);
+	cr_assert_eq(sa_available_memory(first), capacity);
+
+	cr_assert_not_null(sa_alloc(first, 16));
+	sa_pool_return(&pool, first);
+	cr_assert_eq(sa_used_memory(first), 0);
+	cr_assert_eq(sa_pool_slot(&pool, 0)->peak + sa_pool_slot(&pool, 1)->peak, 16);
+
+	cr_assert_eq(sa_pool_checkout(&pool), first);
+
+	sa_pool_return(&pool, first);
+	sa_pool_return(&pool, second);
+	sa_pool_release(&pool);
+}
+
+Test(sa_arena_pool, exhausted) {
+	sa_arena_pool pool;
+	cr_assert(sa_pool_init(&pool, 1, 64));
+
+	sa_stack_allocator *pooled = sa_pool_checkout(&pool);
+	sa_stack_allocator *extra = sa_pool_checkout(&pool);
+	cr_assert_eq(pooled, &sa_pool_slot(&pool, 0)->arena);
+	cr_assert_not_null(extra);
+	cr_assert_neq(extra, pooled);
+	cr_assert_eq(sa_available_memory(extra), 64);
+
+	sa_pool_return(&pool, extra);
+	sa_pool_return(&pool, pooled);
+	sa_pool_release(&pool);
+}
+
+Test(sa_arena_pool, grow_and_shrink) {
+	size_t capacity = 64;
+
+	sa_arena_pool pool;
+	cr_assert(sa_pool_init(&pool, 1, capacity));
+
+	sa_stack_allocator *arena = sa_pool_checkout_with_capacity(&pool, 16 * capacity);
+	cr_assert_geq(arena->capacity, 16 * capacity);
+	cr_assert_not_null(sa_alloc(arena, 2 * capacity));
+	sa_pool_return(&pool, arena);
+
+	for(int i = 1; i < SA_POOL_SHRINK_INTERVAL; i++) {
+		arena = sa_pool_checkout(&pool);
+		cr_assert_eq(arena->capacity, 16 * capacity);
+		sa_pool_return(&pool, arena);
+	}
+
+	arena = sa_pool_checkout(&pool);
+	cr_assert_eq(arena->capacity, 2 * capacity);
+	cr_assert_eq(sa_pool_slot(&pool, 0)->peak, 2 * capacity);
+	sa_pool_return(&pool, arena);
+
+	sa_pool_release(&pool);
+}
+
+#define THREADS 4
+#define ITERATIONS 10000
+
+static sa_arena_pool shared_pool;
+
+static void *checkout_loop(void *arg) {
+	uintptr_t id = (uintptr_t) arg;
+	for(int i = 0; i < ITERATIONS; i++) {
+		sa_stack_allocator *arena = sa_pool_checkout(&shared_pool);
+		uintptr_t *value = sa_alloc_(arena, uintptr_t);
+		*value = id;
+		for(int j = 0; j < 10; j++) {
+			if(*(volatile uintptr_t *) value != id) return (void *) 1;
+		}
+		sa_pool_return(&shared_pool, arena);
+	}
+	return NULL;
+}
+
+Test(sa_arena_pool, threads) {
+	cr_assert(sa_pool_init(&shared_pool, THREADS / 2, 64));
+
+	pthread_t threads[THREADS];
+	for(uintptr_t i = 0; i < THREADS; i++) {
+		pthread_create(&threads[i], NULL, checkout_loop, (void *) i);
+	}
+	for(int i = 0; i < THREADS; i++) {
+		void *result;
+		pthread_join(threads[i], &result);
+		cr_assert_null(result);
+	}
+
+	sa_pool_release(&shared_pool);
+}
@@ -0,0 +1,113 @@
+#define BUMP_ALLOCATOR_IMPLEMENTATION
+#include "bump_allocator.h"
+
+#include <criterion/criterion.h>
+
+Test(ba_bump_allocator, alloc_marker_pop) {
+	ba_bump_allocator allocator;
+	cr_assert(ba_init_with_capacity(&allocator, 16));
+	cr_assert_eq(ba_available_memory(&allocator), 16);
+
+	uint8_t *first = ba_alloc(&allocator, 4);
+	cr_assert_eq(first, allocator.buffer);
+	size_t marker = ba_get_marker(&allocator);
+	cr_assert_eq(marker, 4);
+	uint8_t *second = ba_alloc(&allocator, 8);
+	cr_assert_eq(second, first + 4);
+	cr_assert_eq(ba_peek(&allocator, 8), second);
+	cr_assert_null(ba_alloc(&allocator, 5));
+	cr_assert_null(ba_alloc(&allocator, SIZE_MAX));
+
+	ba_clear_marker(&allocator, marker);
+	cr_assert_eq(ba_used_memory(&allocator), 4);
+	ba_clear_marker(&allocator, 10);
+	cr_assert_eq(ba_used_memory(&allocator), 4);
+
+	ba_pop(&allocator, 100);
+	cr_assert_eq(ba_used_memory(&allocator), 0);
+	cr_assert_null(ba_peek(&allocator, 1));
+
+	ba_release(&allocator);
+	cr_assert_eq(ba_available_memory(&allocator), 0);
+}
+
+Test(ba_bump_allocator, alloc_aligned) {
+	ba_bump_allocator allocator;
+	cr_assert(ba_init_with_capacity(&allocator, 64));
+
+	cr_assert_not_null(ba_alloc(&allocator, 1));
+	void *ptr = ba_alloc_aligned(&allocator, 8, 16);
+	cr_assert_not_null(ptr);
+	cr_assert_eq((uintptr_t) ptr % 16, 0);
+	cr_assert_eq(ba_peek(&allocator, 8), ptr);
+	cr_assert_null(ba_alloc_aligned(&allocator, 64, 1));
+	cr_assert_null(ba_alloc_aligned(&allocator, SIZE_MAX - 1, 2));
+
+	ba_release(&allocator);
+}
+
+Test(ba_bump_allocator, foreach) {
+	ba_bump_allocator allocator;
+	cr_assert(ba_init_with_capacity_(&allocator, int, 4));
+	for(int i = 0; i < 4; i++) {
+		*ba_alloc_(&allocator, int) = i;
+	}
+	int expected = 0;
+	BA_FOREACH(int, number, &allocator) {
+		cr_assert_eq(*number, expected++);
+	}
+	cr_assert_eq(expected, 4);
+	ba_release(&allocator);
+}
+
+Test(ba_down_allocator, alloc_marker_pop) {
+	ba_down_allocator allocator;
+	cr_assert(ba_down_init_with_capacity(&allocator, 16));
+
+	uint8_t *first = ba_down_alloc(&allocator, 4);
+	cr_assert_eq(first, allocator.buffer + 12);
+	size_t marker = ba_down_get_marker(&allocator);
+	cr_assert_eq(marker, 4);
+	uint8_t *second = ba_down_alloc(&allocator, 8);
+	cr_assert_eq(second, first - 8);
+	cr_assert_eq(ba_down_peek(&allocator, 8), second);
+	cr_assert_null(ba_down_alloc(&allocator, 5));
+	cr_assert_null(ba_down_alloc(&allocator, SIZE_MAX));
+	cr_assert_eq(ba_down_available_memory(&allocator), 4);
+
+	ba_down_clear_marker(&allocator, marker);
+	cr_assert_eq(ba_down_used_memory(&allocator), 4);
+	ba_down_pop(&allocator, 100);
+	cr_assert_eq(ba_down_used_memory(&allocator), 0);
+
+	ba_down_release(&allocator);
+}
+
+Test(ba_down_allocator, alloc_aligned) {
+	ba_down_allocator allocator;
+	cr_assert(ba_down_init_with_capacity(&allocator, 64));
+
+	cr_assert_not_null(ba_down_alloc(&allocator, 1));
+	void *ptr = ba_down_alloc_aligned(&allocator, 8, 16);
+	cr_assert_not_null(ptr);
+	cr_assert_eq((uintptr_t) ptr % 16, 0);
+	cr_assert_eq(ba_down_peek(&allocator, 8), ptr);
+	cr_assert_null(ba_down_alloc_aligned(&allocator, 64, 1));
+	cr_assert_null(ba_down_alloc_aligned(&allocator, SIZE_MAX, 16));
+
+	ba_down_release(&allocator);
+}
+
+Test(ba_down_allocator, foreach) {
+	ba_down_allocator allocator;
+	cr_assert(ba_down_init_with_capacity_(&allocator, int, 4));
+	for(int i = 0; i < 4; i++) {
+		*ba_down_alloc_(&allocator, int) = i;
+	}
+	int expected = 0;
+	BA_DOWN_FOREACH(int, number, &allocator) {
+		cr_assert_eq(*number, expected++);
+	}
+	cr_assert_eq(expected, 4);
+	ba_down_release(&allocator);
+}
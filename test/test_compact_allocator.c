@@ -0,0 +1,115 @@
+#define COMPACT_ALLOCATOR_IMPLEMENTATION
+#include "compact_allocator.h"
+
+#include <criterion/criterion.h>
+
+Test(compact_allocator, struct_sizes) {
+	if(sizeof(void *) == 8) {
+		cr_assert_eq(sizeof(sa_stack_allocator32), 16);
+		cr_assert_eq(sizeof(dsa_double_stack_allocator32), 24);
+	}
+	cr_assert_eq(sizeof(sa_stack_allocator32_inline), 8);
+}
+
+Test(sa_stack_allocator32, alloc_marker_pop) {
+	sa_stack_allocator32 allocator;
+	cr_assert(sa32_init_with_capacity(&allocator, 16));
+	cr_assert_eq(sa32_available_memory(&allocator), 16);
+
+	uint8_t *first = sa32_alloc(&allocator, 4);
+	cr_assert_eq(first, allocator.buffer);
+	size_t marker = sa32_get_marker(&allocator);
+	double *number = sa32_alloc_aligned_(&allocator, double);
+	cr_assert_not_null(number);
+	cr_assert_eq((uintptr_t) number % _Alignof(double), 0);
+	cr_assert_eq(sa32_peek_(&allocator, double), number);
+	cr_assert_null(sa32_alloc(&allocator, 1));
+	cr_assert_null(sa32_alloc(&allocator, SIZE_MAX));
+
+	sa32_clear_marker(&allocator, marker);
+	cr_assert_eq(sa32_used_memory(&allocator), 4);
+	sa32_pop(&allocator, 100);
+	cr_assert_eq(sa32_used_memory(&allocator), 0);
+
+	sa32_release(&allocator);
+	cr_assert_eq(sa32_available_memory(&allocator), 0);
+	cr_assert_not(sa32_init_with_capacity(&allocator, (size_t) UINT32_MAX + 1));
+}
+
+Test(sa_stack_allocator32, foreach) {
+	sa_stack_allocator32 allocator;
+	cr_assert(sa32_init_with_capacity_(&allocator, int, 4));
+	for(int i = 0; i < 4; i++) {
+		*sa32_alloc_(&allocator, int) = i;
+	}
+	int expected = 0;
+	SA32_FOREACH(int, number, &allocator) {
+		cr_assert_eq(*number, expected++);
+	}
+	cr_assert_eq(expected, 4);
+	SA32_FOREACH_REVERSE(int, number, &allocator) {
+		cr_assert_eq(*number, --expected);
+	}
+	sa32_release(&allocator);
+}
+
+Test(sa_stack_allocator32_inline, create_and_alloc) {
+	sa_stack_allocator32_inline *allocator = sa32_inline_create_(int, 4);
+	cr_assert_not_null(allocator);
+	cr_assert_eq(sa32_inline_available_memory(allocator), 4 * sizeof(int));
+
+	int *first = sa32_inline_alloc_(allocator, int);
+	cr_assert_eq((void *) first, (void *) allocator->buffer);
+	for(int i = 1; i < 4; i++) {
+		*sa32_inline_alloc_(allocator, int) = i;
+	}
+	*first = 0;
+	cr_assert_null(sa32_inline_alloc(allocator, 1));
+
+	int expected = 0;
+	SA32_INLINE_FOREACH(int, number, allocator) {
+		cr_assert_eq(*number, expected++);
+	}
+	cr_assert_eq(expected, 4);
+
+	sa32_inline_pop_(allocator, int);
+	cr_assert_eq(sa32_inline_used_memory(allocator), 3 * sizeof(int));
+	sa32_inline_clear(allocator);
+	cr_assert_eq(sa32_inline_used_memory(allocator), 0);
+
+	sa32_inline_destroy(allocator);
+}
+
+Test(sa_stack_allocator32_inline, init_in_place) {
+	uint64_t block[4];
+	cr_assert_null(sa32_inline_init(block, 4));
+	sa_stack_allocator32_inline *allocator = sa32_inline_init(block, sizeof(block));
+	cr_assert_eq((void *) allocator, (void *) block);
+	cr_assert_eq(sa32_inline_available_memory(allocator), sizeof(block) - sizeof(sa_stack_allocator32_inline));
+	cr_assert_not_null(sa32_inline_alloc_aligned(allocator, 8, 8));
+	cr_assert_null(sa32_inline_alloc_aligned(allocator, 24, 8));
+}
+
+Test(dsa_double_stack_allocator32, alloc_both_ends) {
+	dsa_double_stack_allocator32 allocator;
+	cr_assert(dsa32_init_with_capacity(&allocator, 16));
+
+	uint8_t *bottom = dsa32_alloc_bottom(&allocator, 4);
+	uint8_t *top = dsa32_alloc_top(&allocator, 8);
+	cr_assert_eq(bottom, allocator.buffer);
+	cr_assert_eq(top, (uint8_t *) allocator.buffer + 8);
+	cr_assert_eq(dsa32_peek_bottom(&allocator, 4), bottom);
+	cr_assert_eq(dsa32_peek_top(&allocator, 8), top);
+	cr_assert_null(dsa32_alloc_bottom(&allocator, 5));
+	cr_assert_null(dsa32_alloc_top(&allocator, SIZE_MAX));
+	cr_assert_eq(dsa32_used_memory(&allocator), 12);
+
+	dsa32_pop_top(&allocator, 100);
+	cr_assert_eq(dsa32_used_memory_top(&allocator), 0);
+	dsa32_clear_bottom_marker(&allocator, 2);
+	cr_assert_eq(dsa32_used_memory_bottom(&allocator), 2);
+	dsa32_clear_bottom(&allocator);
+	cr_assert_eq(dsa32_available_memory(&allocator), 16);
+
+	dsa32_release(&allocator);
+}
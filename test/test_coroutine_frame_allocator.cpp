@@ -0,0 +1,114 @@
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define COROUTINE_FRAME_ALLOCATOR_IMPLEMENTATION
+#include "coroutine_frame_allocator.hpp"
+
+#include <coroutine>
+#include <cstdint>
+#include <thread>
+
+#include <criterion/criterion.h>
+
+struct task {
+	struct promise_type : sa::coroutine_frame_promise {
+		int value = 0;
+		task get_return_object() { return task{ std::coroutine_handle<promise_type>::from_promise(*this) }; }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_value(int v) { value = v; }
+		void unhandled_exception() {}
+	};
+
+	std::coroutine_handle<promise_type> handle;
+
+	int run() {
+		handle.resume();
+		return handle.promise().value;
+	}
+	void destroy() { handle.destroy(); }
+};
+
+static task answer(int x) {
+	co_return x + 1;
+}
+
+static bool in_stack(const sa_stack_allocator *stack, void *ptr) {
+	uint8_t *begin = (uint8_t *) stack->buffer;
+	return (uint8_t *) ptr >= begin && (uint8_t *) ptr < begin + stack->capacity;
+}
+
+Test(coroutine_frame_allocator, coroutine_frames) {
+	const sa_stack_allocator *stack = sa::coroutine_frame_stack();
+	cr_assert_eq(sa_used_memory((sa_stack_allocator *) stack), 0);
+
+	task t = answer(41);
+	cr_assert(in_stack(stack, t.handle.address()));
+	cr_assert_gt(sa_used_memory((sa_stack_allocator *) stack), 0);
+	cr_assert_eq(t.run(), 42);
+
+	t.destroy();
+	cr_assert_eq(sa_used_memory((sa_stack_allocator *) stack), 0);
+}
+
+Test(coroutine_frame_allocator, lifo) {
+	const sa_stack_allocator *stack = sa::coroutine_frame_stack();
+
+	void *first = sa::coroutine_frame_allocate(100);
+	size_t marker = stack->marker;
+	void *second = sa::coroutine_frame_allocate(100);
+	cr_assert(in_stack(stack, first));
+	cr_assert(in_stack(stack, second));
+	cr_assert_gt(stack->marker, marker);
+
+	sa::coroutine_frame_deallocate(second);
+	cr_assert_eq(stack->marker, marker);
+
+	sa::coroutine_frame_deallocate(first);
+	cr_assert_eq(stack->marker, 0);
+}
+
+Test(coroutine_frame_allocator, out_of_order) {
+	const sa_stack_allocator *stack = sa::coroutine_frame_stack();
+
+	void *first = sa::coroutine_frame_allocate(100);
+	void *second = sa::coroutine_frame_allocate(100);
+	size_t marker = stack->marker;
+
+	sa::coroutine_frame_deallocate(first);
+	cr_assert_eq(stack->marker, marker);
+
+	void *reused = sa::coroutine_frame_allocate(90);
+	cr_assert_eq(reused, first);
+	cr_assert_eq(stack->marker, marker);
+
+	sa::coroutine_frame_deallocate(second);
+	sa::coroutine_frame_deallocate(reused);
+	cr_assert_eq(stack->marker, 0);
+}
+
+Test(coroutine_frame_allocator, big_frames) {
+	const sa_stack_allocator *stack = sa::coroutine_frame_stack();
+
+	void *frame = sa::coroutine_frame_allocate(1 << 16);
+	cr_assert_not_null(frame);
+	cr_assert_not(in_stack(stack, frame));
+	cr_assert_eq(stack->marker, 0);
+
+	sa::coroutine_frame_deallocate(frame);
+}
+
+Test(coroutine_frame_allocator, remote_free) {
+	const sa_stack_allocator *stack = sa::coroutine_frame_stack();
+
+	void *first = sa::coroutine_frame_allocate(100);
+	void *second = sa::coroutine_frame_allocate(100);
+
+	std::thread([first] { sa::coroutine_frame_deallocate(first); }).join();
+
+	void *reused = sa::coroutine_frame_allocate(100);
+	cr_assert_eq(reused, first);
+
+	sa::coroutine_frame_deallocate(reused);
+	sa::coroutine_frame_deallocate(second);
+	cr_assert_eq(stack->marker, 0);
+}
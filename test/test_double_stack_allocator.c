@@ -1,7 +1,10 @@
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
 #define DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION
 #include "double_stack_allocator.h"
 
 #include <criterion/criterion.h>
+#include <string.h>
 
 #define LOG_ALLOCATOR(a) \
 	cr_log_info("{capacity = %d, bottom = %d, top = %d}", a.capacity, a.bottom, a.top)
@@ -213,3 +216,146 @@ Test(dsa_double_stack_allocator, foreach) {
     }
     cr_assert_eq(i, 0);
 }
+
+Test(dsa_double_stack_allocator, alloc_aligned) {
+	size_t size = 64;
+
+	dsa_double_stack_allocator allocator;
+	cr_assert(dsa_init_with_capacity(&allocator, size));
+
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 1));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 1));
+
+	void *ptr = dsa_alloc_bottom_aligned(&allocator, 8, 16);
+	cr_assert_not_null(ptr);
+	cr_assert_eq((uintptr_t) ptr % 16, 0);
+	cr_assert_eq(dsa_peek_bottom(&allocator, 8), ptr);
+
+	ptr = dsa_alloc_top_aligned(&allocator, 8, 16);
+	cr_assert_not_null(ptr);
+	cr_assert_eq((uintptr_t) ptr % 16, 0);
+	cr_assert_eq(dsa_peek_top(&allocator, 8), ptr);
+
+	double *number = dsa_alloc_top_aligned_(&allocator, double);
+	cr_assert_not_null(number);
+	cr_assert_eq((uintptr_t) number % _Alignof(double), 0);
+
+	cr_assert_null(dsa_alloc_bottom_aligned(&allocator, size, 1));
+	cr_assert_null(dsa_alloc_top_aligned(&allocator, size, 1));
+
+	dsa_release(&allocator);
+}
+
+Test(dsa_double_stack_allocator, huge_sizes) {
+	dsa_double_stack_allocator allocator;
+	cr_assert(dsa_init_with_capacity(&allocator, 16));
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 1));
+
+	cr_assert_null(dsa_alloc_bottom(&allocator, SIZE_MAX));
+	cr_assert_null(dsa_alloc_top(&allocator, SIZE_MAX));
+	cr_assert_null(dsa_alloc_bottom_aligned(&allocator, SIZE_MAX - 1, 2));
+	cr_assert_null(dsa_alloc_top_aligned(&allocator, SIZE_MAX, 16));
+	cr_assert_eq(dsa_used_memory(&allocator), 1);
+
+	dsa_release(&allocator);
+}
+
+Test(dsa_double_stack_allocator, child_bottom) {
+	dsa_double_stack_allocator allocator;
+	cr_assert(dsa_init_with_capacity(&allocator, 64));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 16));
+
+	sa_stack_allocator child;
+	cr_assert_not(dsa_child_begin_bottom(&allocator, &child, 49));
+	cr_assert_eq(child.capacity, 0);
+	cr_assert(dsa_child_begin_bottom(&allocator, &child, 32));
+	cr_assert_eq(child.buffer, allocator.buffer);
+	cr_assert_not_null(sa_alloc(&child, 32));
+	cr_assert_null(sa_alloc(&child, 1));
+	dsa_child_end_bottom(&allocator, &child);
+	cr_assert_eq(dsa_used_memory_bottom(&allocator), 0);
+
+	cr_assert(dsa_child_begin_bottom(&allocator, &child, 32));
+	void *ptr = sa_alloc(&child, 5);
+	cr_assert_eq(dsa_child_commit_bottom(&allocator, &child), ptr);
+	cr_assert_eq(dsa_used_memory_bottom(&allocator), 5);
+	cr_assert_eq(child.capacity, 0);
+
+	dsa_release(&allocator);
+}
+
+Test(dsa_double_stack_allocator, child_top) {
+	dsa_double_stack_allocator allocator;
+	cr_assert(dsa_init_with_capacity(&allocator, 64));
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 16));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 8));
+
+	sa_stack_allocator child;
+	cr_assert_not(dsa_child_begin_top(&allocator, &child, 41));
+	cr_assert(dsa_child_begin_top(&allocator, &child, 32));
+	cr_assert_eq(dsa_available_memory(&allocator), 8);
+	dsa_child_end_top(&allocator, &child);
+	cr_assert_eq(dsa_used_memory_top(&allocator), 8);
+
+	cr_assert(dsa_child_begin_top(&allocator, &child, 32));
+	char *text = (char *) sa_alloc(&child, 6);
+	memcpy(text, "child", 6);
+	char *committed = (char *) dsa_child_commit_top(&allocator, &child);
+	cr_assert_eq(dsa_used_memory_top(&allocator), 8 + 6);
+	cr_assert_eq(dsa_peek_top(&allocator, 6), committed);
+	cr_assert_str_eq(committed, "child");
+	cr_assert_eq(child.capacity, 0);
+
+	dsa_release(&allocator);
+}
+
+Test(dsa_double_stack_allocator, promote_demote) {
+	dsa_double_stack_allocator allocator;
+	cr_assert(dsa_init_with_capacity(&allocator, 32));
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 4));
+
+	char *scratch = (char *) dsa_alloc_top(&allocator, 6);
+	memcpy(scratch, "hello", 6);
+	cr_assert_null(dsa_promote_top_to_bottom(&allocator, 7));
+	char *result = (char *) dsa_promote_top_to_bottom(&allocator, 6);
+	cr_assert_eq(result, (char *) allocator.buffer + 4);
+	cr_assert_str_eq(result, "hello");
+	cr_assert_eq(dsa_used_memory_bottom(&allocator), 10);
+	cr_assert_eq(dsa_used_memory_top(&allocator), 0);
+
+	cr_assert_null(dsa_demote_bottom_to_top(&allocator, 11));
+	char *back = (char *) dsa_demote_bottom_to_top(&allocator, 6);
+	cr_assert_eq(back, (char *) allocator.buffer + 26);
+	cr_assert_str_eq(back, "hello");
+	cr_assert_eq(dsa_used_memory_bottom(&allocator), 4);
+	cr_assert_eq(dsa_used_memory_top(&allocator), 6);
+
+	// Without free memory between both ends, only the boundary moves
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 22));
+	cr_assert_eq(dsa_available_memory(&allocator), 0);
+	cr_assert_eq(dsa_promote_top_to_bottom(&allocator, 6), back);
+	cr_assert_eq(dsa_used_memory_bottom(&allocator), 32);
+	cr_assert_eq(dsa_demote_bottom_to_top(&allocator, 6), back);
+	cr_assert_eq(dsa_used_memory_top(&allocator), 6);
+	cr_assert_str_eq(back, "hello");
+
+	dsa_release(&allocator);
+}
+
+Test(dsa_double_stack_allocator, markers) {
+	dsa_double_stack_allocator allocator;
+	cr_assert(dsa_init_with_capacity(&allocator, 256));
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 3));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 5));
+
+	dsa_marker marker = dsa_get_marker(&allocator);
+	cr_assert_eq(marker.bottom, 3);
+	cr_assert_eq(marker.top, 251);
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 10));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 20));
+	dsa_clear_to_marker(&allocator, marker);
+	cr_assert_eq(dsa_used_memory_bottom(&allocator), 3);
+	cr_assert_eq(dsa_used_memory_top(&allocator), 5);
+
+	dsa_release(&allocator);
+}
@@ -0,0 +1,124 @@
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define FRAME_ALLOCATOR_IMPLEMENTATION
+#include "frame_allocator.h"
+
+#include <criterion/criterion.h>
+#include <pthread.h>
+#include <sched.h>
+
+Test(sa_frame_allocator, initialization) {
+	sa_frame_allocator allocator;
+	cr_assert_not(sa_frame_init(&allocator, 1, 64));
+	cr_assert_null(allocator.frames);
+
+	cr_assert(sa_frame_init(&allocator, 3, 64));
+	cr_assert_eq(allocator.epoch, 1);
+	cr_assert_eq((uintptr_t) allocator.frames % _Alignof(sa_frame), 0);
+	sa_stack_allocator *current = sa_frame_current(&allocator);
+	cr_assert_not_null(current);
+	cr_assert_eq(current->capacity, 64);
+
+	// Epoch 0 is published as an empty frame
+	uint64_t epoch = sa_frame_pin(&allocator);
+	cr_assert_eq(epoch, 0);
+	cr_assert_eq(sa_used_memory(sa_frame_get(&allocator, epoch)), 0);
+	sa_frame_unpin(&allocator, epoch);
+
+	sa_frame_release(&allocator);
+	cr_assert_null(allocator.frames);
+}
+
+Test(sa_frame_allocator, rotation) {
+	sa_frame_allocator allocator;
+	cr_assert(sa_frame_init(&allocator, 3, 64));
+
+	int *value = sa_alloc_(sa_frame_current(&allocator), int);
+	*value = 1;
+	cr_assert(sa_frame_advance(&allocator));
+	uint64_t epoch = sa_frame_pin(&allocator);
+	cr_assert_eq(epoch, 1);
+	cr_assert_eq(sa_frame_get(&allocator, epoch)->buffer, (void *) value);
+
+	// Writer keeps going while the reader lags behind
+	sa_stack_allocator *current = sa_frame_current(&allocator);
+	cr_assert_neq(current->buffer, (void *) value);
+	sa_alloc(current, 16);
+	cr_assert(sa_frame_advance(&allocator));
+	cr_assert_eq(*value, 1);
+
+	// Epoch 4 would reuse epoch 1's frame, so it waits for the reader
+	cr_assert_not(sa_frame_advance(&allocator));
+	cr_assert_null(sa_frame_current(&allocator));
+	cr_assert_not(sa_frame_advance(&allocator));
+	cr_assert_eq(*value, 1);
+	// New readers get the latest published frame meanwhile
+	uint64_t latest = sa_frame_pin(&allocator);
+	cr_assert_eq(latest, 3);
+	sa_frame_unpin(&allocator, latest);
+
+	sa_frame_unpin(&allocator, epoch);
+	cr_assert(sa_frame_advance(&allocator));
+	current = sa_frame_current(&allocator);
+	cr_assert_eq(current->buffer, (void *) value);
+	cr_assert_eq(sa_used_memory(current), 0);
+
+	sa_frame_release(&allocator);
+}
+
+#define FRAMES 4
+#define TICKS 20000
+#define READERS 3
+#define VALUES 16
+
+static sa_frame_allocator shared_allocator;
+static int writer_done;
+
+static void *reader_loop(void *arg) {
+	(void) arg;
+	uint64_t last_epoch = 0;
+	while(!__atomic_load_n(&writer_done, __ATOMIC_ACQUIRE)) {
+		uint64_t epoch = sa_frame_pin(&shared_allocator);
+		if(epoch < last_epoch) return (void *) 1;
+		last_epoch = epoch;
+		// Frames hold VALUES copies of their epoch, and must not change while pinned
+		sa_stack_allocator *frame = sa_frame_get(&shared_allocator, epoch);
+		size_t count = sa_used_memory(frame) / sizeof(uint64_t);
+		if(epoch > 0 && count != VALUES) return (void *) 1;
+		for(int repeat = 0; repeat < 4; repeat++) {
+			SA_FOREACH(uint64_t, value, frame) {
+				if(*value != epoch) return (void *) 1;
+			}
+			sched_yield();
+		}
+		sa_frame_unpin(&shared_allocator, epoch);
+	}
+	return NULL;
+}
+
+Test(sa_frame_allocator, concurrent_readers) {
+	cr_assert(sa_frame_init(&shared_allocator, FRAMES, VALUES * sizeof(uint64_t)));
+	pthread_t readers[READERS];
+	for(int i = 0; i < READERS; i++) {
+		pthread_create(&readers[i], NULL, reader_loop, NULL);
+	}
+
+	for(int tick = 0; tick < TICKS; tick++) {
+		sa_stack_allocator *frame = sa_frame_current(&shared_allocator);
+		uint64_t epoch = shared_allocator.epoch;
+		for(int i = 0; i < VALUES; i++) {
+			*sa_alloc_(frame, uint64_t) = epoch;
+		}
+		while(!sa_frame_advance(&shared_allocator)) {
+			sched_yield();
+		}
+	}
+	__atomic_store_n(&writer_done, 1, __ATOMIC_RELEASE);
+
+	for(int i = 0; i < READERS; i++) {
+		void *result;
+		pthread_join(readers[i], &result);
+		cr_assert_null(result);
+	}
+	sa_frame_release(&shared_allocator);
+}
@@ -0,0 +1,50 @@
+#define SA_INLINE
+#define SA_STATS
+#include "stack_allocator.h"
+#define DSA_INLINE
+#define DSA_STATS
+#include "double_stack_allocator.h"
+
+#include <criterion/criterion.h>
+
+Test(sa_inline, alloc_and_failure) {
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 16));
+
+	int *first = sa_alloc_(&allocator, int);
+	cr_assert_not_null(first);
+	*first = 42;
+	cr_assert_eq(sa_peek_(&allocator, int), first);
+	cr_assert_null(sa_alloc(&allocator, 16));
+	cr_assert_not_null(sa_alloc_aligned(&allocator, 4, 4));
+	cr_assert_null(sa_alloc_aligned(&allocator, 16, 4));
+
+	const sa_stats *stats = sa_get_stats(&allocator);
+	cr_assert_eq(stats->allocations, 2);
+	cr_assert_eq(stats->failed_allocations, 2);
+
+	int count = 0;
+	SA_FOREACH(int, number, &allocator) {
+		count++;
+	}
+	cr_assert_eq(count, 2);
+
+	sa_release(&allocator);
+}
+
+Test(dsa_inline, alloc_and_failure) {
+	dsa_double_stack_allocator allocator;
+	cr_assert(dsa_init_with_capacity(&allocator, 16));
+
+	cr_assert_not_null(dsa_alloc_bottom(&allocator, 8));
+	cr_assert_not_null(dsa_alloc_top(&allocator, 4));
+	cr_assert_null(dsa_alloc_bottom(&allocator, 8));
+	cr_assert_null(dsa_alloc_top(&allocator, 8));
+	cr_assert_eq(dsa_used_memory(&allocator), 12);
+
+	const dsa_stats *stats = dsa_get_stats(&allocator);
+	cr_assert_eq(stats->allocations, 2);
+	cr_assert_eq(stats->failed_allocations, 2);
+
+	dsa_release(&allocator);
+}
@@ -0,0 +1,369 @@
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define MAPPED_STACK_ALLOCATOR_IMPLEMENTATION
+#include "mapped_stack_allocator.h"
+
+#include <criterion/criterion.h>
+#include <errno.h>
+#include <stdio.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+typedef struct image_root {
+	uint32_t count;
+	sa_offset head;
+} image_root;
+
+typedef struct image_node {
+	int value;
+	sa_offset next;
+} image_node;
+
+static void temp_path(char *path, size_t size, const char *name) {
+	snprintf(path, size, "/tmp/test-mapped-%d-%s.img", (int) getpid(), name);
+}
+
+// Root is always the first allocation, followed by a list count-1 -> ... -> 0
+static void build_image(sa_stack_allocator *allocator, int count) {
+	cr_assert(sa_init_with_capacity(allocator, 1024));
+	image_root *root = sa_alloc_(allocator, image_root);
+	root->count = count;
+	root->head = SA_OFFSET_NULL;
+	for(int i = 0; i < count; i++) {
+		sa_offset offset = sa_alloc_offset_(allocator, image_node);
+		image_node *node = sa_offset_to_ptr_(allocator, image_node, offset);
+		node->value = i;
+		node->next = root->head;
+		root->head = offset;
+	}
+}
+
+static void check_image(sa_stack_allocator *allocator, int count) {
+	image_root *root = (image_root *) allocator->buffer;
+	cr_assert_eq(root->count, count);
+	int expected = count - 1;
+	for(image_node *node = sa_offset_to_ptr_(allocator, image_node, root->head); node; node = sa_offset_to_ptr_(allocator, image_node, node->next)) {
+		cr_assert_eq(node->value, expected);
+		expected--;
+	}
+	cr_assert_eq(expected, -1);
+}
+
+Test(sa_mapped_stack_allocator, save_and_map) {
+	char path[128];
+	temp_path(path, sizeof(path), "save");
+
+	sa_stack_allocator original;
+	build_image(&original, 10);
+	cr_assert(sa_save(&original, path));
+
+	sa_stack_allocator mapped;
+	cr_assert(sa_map(&mapped, path, SA_MAP_VERIFY, 0));
+	cr_assert_neq(mapped.buffer, original.buffer);
+	cr_assert_eq(sa_used_memory(&mapped), sa_used_memory(&original));
+	cr_assert_eq(sa_available_memory(&mapped), 0);
+	cr_assert_null(sa_alloc(&mapped, 1));
+	check_image(&mapped, 10);
+
+	sa_unmap(&mapped);
+	cr_assert_null(mapped.buffer);
+	sa_release(&original);
+	unlink(path);
+}
+
+Test(sa_mapped_stack_allocator, private_resumes_allocation) {
+	char path[128];
+	temp_path(path, sizeof(path), "private");
+
+	sa_stack_allocator original;
+	build_image(&original, 3);
+	size_t saved_marker = original.marker;
+	cr_assert(sa_save(&original, path));
+	sa_release(&original);
+
+	sa_stack_allocator mapped;
+	cr_assert(sa_map(&mapped, path, SA_MAP_PRIVATE, 4096));
+	cr_assert_eq(sa_get_marker(&mapped), saved_marker);
+	cr_assert_eq(sa_available_memory(&mapped), 4096);
+
+	// Continue the list after the saved allocations
+	image_root *root = (image_root *) mapped.buffer;
+	sa_offset offset = sa_alloc_offset_(&mapped, image_node);
+	cr_assert_neq(offset, SA_OFFSET_NULL);
+	image_node *node = sa_offset_to_ptr_(&mapped, image_node, offset);
+	node->value = 3;
+	node->next = root->head;
+	root->head = offset;
+	root->count++;
+	check_image(&mapped, 4);
+	sa_unmap(&mapped);
+
+	// Copy-on-write changes are not written back
+	cr_assert(sa_map(&mapped, path, SA_MAP_VERIFY, 0));
+	check_image(&mapped, 3);
+	sa_unmap(&mapped);
+	unlink(path);
+}
+
+Test(sa_mapped_stack_allocator, empty) {
+	char path[128];
+	temp_path(path, sizeof(path), "empty");
+
+	sa_stack_allocator original;
+	cr_assert(sa_init_with_capacity(&original, 16));
+	cr_assert(sa_save(&original, path));
+	sa_release(&original);
+
+	sa_stack_allocator mapped;
+	cr_assert(sa_map(&mapped, path, SA_MAP_VERIFY, 0));
+	cr_assert_eq(sa_used_memory(&mapped), 0);
+	sa_unmap(&mapped);
+	unlink(path);
+}
+
+Test(sa_mapped_stack_allocator, invalid_images) {
+	char path[128];
+	temp_path(path, sizeof(path), "invalid");
+	sa_stack_allocator mapped;
+
+	errno = 0;
+	cr_assert_not(sa_map(&mapped, path, 0, 0));
+	cr_assert_eq(errno, ENOENT);
+
+	FILE *file = fopen(path, "wb");
+	fputs("not an image", file);
+	fclose(file);
+	cr_assert_not(sa_map(&mapped, path, 0, 0));
+	cr_assert_eq(errno, EINVAL);
+
+	// Corrupt the saved memory after the header
+	sa_stack_allocator original;
+	build_image(&original, 2);
+	cr_assert(sa_save(&original, path));
+	sa_release(&original);
+	file = fopen(path, "r+b");
+	fseek(file, sizeof(sa_image_header), SEEK_SET);
+	fputc(0xFF, file);
+	fclose(file);
+	cr_assert(sa_map(&mapped, path, 0, 0));
+	sa_unmap(&mapped);
+	cr_assert_not(sa_map(&mapped, path, SA_MAP_VERIFY, 0));
+	cr_assert_eq(errno, EINVAL);
+
+	// Truncated image
+	cr_assert_eq(truncate(path, sizeof(sa_image_header) + 1), 0);
+	cr_assert_not(sa_map(&mapped, path, 0, 0));
+	cr_assert_eq(errno, EINVAL);
+	unlink(path);
+}
+
+#define SHARED_PROCESSES 4
+#define SHARED_RECORDS 1000
+
+typedef struct shared_record {
+	int process;
+	int index;
+	sa_offset previous;  // previous record of the same process
+} shared_record;
+
+static void append_records(sa_shared_allocator *allocator, int process, sa_offset *last) {
+	sa_offset previous = SA_OFFSET_NULL;
+	for(int i = 0; i < SHARED_RECORDS; i++) {
+		shared_record *record = sa_shared_alloc_(allocator, shared_record);
+		if(record == NULL) _exit(1);
+		record->process = process;
+		record->index = i;
+		record->previous = previous;
+		previous = sa_shared_ptr_to_offset(allocator, record);
+	}
+	last[process] = previous;
+}
+
+Test(sa_shared_allocator, fork_append) {
+	sa_shared_allocator allocator;
+	size_t capacity = (SHARED_PROCESSES * SHARED_RECORDS + 1) * sizeof(shared_record) + SHARED_PROCESSES * sizeof(sa_offset);
+	cr_assert(sa_shared_create(&allocator, NULL, capacity));
+	cr_assert_eq(sa_shared_available_memory(&allocator), capacity);
+	sa_offset *last = sa_shared_alloc_array_(&allocator, sa_offset, SHARED_PROCESSES);
+
+	pid_t children[SHARED_PROCESSES];
+	for(int p = 0; p < SHARED_PROCESSES; p++) {
+		children[p] = fork();
+		cr_assert_geq(children[p], 0);
+		if(children[p] == 0) {
+			append_records(&allocator, p, last);
+			_exit(0);
+		}
+	}
+	for(int p = 0; p < SHARED_PROCESSES; p++) {
+		int status;
+		cr_assert_eq(waitpid(children[p], &status, 0), children[p]);
+		cr_assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	}
+
+	// Every record was allocated exactly once, without overlaps
+	cr_assert_eq(sa_shared_used_memory(&allocator), SHARED_PROCESSES * sizeof(sa_offset) + SHARED_PROCESSES * SHARED_RECORDS * sizeof(shared_record));
+	for(int p = 0; p < SHARED_PROCESSES; p++) {
+		int expected = SHARED_RECORDS - 1;
+		for(shared_record *record = sa_shared_offset_to_ptr_(&allocator, shared_record, last[p]); record; record = sa_shared_offset_to_ptr_(&allocator, shared_record, record->previous)) {
+			cr_assert_eq(record->process, p);
+			cr_assert_eq(record->index, expected);
+			expected--;
+		}
+		cr_assert_eq(expected, -1);
+	}
+
+	// Full arena fails in every process
+	cr_assert_null(sa_shared_alloc(&allocator, sa_shared_available_memory(&allocator) + 1));
+	sa_shared_clear(&allocator);
+	cr_assert_eq(sa_shared_used_memory(&allocator), 0);
+	sa_shared_detach(&allocator);
+	cr_assert_null(allocator.header);
+}
+
+Test(sa_shared_allocator, offset_range) {
+	if(SIZE_MAX <= UINT32_MAX) return;
+	sa_shared_allocator allocator;
+	cr_assert_not(sa_shared_create(&allocator, NULL, SA_OFFSET_RANGE + 1));
+	cr_assert_eq(errno, EINVAL);
+}
+
+Test(sa_shared_allocator, alignment) {
+	sa_shared_allocator allocator;
+	cr_assert(sa_shared_create(&allocator, NULL, 8192));
+	cr_assert_not_null(sa_shared_alloc(&allocator, 1));
+	void *ptr = sa_shared_alloc_aligned(&allocator, 16, sizeof(sa_shared_header));
+	cr_assert_not_null(ptr);
+	cr_assert_eq((uintptr_t) ptr % sizeof(sa_shared_header), 0);
+
+	// The buffer itself is only aligned to its header size
+	cr_assert_null(sa_shared_alloc_aligned(&allocator, 16, 4096));
+	cr_assert_eq(sa_shared_used_memory(&allocator), sizeof(sa_shared_header) + 16);
+	sa_shared_detach(&allocator);
+}
+
+Test(sa_shared_allocator, attach_named) {
+	char name[64];
+	snprintf(name, sizeof(name), "/test-shared-%d", (int) getpid());
+
+	sa_shared_allocator creator, attached;
+	cr_assert(sa_shared_create(&creator, name, 256));
+	cr_assert_not(sa_shared_create(&attached, name, 256));
+	cr_assert_eq(errno, EEXIST);
+
+	cr_assert(sa_shared_attach(&attached, name));
+	cr_assert_eq(attached.capacity, 256);
+	int *value = sa_shared_alloc_(&creator, int);
+	*value = 42;
+	cr_assert_eq(sa_shared_used_memory(&attached), sizeof(int));
+	sa_offset offset = sa_shared_ptr_to_offset(&creator, value);
+	cr_assert_eq(*sa_shared_offset_to_ptr_(&attached, int, offset), 42);
+
+	// Allocations from either side advance the same marker
+	cr_assert_not_null(sa_shared_alloc_aligned(&attached, 16, 16));
+	cr_assert_eq(sa_shared_get_marker(&creator), 32);
+
+	sa_shared_detach(&attached);
+	cr_assert(sa_shared_unlink(name));
+	cr_assert_not(sa_shared_attach(&attached, name));
+	cr_assert_eq(errno, ENOENT);
+	sa_shared_detach(&creator);
+}
+
+Test(sa_shared_allocator, attach_fd) {
+	sa_shared_allocator creator, attached;
+	cr_assert(sa_shared_create(&creator, NULL, 64));
+	cr_assert(sa_shared_attach_fd(&attached, creator.fd));
+	cr_assert_neq(attached.fd, creator.fd);
+	cr_assert_not_null(sa_shared_alloc(&attached, 64));
+	cr_assert_null(sa_shared_alloc(&creator, 1));
+	sa_shared_detach(&attached);
+	sa_shared_detach(&creator);
+
+	// Memory not created by sa_shared_create
+	char path[128];
+	temp_path(path, sizeof(path), "not-shared");
+	FILE *file = fopen(path, "w+b");
+	fputs("this is not shared memory, but is long enough to hold a header.......", file);
+	fflush(file);
+	cr_assert_not(sa_shared_attach_fd(&attached, fileno(file)));
+	cr_assert_eq(errno, EINVAL);
+	fclose(file);
+	unlink(path);
+}
+
+Test(sa_file_backed, persist_and_resume) {
+	char path[128];
+	temp_path(path, sizeof(path), "file-backed");
+	unlink(path);
+
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_file_backed(&allocator, path, 4096));
+	cr_assert_eq(sa_used_memory(&allocator), 0);
+	cr_assert_eq(sa_available_memory(&allocator), 4096);
+	cr_assert(sa_advise_sequential(&allocator));
+	image_root *root = sa_alloc_(&allocator, image_root);
+	root->count = 0;
+	root->head = SA_OFFSET_NULL;
+	for(int i = 0; i < 5; i++) {
+		sa_offset offset = sa_alloc_offset_(&allocator, image_node);
+		image_node *node = sa_offset_to_ptr_(&allocator, image_node, offset);
+		node->value = i;
+		node->next = root->head;
+		root->head = offset;
+		root->count++;
+	}
+	size_t marker = sa_get_marker(&allocator);
+	cr_assert(sa_sync(&allocator));
+	// Allocations after the last sync are not persisted
+	cr_assert_not_null(sa_alloc(&allocator, 100));
+	cr_assert(sa_sync(&allocator));
+	sa_clear_marker(&allocator, marker);
+	cr_assert(sa_release_file_backed(&allocator));
+	cr_assert_null(allocator.buffer);
+
+	// Marker resumes at the persisted point, growing capacity
+	cr_assert(sa_init_file_backed(&allocator, path, 8192));
+	cr_assert_eq(sa_get_marker(&allocator), marker);
+	cr_assert_eq(allocator.capacity, 8192);
+	check_image(&allocator, 5);
+	cr_assert(sa_release_file_backed(&allocator));
+
+	// Smaller capacities keep the file's capacity
+	cr_assert(sa_init_file_backed(&allocator, path, 16));
+	cr_assert_eq(allocator.capacity, 8192);
+	cr_assert(sa_release_file_backed(&allocator));
+	unlink(path);
+}
+
+Test(sa_file_backed, sparse) {
+	char path[128];
+	temp_path(path, sizeof(path), "sparse");
+	unlink(path);
+
+	size_t capacity = (size_t) 1 << 30;
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_file_backed(&allocator, path, capacity));
+	memset(sa_alloc(&allocator, 4096), 1, 4096);
+	cr_assert(sa_release_file_backed(&allocator));
+
+	struct stat st;
+	cr_assert_eq(stat(path, &st), 0);
+	cr_assert_eq((size_t) st.st_size, SA_FILE_HEADER_SIZE + capacity);
+	cr_assert_lt((size_t) st.st_blocks * 512, (size_t) 1 << 20);
+	unlink(path);
+}
+
+Test(sa_file_backed, invalid_files) {
+	char path[128];
+	temp_path(path, sizeof(path), "not-file-backed");
+	FILE *file = fopen(path, "wb");
+	fputs("not a file-backed allocator, but long enough to hold a header", file);
+	fclose(file);
+
+	sa_stack_allocator allocator;
+	cr_assert_not(sa_init_file_backed(&allocator, path, 16));
+	cr_assert_eq(errno, EINVAL);
+	unlink(path);
+}
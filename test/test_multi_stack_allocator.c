@@ -0,0 +1,107 @@
+#define MULTI_STACK_ALLOCATOR_IMPLEMENTATION
+#include "multi_stack_allocator.h"
+
+#include <criterion/criterion.h>
+
+Test(msa_multi_stack_allocator, initialization) {
+	msa_multi_stack_allocator allocator;
+	cr_assert_not(msa_init_with_capacity(&allocator, 0, 1024));
+
+	cr_assert(msa_init_with_capacity(&allocator, 3, 1000));
+	cr_assert_eq(allocator.capacity, 992);
+	cr_assert_eq((uintptr_t) allocator.buffer % MSA_ALIGNMENT, 0);
+	for(size_t i = 0; i < 3; i++) {
+		cr_assert_eq(allocator.stacks[i].base % MSA_ALIGNMENT, 0);
+		cr_assert_eq(msa_used_memory(&allocator, i), 0);
+	}
+	cr_assert_eq(msa_available_memory(&allocator), 992);
+
+	msa_release(&allocator);
+	cr_assert_null(allocator.stacks);
+	cr_assert_eq(allocator.capacity, 0);
+}
+
+Test(msa_multi_stack_allocator, push_pop_peek) {
+	msa_multi_stack_allocator allocator;
+	cr_assert(msa_init_with_capacity(&allocator, 4, 256));
+
+	for(size_t i = 0; i < 4; i++) {
+		int *number = msa_alloc_aligned_(&allocator, i, int);
+		cr_assert_not_null(number);
+		*number = (int) i;
+	}
+	for(size_t i = 0; i < 4; i++) {
+		cr_assert_eq(*msa_peek_(&allocator, i, int), (int) i);
+		size_t marker = msa_get_marker(&allocator, i);
+		cr_assert_not_null(msa_alloc(&allocator, i, 3));
+		msa_clear_marker(&allocator, i, marker);
+		cr_assert_eq(msa_used_memory(&allocator, i), sizeof(int));
+		msa_pop_(&allocator, i, int);
+		cr_assert_null(msa_peek(&allocator, i, 1));
+		msa_pop(&allocator, i, 100);
+		cr_assert_eq(msa_used_memory(&allocator, i), 0);
+	}
+	cr_assert_eq(allocator.relocations, 0);
+
+	msa_release(&allocator);
+}
+
+Test(msa_multi_stack_allocator, redistribution) {
+	msa_multi_stack_allocator allocator;
+	cr_assert(msa_init_with_capacity(&allocator, 4, 1024));
+
+	// Every stack holds some data, referenced by offsets
+	msa_offset offsets[4];
+	for(size_t i = 0; i < 4; i++) {
+		offsets[i] = msa_alloc_offset_(&allocator, i, int);
+		cr_assert_neq(offsets[i], MSA_OFFSET_NULL);
+		*msa_offset_to_ptr_(&allocator, i, int, offsets[i]) = (int) i + 100;
+	}
+
+	// Stack 1 grows past its initial 256 bytes, up to the whole buffer
+	size_t pushed = 0;
+	while(msa_alloc(&allocator, 1, 8) != NULL) {
+		pushed += 8;
+	}
+	cr_assert_gt(allocator.relocations, 0);
+	cr_assert_gt(pushed, 900);
+	cr_assert_lt(msa_available_memory(&allocator), 8 + 4 * MSA_ALIGNMENT);
+	for(size_t i = 0; i < 4; i++) {
+		cr_assert_eq(*msa_offset_to_ptr_(&allocator, i, int, offsets[i]), (int) i + 100);
+		cr_assert_leq(allocator.stacks[i].top, allocator.stacks[i + 1].base);
+		cr_assert_eq(allocator.stacks[i].base % MSA_ALIGNMENT, 0);
+	}
+
+	// Freed memory is given to other stacks on the next redistribution
+	msa_clear(&allocator, 1);
+	for(int i = 0; i < 100; i++) {
+		int *number = msa_alloc_aligned_(&allocator, 3, int);
+		cr_assert_not_null(number);
+		*number = i;
+	}
+	cr_assert_eq(*msa_offset_to_ptr_(&allocator, 3, int, offsets[3]), 103);
+	cr_assert_eq(*msa_peek_(&allocator, 3, int), 99);
+	cr_assert_eq(*msa_offset_to_ptr_(&allocator, 0, int, offsets[0]), 100);
+	cr_assert_eq(*msa_offset_to_ptr_(&allocator, 2, int, offsets[2]), 102);
+
+	msa_release(&allocator);
+}
+
+Test(msa_multi_stack_allocator, alloc_aligned) {
+	msa_multi_stack_allocator allocator;
+	cr_assert(msa_init_with_capacity(&allocator, 2, 128));
+
+	cr_assert_not_null(msa_alloc(&allocator, 0, 1));
+	for(int i = 0; i < 6; i++) {
+		cr_assert_not_null(msa_alloc(&allocator, 1, 1));
+		void *ptr = msa_alloc_aligned(&allocator, 1, 8, 16);
+		cr_assert_not_null(ptr);
+		cr_assert_eq((uintptr_t) ptr % 16, 0);
+	}
+	cr_assert_gt(allocator.relocations, 0);
+	cr_assert_null(msa_alloc_aligned(&allocator, 1, 128, 16));
+	cr_assert_null(msa_alloc(&allocator, 0, SIZE_MAX));
+	cr_assert_null(msa_alloc_aligned(&allocator, 0, SIZE_MAX, 16));
+
+	msa_release(&allocator);
+}
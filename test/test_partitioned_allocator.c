@@ -0,0 +1,129 @@
+#define PARTITIONED_ALLOCATOR_IMPLEMENTATION
+#include "partitioned_allocator.h"
+
+#include <criterion/criterion.h>
+#include <pthread.h>
+
+Test(pa_partitioned_allocator, initialization) {
+	pa_partitioned_allocator allocator;
+	cr_assert_not(pa_init(&allocator, 1024, 0));
+
+	cr_assert(pa_init(&allocator, 1024, 3));
+	cr_assert_eq(allocator.pair_count, 2);
+	cr_assert_eq(allocator.worker_count, 3);
+	cr_assert(allocator.steal);
+	for(size_t i = 0; i < allocator.pair_count; i++) {
+		cr_assert_eq((uintptr_t) &allocator.pairs[i] % PA_CACHE_LINE, 0);
+		cr_assert_eq((uintptr_t) allocator.pairs[i].buffer % PA_CACHE_LINE, 0);
+		cr_assert_eq(allocator.pairs[i].capacity, 512);
+	}
+	cr_assert_eq(pa_available_memory(&allocator), 1024);
+	cr_assert_eq(pa_used_memory(&allocator), 0);
+
+	pa_release(&allocator);
+	cr_assert_null(allocator.pairs);
+}
+
+Test(pa_partitioned_allocator, pairs_share_regions) {
+	pa_partitioned_allocator allocator;
+	cr_assert(pa_init(&allocator, 256, 4));
+	allocator.steal = 0;
+	pa_pair *pair = &allocator.pairs[0];
+
+	// Even workers allocate from the bottom, odd workers from the top
+	uint8_t *bottom = pa_alloc(&allocator, 0, 16);
+	cr_assert_eq(bottom, pair->buffer);
+	uint8_t *top = pa_alloc(&allocator, 1, 16);
+	cr_assert_eq(top, pair->buffer + pair->capacity - 16);
+
+	// Worker 0 uses its sibling's unused capacity
+	cr_assert_not_null(pa_alloc(&allocator, 0, 96));
+	cr_assert_null(pa_alloc(&allocator, 0, 1));
+	cr_assert_null(pa_alloc(&allocator, 1, 1));
+	cr_assert_null(pa_alloc(&allocator, 1, SIZE_MAX));
+	cr_assert_eq(pa_used_memory(&allocator), 128);
+	cr_assert_eq(pa_available_memory(&allocator), 128);
+
+	pa_clear(&allocator);
+	cr_assert_eq(pa_used_memory(&allocator), 0);
+	pa_release(&allocator);
+}
+
+Test(pa_partitioned_allocator, steal) {
+	pa_partitioned_allocator allocator;
+	cr_assert(pa_init(&allocator, 256, 4));
+
+	cr_assert_not_null(pa_alloc(&allocator, 0, 128));
+	uint8_t *stolen = pa_alloc(&allocator, 1, 64);
+	cr_assert_not_null(stolen);
+	cr_assert_eq(stolen, allocator.pairs[1].buffer + 64);
+	cr_assert_eq(allocator.steal_count, 1);
+	cr_assert_not_null(pa_alloc(&allocator, 0, 64));
+	cr_assert_null(pa_alloc(&allocator, 3, 1));
+	cr_assert_eq(pa_available_memory(&allocator), 0);
+
+	pa_clear(&allocator);
+	cr_assert_eq(allocator.steal_count, 0);
+	pa_release(&allocator);
+}
+
+Test(pa_partitioned_allocator, aligned) {
+	pa_partitioned_allocator allocator;
+	cr_assert(pa_init(&allocator, 256, 2));
+
+	cr_assert_not_null(pa_alloc(&allocator, 0, 1));
+	cr_assert_not_null(pa_alloc(&allocator, 1, 1));
+	double *bottom = pa_alloc_(&allocator, 0, double);
+	double *top = pa_alloc_(&allocator, 1, double);
+	cr_assert_eq((uintptr_t) bottom % PA_ALIGNOF(double), 0);
+	cr_assert_eq((uintptr_t) top % PA_ALIGNOF(double), 0);
+	cr_assert_eq((uint8_t *) bottom, allocator.pairs[0].buffer + 8);
+	cr_assert_eq((uint8_t *) top, allocator.pairs[0].buffer + 256 - 16);
+	cr_assert_null(pa_alloc_aligned(&allocator, 0, SIZE_MAX - 1, 2));
+	pa_release(&allocator);
+}
+
+#define WORKERS 8
+#define ALLOCATIONS 10000
+
+typedef struct block {
+	uint32_t worker;
+	uint32_t index;
+} block;
+
+static pa_partitioned_allocator shared_allocator;
+
+static void *worker_loop(void *arg) {
+	size_t worker = (size_t) (uintptr_t) arg;
+	// Worker 0 allocates as much as all other workers together
+	size_t allocations = worker == 0 ? ALLOCATIONS * (WORKERS - 1) : ALLOCATIONS;
+	block **blocks = malloc(allocations * sizeof(block *));
+	for(size_t i = 0; i < allocations; i++) {
+		blocks[i] = pa_alloc_(&shared_allocator, worker, block);
+		if(blocks[i] == NULL) return (void *) 1;
+		blocks[i]->worker = worker;
+		blocks[i]->index = i;
+	}
+	for(size_t i = 0; i < allocations; i++) {
+		if(blocks[i]->worker != worker || blocks[i]->index != i) return (void *) 1;
+	}
+	free(blocks);
+	return NULL;
+}
+
+Test(pa_partitioned_allocator, concurrent_skewed) {
+	size_t total = 2 * ALLOCATIONS * (WORKERS - 1) * sizeof(block);
+	cr_assert(pa_init(&shared_allocator, total + WORKERS * PA_CACHE_LINE, WORKERS));
+	pthread_t threads[WORKERS];
+	for(uintptr_t i = 0; i < WORKERS; i++) {
+		pthread_create(&threads[i], NULL, worker_loop, (void *) i);
+	}
+	for(int i = 0; i < WORKERS; i++) {
+		void *result;
+		pthread_join(threads[i], &result);
+		cr_assert_null(result);
+	}
+	cr_assert_eq(pa_used_memory(&shared_allocator), total);
+	cr_assert_gt(shared_allocator.steal_count, 0);
+	pa_release(&shared_allocator);
+}
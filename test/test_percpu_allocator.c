@@ -0,0 +1,118 @@
+#define _GNU_SOURCE
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define PERCPU_ALLOCATOR_IMPLEMENTATION
+#include "percpu_allocator.h"
+
+#include <criterion/criterion.h>
+#include <pthread.h>
+
+Test(sa_percpu_allocator, initialization) {
+	sa_percpu_allocator allocator;
+	cr_assert(sa_percpu_init(&allocator, 64));
+	cr_assert_geq(allocator.slice_count, 1);
+	cr_assert_eq(allocator.use_rseq, sa_percpu_rseq_available());
+	for(size_t i = 0; i < allocator.slice_count; i++) {
+		cr_assert_eq((uintptr_t) &allocator.slices[i] % 64, 0);
+		cr_assert_eq(allocator.slices[i].stack.capacity, 64);
+		cr_assert_eq((uintptr_t) allocator.slices[i].stack.buffer % 16, 0);
+	}
+	cr_assert_eq(sa_percpu_used_memory(&allocator), 0);
+
+	sa_percpu_release(&allocator);
+	cr_assert_null(allocator.slices);
+	cr_assert_eq(allocator.slice_count, 0);
+}
+
+Test(sa_percpu_allocator, slice_alignment) {
+	sa_percpu_allocator allocator;
+	cr_assert(sa_percpu_init(&allocator, 7));
+	for(size_t i = 0; i < allocator.slice_count; i++) {
+		cr_assert_eq(allocator.slices[i].stack.capacity, 16);
+		cr_assert_eq((uintptr_t) allocator.slices[i].stack.buffer % 16, 0);
+	}
+	double *value = sa_percpu_alloc_(&allocator, double);
+	cr_assert_not_null(value);
+	cr_assert_eq((uintptr_t) value % SA_PERCPU_ALIGNOF(double), 0);
+	sa_percpu_release(&allocator);
+}
+
+static void check_alloc_until_full(sa_percpu_allocator *allocator) {
+	// Slice of the current CPU, assuming the thread is not migrated meanwhile
+	uint8_t *first = sa_percpu_alloc(allocator, 16);
+	cr_assert_not_null(first);
+	cr_assert_eq(sa_percpu_used_memory(allocator), 16);
+	cr_assert_null(sa_percpu_alloc(allocator, SIZE_MAX));
+	cr_assert_null(sa_percpu_alloc(allocator, 1024));
+
+	sa_percpu_clear(allocator);
+	cr_assert_eq(sa_percpu_used_memory(allocator), 0);
+}
+
+Test(sa_percpu_allocator, alloc) {
+	sa_percpu_allocator allocator;
+	cr_assert(sa_percpu_init(&allocator, 64));
+	check_alloc_until_full(&allocator);
+	sa_percpu_release(&allocator);
+}
+
+Test(sa_percpu_allocator, alloc_atomic) {
+	sa_percpu_allocator allocator;
+	cr_assert(sa_percpu_init(&allocator, 64));
+	allocator.use_rseq = 0;
+	check_alloc_until_full(&allocator);
+	sa_percpu_release(&allocator);
+}
+
+#define THREADS 16
+#define ALLOCATIONS 20000
+
+typedef struct block {
+	uint64_t thread;
+	uint64_t index;
+} block;
+
+static sa_percpu_allocator shared_allocator;
+
+static void *alloc_loop(void *arg) {
+	uint64_t thread = (uint64_t) (uintptr_t) arg;
+	block **blocks = malloc(ALLOCATIONS * sizeof(block *));
+	for(uint64_t i = 0; i < ALLOCATIONS; i++) {
+		blocks[i] = sa_percpu_alloc_(&shared_allocator, block);
+		if(blocks[i] == NULL) return (void *) 1;
+		blocks[i]->thread = thread;
+		blocks[i]->index = i;
+		if(i % 1000 == 0) sched_yield();
+	}
+	// No other thread was given the same memory
+	for(uint64_t i = 0; i < ALLOCATIONS; i++) {
+		if(blocks[i]->thread != thread || blocks[i]->index != i) return (void *) 1;
+	}
+	free(blocks);
+	return NULL;
+}
+
+static void check_concurrent(int use_rseq) {
+	// Every thread may run on the same CPU
+	cr_assert(sa_percpu_init(&shared_allocator, THREADS * ALLOCATIONS * sizeof(block)));
+	shared_allocator.use_rseq = use_rseq;
+	pthread_t threads[THREADS];
+	for(uintptr_t i = 0; i < THREADS; i++) {
+		pthread_create(&threads[i], NULL, alloc_loop, (void *) i);
+	}
+	for(int i = 0; i < THREADS; i++) {
+		void *result;
+		pthread_join(threads[i], &result);
+		cr_assert_null(result);
+	}
+	cr_assert_eq(sa_percpu_used_memory(&shared_allocator), THREADS * ALLOCATIONS * sizeof(block));
+	sa_percpu_release(&shared_allocator);
+}
+
+Test(sa_percpu_allocator, concurrent) {
+	check_concurrent(sa_percpu_rseq_available());
+}
+
+Test(sa_percpu_allocator, concurrent_atomic) {
+	check_concurrent(0);
+}
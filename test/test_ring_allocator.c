@@ -0,0 +1,142 @@
+#define RING_ALLOCATOR_IMPLEMENTATION
+#include "ring_allocator.h"
+
+#include <criterion/criterion.h>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+Test(ra_ring_allocator, initialization) {
+	size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+	ra_ring_allocator allocator;
+	cr_assert(ra_init_with_capacity(&allocator, 1));
+	cr_assert_eq(allocator.capacity, page_size);
+	ra_release(&allocator);
+	cr_assert_null(allocator.buffer);
+
+	cr_assert(ra_init_with_capacity(&allocator, 3 * page_size));
+	cr_assert_eq(allocator.capacity, 4 * page_size);
+	cr_assert_eq(ra_available_memory(&allocator), 4 * page_size);
+	cr_assert_eq(ra_used_memory(&allocator), 0);
+	ra_release(&allocator);
+
+	cr_assert_not(ra_init_with_capacity(&allocator, SIZE_MAX));
+	cr_assert_eq(allocator.capacity, 0);
+}
+
+Test(ra_ring_allocator, fifo) {
+	ra_ring_allocator allocator;
+	cr_assert(ra_init_with_capacity(&allocator, 1));
+	size_t capacity = allocator.capacity;
+	cr_assert_null(ra_peek(&allocator, NULL));
+
+	uint8_t *first = ra_alloc(&allocator, 100);
+	uint8_t *second = ra_alloc(&allocator, capacity - 100);
+	cr_assert_eq(first, allocator.buffer);
+	cr_assert_eq(second, first + 100);
+	cr_assert_null(ra_alloc(&allocator, 1));
+	cr_assert_null(ra_alloc(&allocator, SIZE_MAX));
+	cr_assert_eq(ra_available_memory(&allocator), 0);
+
+	// Oldest memory is freed first
+	size_t used;
+	cr_assert_eq(ra_peek(&allocator, &used), first);
+	cr_assert_eq(used, capacity);
+	ra_free(&allocator, 100);
+	cr_assert_eq(ra_peek(&allocator, NULL), second);
+	cr_assert_eq(ra_available_memory(&allocator), 100);
+
+	ra_free(&allocator, SIZE_MAX);
+	cr_assert_eq(ra_used_memory(&allocator), 0);
+	ra_clear(&allocator);
+	cr_assert_eq(allocator.head, 0);
+	ra_release(&allocator);
+}
+
+Test(ra_ring_allocator, wraparound_is_contiguous) {
+	ra_ring_allocator allocator;
+	cr_assert(ra_init_with_capacity(&allocator, 1));
+	size_t capacity = allocator.capacity;
+
+	ra_alloc(&allocator, capacity - 10);
+	ra_free(&allocator, capacity - 10);
+	uint8_t *block = ra_alloc(&allocator, 100);
+	cr_assert_eq(block, allocator.buffer + capacity - 10);
+	for(int i = 0; i < 100; i++) {
+		block[i] = (uint8_t) i;
+	}
+	// Bytes past the end of the buffer are its start
+	cr_assert_eq(allocator.buffer[0], 10);
+	cr_assert_eq(allocator.buffer[89], 99);
+
+	ra_free(&allocator, 100);
+	cr_assert_eq(ra_alloc(&allocator, 8), allocator.buffer + 90);
+	ra_release(&allocator);
+}
+
+Test(ra_ring_allocator, aligned) {
+	ra_ring_allocator allocator;
+	cr_assert(ra_init_with_capacity(&allocator, 1));
+
+	cr_assert_not_null(ra_alloc(&allocator, 3));
+	double *value = ra_alloc_(&allocator, double);
+	cr_assert_eq((uintptr_t) value % RA_ALIGNOF(double), 0);
+	*value = 1.5;
+	cr_assert_eq(ra_used_memory(&allocator), 16);
+
+	ra_free(&allocator, 3);
+	cr_assert_eq(ra_peek_(&allocator, double), value);
+	ra_free_(&allocator, double);
+	cr_assert_eq(ra_used_memory(&allocator), 0);
+	cr_assert_null(ra_peek_(&allocator, double));
+
+	// Padding counts towards used memory
+	cr_assert_not_null(ra_alloc(&allocator, 1));
+	cr_assert_null(ra_alloc_aligned(&allocator, allocator.capacity - 8, 16));
+	cr_assert_null(ra_alloc_aligned(&allocator, SIZE_MAX - 1, 2));
+	ra_release(&allocator);
+}
+
+#define SPSC_MESSAGES 100000
+
+static void *spsc_producer(void *arg) {
+	ra_ring_allocator *allocator = (ra_ring_allocator *) arg;
+	for(uint32_t i = 0; i < SPSC_MESSAGES; i++) {
+		// Messages of 1 to 16 words, prefixed by their length
+		uint32_t length = 1 + i % 16;
+		uint32_t *message;
+		while((message = ra_spsc_reserve(allocator, (length + 1) * sizeof(uint32_t))) == NULL) {
+			sched_yield();
+		}
+		message[0] = length;
+		for(uint32_t j = 1; j <= length; j++) {
+			message[j] = i;
+		}
+		ra_spsc_commit(allocator, (length + 1) * sizeof(uint32_t));
+	}
+	return NULL;
+}
+
+Test(ra_ring_allocator, spsc) {
+	ra_ring_allocator allocator;
+	cr_assert(ra_init_with_capacity(&allocator, 1));
+
+	pthread_t producer;
+	pthread_create(&producer, NULL, spsc_producer, &allocator);
+	for(uint32_t i = 0; i < SPSC_MESSAGES; i++) {
+		uint32_t *message;
+		size_t size;
+		while((message = ra_spsc_peek(&allocator, &size)) == NULL) {
+			sched_yield();
+		}
+		cr_assert_geq(size, (message[0] + 1) * sizeof(uint32_t));
+		cr_assert_eq(message[0], 1 + i % 16);
+		for(uint32_t j = 1; j <= message[0]; j++) {
+			cr_assert_eq(message[j], i);
+		}
+		ra_spsc_free(&allocator, (message[0] + 1) * sizeof(uint32_t));
+	}
+	pthread_join(producer, NULL);
+	cr_assert_eq(ra_used_memory(&allocator), 0);
+	ra_release(&allocator);
+}
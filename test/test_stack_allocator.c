@@ -2,6 +2,7 @@
 #include "stack_allocator.h"
 
 #include <criterion/criterion.h>
+#include <string.h>
 
 Test(sa_stack_allocator, initialization) {
 	size_t capacity = 16;
@@ -168,3 +169,147 @@ Test(sa_stack_allocator, foreach) {
     }
     cr_assert_eq(i, 0);
 }
+
+Test(sa_stack_allocator, alloc_aligned) {
+	size_t capacity = 64;
+
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, capacity));
+
+	cr_assert_not_null(sa_alloc(&allocator, 1));
+
+	void *ptr = sa_alloc_aligned(&allocator, 8, 16);
+	cr_assert_not_null(ptr);
+	cr_assert_eq((uintptr_t) ptr % 16, 0);
+	cr_assert_eq(sa_peek(&allocator, 8), ptr);
+
+	double *number = sa_alloc_aligned_(&allocator, double);
+	cr_assert_not_null(number);
+	cr_assert_eq((uintptr_t) number % _Alignof(double), 0);
+
+	cr_assert_null(sa_alloc_aligned(&allocator, capacity, 1));
+
+	sa_release(&allocator);
+}
+
+Test(sa_stack_allocator, huge_sizes) {
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 16));
+	cr_assert_not_null(sa_alloc(&allocator, 1));
+
+	cr_assert_null(sa_alloc(&allocator, SIZE_MAX));
+	cr_assert_null(sa_alloc_aligned(&allocator, SIZE_MAX, 16));
+	cr_assert_null(sa_alloc_aligned(&allocator, SIZE_MAX - 1, 2));
+	cr_assert_eq(sa_used_memory(&allocator), 1);
+
+	sa_release(&allocator);
+}
+
+typedef struct offset_node {
+	int value;
+	sa_offset next;
+} offset_node;
+
+Test(sa_stack_allocator, offsets) {
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity_(&allocator, offset_node, 8));
+
+	cr_assert_eq(sa_ptr_to_offset(&allocator, NULL), SA_OFFSET_NULL);
+	cr_assert_null(sa_offset_to_ptr(&allocator, SA_OFFSET_NULL));
+
+	// Build a list 0 -> 1 -> ... -> 7 linked by offsets
+	sa_offset head = SA_OFFSET_NULL;
+	for(int i = 7; i >= 0; i--) {
+		sa_offset offset = sa_alloc_offset_(&allocator, offset_node);
+		cr_assert_neq(offset, SA_OFFSET_NULL);
+		offset_node *node = sa_offset_to_ptr_(&allocator, offset_node, offset);
+		cr_assert_eq(sa_ptr_to_offset(&allocator, node), offset);
+		node->value = i;
+		node->next = head;
+		head = offset;
+	}
+	cr_assert_eq(sa_alloc_offset(&allocator, 1), SA_OFFSET_NULL);
+
+	// Offsets stay valid in a copy of the buffer
+	void *copy = malloc(allocator.capacity);
+	memcpy(copy, allocator.buffer, allocator.marker);
+	sa_stack_allocator moved = sa_new(copy, allocator.capacity);
+	moved.marker = allocator.marker;
+	sa_release(&allocator);
+
+	int expected = 0;
+	for(offset_node *node = sa_offset_to_ptr_(&moved, offset_node, head); node; node = sa_offset_to_ptr_(&moved, offset_node, node->next)) {
+		cr_assert_eq(node->value, expected++);
+	}
+	cr_assert_eq(expected, 8);
+
+	sa_release(&moved);
+}
+
+Test(sa_stack_allocator, offset_range) {
+	if(SIZE_MAX <= UINT32_MAX) return;
+	// Only addresses are computed, so a small buffer can pose as a huge one
+	static uint8_t buffer[16];
+	sa_stack_allocator allocator = sa_new(buffer, SA_OFFSET_RANGE + 16);
+	allocator.marker = SA_OFFSET_RANGE - 1;
+
+	sa_offset last = sa_alloc_offset(&allocator, 1);
+	cr_assert_eq(last, UINT32_MAX);
+	cr_assert_eq(sa_offset_to_ptr(&allocator, last), buffer + SA_OFFSET_RANGE - 1);
+	cr_assert_eq(sa_alloc_offset(&allocator, 1), SA_OFFSET_NULL);
+	cr_assert_eq(sa_alloc_offset_(&allocator, offset_node), SA_OFFSET_NULL);
+	cr_assert_eq(sa_used_memory(&allocator), SA_OFFSET_RANGE);
+	cr_assert_eq(sa_ptr_to_offset(&allocator, buffer + SA_OFFSET_RANGE), SA_OFFSET_NULL);
+}
+
+Test(sa_stack_allocator, child) {
+	sa_stack_allocator parent;
+	cr_assert(sa_init_with_capacity(&parent, 64));
+	cr_assert_not_null(sa_alloc(&parent, 8));
+
+	sa_stack_allocator child;
+	cr_assert_not(sa_child_begin(&parent, &child, 57));
+	cr_assert_eq(child.capacity, 0);
+	cr_assert(sa_child_begin(&parent, &child, 32));
+	cr_assert_eq(child.buffer, (uint8_t *) parent.buffer + 8);
+	cr_assert_eq(sa_available_memory(&parent), 24);
+
+	// Child of child
+	sa_stack_allocator grandchild;
+	cr_assert_not_null(sa_alloc(&child, 4));
+	cr_assert(sa_child_begin(&child, &grandchild, 16));
+	cr_assert_not_null(sa_alloc(&grandchild, 16));
+	cr_assert_null(sa_alloc(&grandchild, 1));
+	sa_child_end(&child, &grandchild);
+	cr_assert_eq(grandchild.capacity, 0);
+	cr_assert_eq(sa_used_memory(&child), 4);
+
+	sa_child_end(&parent, &child);
+	cr_assert_eq(child.capacity, 0);
+	cr_assert_eq(sa_used_memory(&parent), 8);
+
+	sa_release(&parent);
+}
+
+Test(sa_stack_allocator, child_commit) {
+	sa_stack_allocator parent;
+	cr_assert(sa_init_with_capacity(&parent, 64));
+	cr_assert_not_null(sa_alloc(&parent, 8));
+
+	sa_stack_allocator child;
+	cr_assert(sa_child_begin(&parent, &child, 48));
+	int *numbers = (int *) sa_alloc(&child, 3 * sizeof(int));
+	cr_assert_not_null(numbers);
+	numbers[0] = 1; numbers[1] = 2; numbers[2] = 3;
+	sa_child_commit(&parent, &child);
+	cr_assert_eq(child.capacity, 0);
+	cr_assert_eq(sa_used_memory(&parent), 8 + 3 * sizeof(int));
+	cr_assert_eq(sa_peek(&parent, 3 * sizeof(int)), numbers);
+	cr_assert_eq(numbers[2], 3);
+
+	// Committed memory is freed like any other parent allocation
+	sa_pop(&parent, 3 * sizeof(int));
+	cr_assert_eq(sa_used_memory(&parent), 8);
+
+	sa_release(&parent);
+}
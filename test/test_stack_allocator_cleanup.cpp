@@ -0,0 +1,186 @@
+#define SA_CLEANUP
+#define STACK_ALLOCATOR_IMPLEMENTATION
+#include "stack_allocator.h"
+#define DOUBLE_STACK_ALLOCATOR_IMPLEMENTATION
+#include "double_stack_allocator.h"
+
+#include <criterion/criterion.h>
+
+static int calls[8];
+static int call_count;
+
+static void record_call(void *ctx) {
+	calls[call_count++] = (int) (intptr_t) ctx;
+}
+
+struct counted {
+	int *destroyed;
+	explicit counted(int *destroyed) : destroyed(destroyed) {}
+	~counted() { (*destroyed)++; }
+};
+
+struct plain {
+	int x, y;
+};
+
+Test(sa_cleanup, clear_marker_lifo) {
+	call_count = 0;
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 256));
+
+	cr_assert(sa_push_cleanup(&allocator, record_call, (void *) 1));
+	size_t marker = sa_get_marker(&allocator);
+	cr_assert(sa_push_cleanup(&allocator, record_call, (void *) 2));
+	cr_assert(sa_push_cleanup(&allocator, record_call, (void *) 3));
+
+	sa_clear_marker(&allocator, marker);
+	cr_assert_eq(call_count, 2);
+	cr_assert_eq(calls[0], 3);
+	cr_assert_eq(calls[1], 2);
+
+	sa_clear(&allocator);
+	cr_assert_eq(call_count, 3);
+	cr_assert_eq(calls[2], 1);
+
+	sa_clear(&allocator);
+	cr_assert_eq(call_count, 3);
+
+	sa_release(&allocator);
+}
+
+Test(sa_cleanup, pop_and_release) {
+	call_count = 0;
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 256));
+
+	cr_assert(sa_push_cleanup(&allocator, record_call, (void *) 1));
+	cr_assert_not_null(sa_alloc(&allocator, 4));
+	cr_assert(sa_push_cleanup(&allocator, record_call, (void *) 2));
+
+	sa_pop(&allocator, 1);
+	cr_assert_eq(call_count, 1);
+	cr_assert_eq(calls[0], 2);
+
+	sa_release(&allocator);
+	cr_assert_eq(call_count, 2);
+	cr_assert_eq(calls[1], 1);
+}
+
+Test(sa_cleanup, out_of_memory) {
+	call_count = 0;
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, sizeof(sa_cleanup) - 1));
+
+	cr_assert_not(sa_push_cleanup(&allocator, record_call, NULL));
+	cr_assert_null(allocator.cleanup);
+
+	sa_release(&allocator);
+	cr_assert_eq(call_count, 0);
+}
+
+Test(sa_cleanup, child) {
+	call_count = 0;
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 256));
+	cr_assert(sa_push_cleanup(&allocator, record_call, (void *) 1));
+
+	sa_stack_allocator child;
+	cr_assert(sa_child_begin(&allocator, &child, 64));
+	cr_assert(sa_push_cleanup(&child, record_call, (void *) 2));
+	sa_child_end(&allocator, &child);
+	cr_assert_eq(call_count, 1);
+	cr_assert_eq(calls[0], 2);
+
+	// Committed entries join the parent's, running after newer parent entries
+	cr_assert(sa_child_begin(&allocator, &child, 128));
+	cr_assert(sa_push_cleanup(&child, record_call, (void *) 3));
+	cr_assert(sa_push_cleanup(&child, record_call, (void *) 4));
+	sa_child_commit(&allocator, &child);
+	cr_assert(sa_push_cleanup(&allocator, record_call, (void *) 5));
+	cr_assert_eq(call_count, 1);
+
+	sa_release(&allocator);
+	cr_assert_eq(call_count, 5);
+	cr_assert_eq(calls[1], 5);
+	cr_assert_eq(calls[2], 4);
+	cr_assert_eq(calls[3], 3);
+	cr_assert_eq(calls[4], 1);
+}
+
+Test(sa_cleanup, double_stack_child) {
+	call_count = 0;
+	dsa_double_stack_allocator allocator;
+	cr_assert(dsa_init_with_capacity(&allocator, 256));
+
+	sa_stack_allocator child;
+	cr_assert(dsa_child_begin_bottom(&allocator, &child, 64));
+	cr_assert(sa_push_cleanup(&child, record_call, (void *) 1));
+	dsa_child_end_bottom(&allocator, &child);
+	cr_assert_eq(call_count, 1);
+	cr_assert_eq(calls[0], 1);
+	cr_assert_eq(dsa_used_memory(&allocator), 0);
+
+	cr_assert(dsa_child_begin_top(&allocator, &child, 64));
+	cr_assert(sa_push_cleanup(&child, record_call, (void *) 2));
+	cr_assert(sa_push_cleanup(&child, record_call, (void *) 3));
+	dsa_child_end_top(&allocator, &child);
+	cr_assert_eq(call_count, 3);
+	cr_assert_eq(calls[1], 3);
+	cr_assert_eq(calls[2], 2);
+	cr_assert_eq(dsa_used_memory(&allocator), 0);
+
+	// Children with cleanup entries can't be committed, and are left intact
+	cr_assert(dsa_child_begin_bottom(&allocator, &child, 64));
+	cr_assert(sa_push_cleanup(&child, record_call, (void *) 4));
+	cr_assert_null(dsa_child_commit_bottom(&allocator, &child));
+	cr_assert_not_null(child.cleanup);
+	dsa_child_end_bottom(&allocator, &child);
+	cr_assert_eq(call_count, 4);
+
+	cr_assert(dsa_child_begin_top(&allocator, &child, 64));
+	cr_assert(sa_push_cleanup(&child, record_call, (void *) 5));
+	cr_assert_null(dsa_child_commit_top(&allocator, &child));
+	cr_assert_not_null(child.cleanup);
+	dsa_child_end_top(&allocator, &child);
+	cr_assert_eq(call_count, 5);
+	cr_assert_eq(dsa_used_memory(&allocator), 0);
+
+	dsa_release(&allocator);
+}
+
+Test(sa_cleanup, make) {
+	int destroyed = 0;
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, 256));
+
+	plain *p = sa::make<plain>(&allocator, plain{ 1, 2 });
+	cr_assert_not_null(p);
+	cr_assert_eq(p->y, 2);
+	cr_assert_null(allocator.cleanup);
+	cr_assert_eq(sa_used_memory(&allocator), sizeof(plain));
+
+	size_t marker = sa_get_marker(&allocator);
+	counted *c = sa::make<counted>(&allocator, &destroyed);
+	cr_assert_not_null(c);
+	cr_assert_not_null(allocator.cleanup);
+
+	sa_clear_marker(&allocator, marker);
+	cr_assert_eq(destroyed, 1);
+
+	cr_assert_not_null(sa::make<counted>(&allocator, &destroyed));
+	sa_release(&allocator);
+	cr_assert_eq(destroyed, 2);
+}
+
+Test(sa_cleanup, make_out_of_memory) {
+	int destroyed = 0;
+	sa_stack_allocator allocator;
+	cr_assert(sa_init_with_capacity(&allocator, sizeof(counted)));
+
+	cr_assert_null(sa::make<counted>(&allocator, &destroyed));
+	cr_assert_eq(destroyed, 1);
+	cr_assert_eq(sa_used_memory(&allocator), 0);
+
+	sa_release(&allocator);
+	cr_assert_eq(destroyed, 1);
+}
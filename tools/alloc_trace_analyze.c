@@ -0,0 +1,266 @@
+/**
+ * alloc_trace_analyze -- Replay allocation traces recorded with alloc_trace.h
+ *
+ * Usage: alloc_trace_analyze TRACE_FILE
+ *
+ * For each traced allocator, reports peak memory usage, failed allocations,
+ * allocation lifetimes and a recommended capacity.
+ */
+#include "alloc_trace.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LIFETIME_BUCKETS 64
+
+typedef struct live_allocation {
+    uint64_t offset;     // Used memory before the allocation
+    uint64_t timestamp;
+} live_allocation;
+
+// One end of a traced allocator, Stack Allocators only have the bottom one.
+typedef struct stack_end {
+    uint64_t used;
+    uint64_t peak;
+    live_allocation *live;
+    size_t live_count;
+    size_t live_capacity;
+} stack_end;
+
+typedef struct traced_allocator {
+    uint64_t address;
+    int is_double;
+    stack_end ends[2];
+    uint64_t peak;               // Highest usage of both ends combined
+    uint64_t allocations;
+    uint64_t failed_allocations;
+    uint64_t demand;             // Highest usage that would satisfy failed allocations
+    uint64_t lifetimes;
+    uint64_t lifetime_total;
+    uint64_t lifetime_max;
+    uint64_t lifetime_histogram[LIFETIME_BUCKETS];
+} traced_allocator;
+
+// Open addressing hash map from allocator address to its live entry in `allocators`
+typedef struct address_slot {
+    uint64_t address;
+    int occupied;
+    size_t index;        // Index in `allocators` plus one, 0 if the allocator was released
+} address_slot;
+
+static traced_allocator *allocators;
+static size_t allocator_count;
+static size_t allocator_capacity;
+static address_slot *slots;
+static size_t slot_count;       // Always a power of two
+static size_t slots_used;
+
+static size_t hash_address(uint64_t address) {
+    address ^= address >> 33;
+    address *= 0xff51afd7ed558ccdull;
+    address ^= address >> 33;
+    return (size_t) address;
+}
+
+static address_slot *find_slot(uint64_t address) {
+    size_t mask = slot_count - 1;
+    size_t i = hash_address(address) & mask;
+    while(slots[i].occupied && slots[i].address != address) {
+        i = (i + 1) & mask;
+    }
+    return &slots[i];
+}
+
+static void grow_slots(void) {
+    address_slot *old_slots = slots;
+    size_t old_count = slot_count;
+    slot_count = slot_count ? slot_count * 2 : 64;
+    slots = calloc(slot_count, sizeof(address_slot));
+    if(slots == NULL) {
+        perror("calloc");
+        exit(EXIT_FAILURE);
+    }
+    for(size_t i = 0; i < old_count; i++) {
+        if(old_slots[i].occupied) {
+            *find_slot(old_slots[i].address) = old_slots[i];
+        }
+    }
+    free(old_slots);
+}
+
+static traced_allocator *find_allocator(uint64_t address, int is_double) {
+    if(slots_used * 2 >= slot_count) grow_slots();
+    address_slot *slot = find_slot(address);
+    if(slot->index != 0) return &allocators[slot->index - 1];
+
+    // New allocator, or one whose address was reused after being released
+    if(allocator_count == allocator_capacity) {
+        allocator_capacity = allocator_capacity ? allocator_capacity * 2 : 16;
+        allocators = realloc(allocators, allocator_capacity * sizeof(traced_allocator));
+        if(allocators == NULL) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    if(!slot->occupied) {
+        slot->occupied = 1;
+        slot->address = address;
+        slots_used++;
+    }
+    slot->index = ++allocator_count;
+    traced_allocator *allocator = &allocators[allocator_count - 1];
+    memset(allocator, 0, sizeof(traced_allocator));
+    allocator->address = address;
+    allocator->is_double = is_double;
+    return allocator;
+}
+
+static void release_allocator(uint64_t address) {
+    address_slot *slot = find_slot(address);
+    slot->index = 0;
+}
+
+static void push_live(stack_end *end, uint64_t offset, uint64_t timestamp) {
+    if(end->live_count == end->live_capacity) {
+        end->live_capacity = end->live_capacity ? end->live_capacity * 2 : 64;
+        end->live = realloc(end->live, end->live_capacity * sizeof(live_allocation));
+        if(end->live == NULL) {
+            perror("realloc");
+            exit(EXIT_FAILURE);
+        }
+    }
+    end->live[end->live_count++] = (live_allocation){ offset, timestamp };
+}
+
+static void record_lifetime(traced_allocator *allocator, uint64_t lifetime) {
+    size_t bucket = 0;
+    for(uint64_t t = lifetime; t > 0 && bucket < LIFETIME_BUCKETS - 1; t >>= 1) bucket++;
+    allocator->lifetimes++;
+    allocator->lifetime_total += lifetime;
+    allocator->lifetime_histogram[bucket]++;
+    if(lifetime > allocator->lifetime_max) allocator->lifetime_max = lifetime;
+}
+
+static void update_used(traced_allocator *allocator, stack_end *end, uint64_t used, uint64_t timestamp) {
+    // Allocations that started at or above the new usage are now freed
+    while(end->live_count > 0 && end->live[end->live_count - 1].offset >= used) {
+        end->live_count--;
+        record_lifetime(allocator, timestamp - end->live[end->live_count].timestamp);
+    }
+    end->used = used;
+    if(used > end->peak) end->peak = used;
+    uint64_t total = allocator->ends[0].used + allocator->ends[1].used;
+    if(total > allocator->peak) allocator->peak = total;
+}
+
+static void replay(const at_record *record) {
+    int is_double = record->op >= AT_DSA_ALLOC_BOTTOM;
+    traced_allocator *allocator = find_allocator(record->allocator, is_double);
+    if(record->op == AT_SA_RELEASE || record->op == AT_DSA_RELEASE) {
+        // Everything is freed and later records with the same address belong to a new allocator
+        update_used(allocator, &allocator->ends[0], 0, record->timestamp);
+        update_used(allocator, &allocator->ends[1], 0, record->timestamp);
+        release_allocator(record->allocator);
+        return;
+    }
+    int top = record->op == AT_DSA_ALLOC_TOP || record->op == AT_DSA_ALLOC_TOP_FAILED
+           || record->op == AT_DSA_POP_TOP || record->op == AT_DSA_CLEAR_TOP_MARKER;
+    stack_end *end = &allocator->ends[top];
+    switch(record->op) {
+        case AT_SA_ALLOC:
+        case AT_DSA_ALLOC_BOTTOM:
+        case AT_DSA_ALLOC_TOP:
+            allocator->allocations++;
+            update_used(allocator, end, record->marker - record->size, record->timestamp);
+            push_live(end, record->marker - record->size, record->timestamp);
+            update_used(allocator, end, record->marker, record->timestamp);
+            break;
+
+        case AT_SA_ALLOC_FAILED:
+        case AT_DSA_ALLOC_BOTTOM_FAILED:
+        case AT_DSA_ALLOC_TOP_FAILED: {
+            allocator->failed_allocations++;
+            uint64_t other = allocator->ends[!top].used;
+            uint64_t demand = record->marker + record->size + other;
+            if(demand > allocator->demand) allocator->demand = demand;
+            break;
+        }
+
+        default:
+            update_used(allocator, end, record->marker, record->timestamp);
+            break;
+    }
+}
+
+static uint64_t recommended_capacity(const traced_allocator *allocator) {
+    uint64_t needed = allocator->demand > allocator->peak ? allocator->demand : allocator->peak;
+    // 25% headroom, rounded up to 4 KiB
+    needed += needed / 4;
+    return (needed + 4095) / 4096 * 4096;
+}
+
+static void report(const traced_allocator *allocator, double ticks_per_us) {
+    printf("%s 0x%llx\n", allocator->is_double ? "dsa_double_stack_allocator" : "sa_stack_allocator",
+           (unsigned long long) allocator->address);
+    printf("  allocations:          %llu (%llu failed)\n",
+           (unsigned long long) allocator->allocations, (unsigned long long) allocator->failed_allocations);
+    if(allocator->is_double) {
+        printf("  peak usage:           %llu bytes (bottom %llu, top %llu)\n",
+               (unsigned long long) allocator->peak,
+               (unsigned long long) allocator->ends[0].peak, (unsigned long long) allocator->ends[1].peak);
+    }
+    else {
+        printf("  peak usage:           %llu bytes\n", (unsigned long long) allocator->peak);
+    }
+    if(allocator->failed_allocations > 0) {
+        printf("  peak demand:          %llu bytes\n", (unsigned long long) allocator->demand);
+    }
+    if(allocator->lifetimes > 0) {
+        printf("  lifetime mean:        %.3f us\n", allocator->lifetime_total / (double) allocator->lifetimes / ticks_per_us);
+        printf("  lifetime max:         %.3f us\n", allocator->lifetime_max / ticks_per_us);
+        printf("  lifetime histogram:\n");
+        for(size_t i = 0; i < LIFETIME_BUCKETS; i++) {
+            if(allocator->lifetime_histogram[i] == 0) continue;
+            double upper = ((i < 63 ? (1ull << i) : ~0ull)) / ticks_per_us;
+            printf("    < %12.3f us: %llu\n", upper, (unsigned long long) allocator->lifetime_histogram[i]);
+        }
+    }
+    printf("  recommended capacity: %llu bytes\n\n", (unsigned long long) recommended_capacity(allocator));
+}
+
+int main(int argc, char **argv) {
+    if(argc != 2) {
+        fprintf(stderr, "Usage: %s TRACE_FILE\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    FILE *file = fopen(argv[1], "rb");
+    if(file == NULL) {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    at_file_header header;
+    if(fread(&header, sizeof(header), 1, file) != 1
+       || memcmp(header.magic, AT_MAGIC, sizeof(AT_MAGIC)) != 0
+       || header.version != AT_VERSION
+       || header.record_size != sizeof(at_record)) {
+        fprintf(stderr, "%s: not a version %d allocation trace\n", argv[1], AT_VERSION);
+        return EXIT_FAILURE;
+    }
+
+    at_record record;
+    size_t record_count = 0;
+    while(fread(&record, sizeof(record), 1, file) == 1) {
+        replay(&record);
+        record_count++;
+    }
+    fclose(file);
+
+    double ticks_per_us = header.ticks_per_second ? header.ticks_per_second / 1e6 : 1;
+    printf("%zu records, %zu allocators\n\n", record_count, allocator_count);
+    for(size_t i = 0; i < allocator_count; i++) {
+        report(&allocators[i], ticks_per_us);
+    }
+    return EXIT_SUCCESS;
+}